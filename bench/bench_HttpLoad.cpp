@@ -0,0 +1,211 @@
+/**
+ * @file bench_HttpLoad.cpp
+ * @brief HTTP load generator for the dashboard endpoints, with a synthetic fleet served in-process
+ * @date October 2026
+ */
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Poco/Exception.h>
+#include <Poco/Net/HTTPClientSession.h>
+#include <Poco/Net/HTTPRequest.h>
+#include <Poco/Net/HTTPResponse.h>
+#include "fleet/FleetPublisher.h"
+#include "web/WebServer.h"
+
+/**
+ * @struct ConnectionResult
+ * @brief What one keep-alive connection measured
+ */
+struct ConnectionResult {
+    std::vector<uint32_t> latenciesUs;  ///< Latency of every successful request
+    uint64_t bytes = 0;                 ///< Response body bytes received
+    uint64_t errors = 0;                ///< Failed requests and non-200 responses
+};
+
+/**
+ * @brief Send requests one after another over a keep-alive connection until the deadline
+ * @param host Server host
+ * @param port Server port
+ * @param path Request URI
+ * @param gzip Whether to ask for gzip responses
+ * @param deadline When to stop
+ * @param result Receives the measurements
+ */
+void runConnection(const std::string& host, int port, const std::string& path, bool gzip,
+                   std::chrono::steady_clock::time_point deadline, ConnectionResult& result) {
+    Poco::Net::HTTPClientSession session(host, static_cast<Poco::UInt16>(port));
+    session.setKeepAlive(true);
+    session.setTimeout(Poco::Timespan(10, 0));
+    Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, path, Poco::Net::HTTPMessage::HTTP_1_1);
+    request.setKeepAlive(true);
+    if (gzip) {
+        request.set("Accept-Encoding", "gzip");
+    }
+    result.latenciesUs.reserve(1 << 20);
+
+    char buffer[16384];
+    for (auto start = std::chrono::steady_clock::now(); start < deadline; start = std::chrono::steady_clock::now()) {
+        try {
+            session.sendRequest(request);
+            Poco::Net::HTTPResponse response;
+            std::istream& body = session.receiveResponse(response);
+            while (body.read(buffer, sizeof(buffer)) || body.gcount() > 0) {
+                result.bytes += static_cast<uint64_t>(body.gcount());
+            }
+            if (response.getStatus() != Poco::Net::HTTPResponse::HTTP_OK) {
+                ++result.errors;
+                continue;
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            result.latenciesUs.push_back(static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+        } catch (const Poco::Exception&) {
+            // The next request opens a new connection
+            ++result.errors;
+            session.reset();
+        }
+    }
+}
+
+/**
+ * @brief Latency below which a fraction of the sorted latencies fall
+ * @param sorted Latencies in ascending order, not empty
+ * @param fraction Fraction between 0 and 1
+ * @return The latency in microseconds
+ */
+uint32_t percentile(const std::vector<uint32_t>& sorted, double fraction) {
+    std::size_t index = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size()));
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+int main(int argc, char* argv[]) {
+    int bikes = 10000;
+    int connections = 8;
+    int seconds = 10;
+    int updatesPerSecond = 0;
+    int port = 18080;
+    bool gzip = false;
+    std::string path = "/ebikes";
+    std::string host;
+    WebServerConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--bikes" && i + 1 < argc) {
+            bikes = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--connections" && i + 1 < argc) {
+            connections = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            seconds = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--updates" && i + 1 < argc) {
+            updatesPerSecond = std::max(0, std::stoi(argv[++i]));
+        } else if (arg == "--path" && i + 1 < argc) {
+            path = argv[++i];
+        } else if (arg == "--gzip") {
+            gzip = true;
+        } else if (arg == "--http-threads" && i + 1 < argc) {
+            config.maxThreads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = std::stoi(argv[++i]);
+        } else if (arg == "--target" && i + 1 < argc) {
+            std::string target = argv[++i];
+            std::size_t colon = target.rfind(':');
+            host = target.substr(0, colon);
+            port = colon == std::string::npos ? 8080 : std::stoi(target.substr(colon + 1));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--bikes N] [--connections N] [--seconds S] [--updates N]"
+                      << " [--path URI] [--gzip] [--http-threads N] [--port N] [--target HOST:PORT]" << std::endl;
+            return 1;
+        }
+    }
+
+    // A fleet spread over a 30 km square around Bristol, published the way the gateway does
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int32_t> latitude(51320000, 51590000);
+    std::uniform_int_distribution<int32_t> longitude(-2800000, -2370000);
+    FleetStore store;
+    FleetPublisher publisher(std::chrono::milliseconds(100));
+    for (int id = 1; id <= bikes; ++id) {
+        TelemetryReading reading;
+        reading.ebikeId = id;
+        reading.latitudeE6 = latitude(random);
+        reading.longitudeE6 = longitude(random);
+        reading.timestampMs = 1739359594000;
+        store.update(reading);
+    }
+    publisher.publish(store);
+
+    // Without a target the synthetic fleet is served in-process
+    std::unique_ptr<WebServer> server;
+    if (host.empty()) {
+        host = "127.0.0.1";
+        server = std::make_unique<WebServer>(publisher, config);
+        server->start(port);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+
+    // Moves random e-bikes at the given rate, so responses are re-serialised as the fleet changes
+    std::thread mover;
+    if (server && updatesPerSecond > 0) {
+        mover = std::thread([&] {
+            std::uniform_int_distribution<int> bike(1, bikes);
+            int64_t timestampMs = 1739359594000;
+            while (std::chrono::steady_clock::now() < deadline) {
+                for (int i = 0; i < std::max(1, updatesPerSecond / 100); ++i) {
+                    TelemetryReading reading;
+                    reading.ebikeId = bike(random);
+                    reading.latitudeE6 = latitude(random);
+                    reading.longitudeE6 = longitude(random);
+                    reading.timestampMs = ++timestampMs;
+                    store.update(reading);
+                }
+                publisher.publishIfDue(store);
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        });
+    }
+
+    std::vector<ConnectionResult> results(static_cast<std::size_t>(connections));
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (auto& result : results) {
+        threads.emplace_back(runConnection, std::cref(host), port, std::cref(path), gzip, deadline, std::ref(result));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (mover.joinable()) {
+        mover.join();
+    }
+
+    std::vector<uint32_t> latencies;
+    uint64_t bytes = 0, errors = 0;
+    int served = 0;
+    for (const auto& result : results) {
+        served += result.latenciesUs.empty() ? 0 : 1;
+        latencies.insert(latencies.end(), result.latenciesUs.begin(), result.latenciesUs.end());
+        bytes += result.bytes;
+        errors += result.errors;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << (server ? std::to_string(bikes) + " e-bikes, " : "") << connections << " keep-alive connections to "
+              << host << ":" << port << path << (gzip ? " (gzip)" : "") << " for " << elapsed << " s" << std::endl;
+    std::cout << latencies.size() << " requests (" << errors << " errors), " << latencies.size() / elapsed << " req/s, "
+              << bytes / elapsed / 1e6 << " MB/s" << std::endl;
+    // Connections beyond the server's threads wait for a kept-alive one to close, so they may get nothing
+    std::cout << served << " of " << connections << " connections served" << std::endl;
+    if (!latencies.empty()) {
+        std::cout << "Latency: p50 " << percentile(latencies, 0.50) << " us, p99 " << percentile(latencies, 0.99)
+                  << " us, p999 " << percentile(latencies, 0.999) << " us, max " << latencies.back() << " us" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file bench_NearestBikes.cpp
+ * @brief Micro-benchmark of the grid nearest-bike query against a linear scan
+ * @date October 2026
+ */
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "fleet/FleetPublisher.h"
+#include "fleet/Geodesy.h"
+
+/**
+ * @brief Find the k closest e-bikes by computing the distance to every one of them
+ * @param snapshot The fleet
+ * @param latitudeE6 Query latitude in microdegrees
+ * @param longitudeE6 Query longitude in microdegrees
+ * @param k Number of e-bikes to find
+ * @param status Status the e-bikes must have
+ * @param nearest Receives the e-bikes, closest first
+ */
+void linearScan(const FleetSnapshot& snapshot, int32_t latitudeE6, int32_t longitudeE6, std::size_t k,
+                EBikeStatus status, std::vector<NearbyBike>& nearest) {
+    nearest.clear();
+    auto closer = [](const NearbyBike& a, const NearbyBike& b) { return a.distanceMeters < b.distanceMeters; };
+    for (std::size_t slot = 0; slot < snapshot.size(); ++slot) {
+        if (snapshot.statuses()[slot] != status) {
+            continue;
+        }
+        double distance = geodesy::distanceMeters(latitudeE6, longitudeE6,
+                                                  snapshot.latitudes()[slot], snapshot.longitudes()[slot]);
+        if (nearest.size() < k) {
+            nearest.push_back({slot, distance});
+            std::push_heap(nearest.begin(), nearest.end(), closer);
+        } else if (distance < nearest.front().distanceMeters) {
+            std::pop_heap(nearest.begin(), nearest.end(), closer);
+            nearest.back() = {slot, distance};
+            std::push_heap(nearest.begin(), nearest.end(), closer);
+        }
+    }
+    std::sort_heap(nearest.begin(), nearest.end(), closer);
+}
+
+/**
+ * @brief Time a query function over a set of positions
+ * @param name Label printed with the result
+ * @param queries Positions to query, cycled through
+ * @param iterations Number of queries in total
+ * @param query The query function under test
+ */
+template <typename Query>
+void run(const char* name, const std::vector<std::pair<int32_t, int32_t>>& queries, int iterations, Query query) {
+    std::vector<NearbyBike> nearest;
+    double farthest = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        const auto& position = queries[i % queries.size()];
+        query(position.first, position.second, nearest);
+        farthest += nearest.empty() ? 0.0 : nearest.back().distanceMeters;
+    }
+    auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << name << ": " << elapsed / iterations << " us/query"
+              << " (mean k-th distance " << farthest / iterations << " m)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int bikes = argc > 1 ? std::stoi(argv[1]) : 100000;
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 2000;
+    const std::size_t shards = 4;
+    const std::size_t k = 10;
+
+    // A fleet spread over a 30 km square around Bristol, one in four bikes locked
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int32_t> latitude(51320000, 51590000);
+    std::uniform_int_distribution<int32_t> longitude(-2800000, -2370000);
+    std::vector<FleetStore> stores(shards);
+    FleetPublisher publisher(std::chrono::milliseconds(0), shards);
+    for (int id = 1; id <= bikes; ++id) {
+        TelemetryReading reading;
+        reading.ebikeId = id;
+        reading.latitudeE6 = latitude(random);
+        reading.longitudeE6 = longitude(random);
+        reading.timestampMs = 1739359594000;
+        stores[id % shards].update(reading);
+        if (id % 4 == 0) {
+            stores[id % shards].setStatus(id, EBikeStatus::Locked);
+        }
+    }
+    for (std::size_t shard = 0; shard < shards; ++shard) {
+        publisher.publish(shard, stores[shard]);
+    }
+    std::shared_ptr<const FleetSnapshot> snapshot = publisher.current();
+
+    std::vector<std::pair<int32_t, int32_t>> queries;
+    for (int i = 0; i < 1000; ++i) {
+        queries.emplace_back(latitude(random), longitude(random));
+    }
+
+    std::cout << bikes << " e-bikes, " << k << " nearest unlocked" << std::endl;
+    run("Linear scan", queries, iterations, [&](int32_t lat, int32_t lon, std::vector<NearbyBike>& nearest) {
+        linearScan(*snapshot, lat, lon, k, EBikeStatus::Unlocked, nearest);
+    });
+    run("Grid rings ", queries, iterations * 100, [&](int32_t lat, int32_t lon, std::vector<NearbyBike>& nearest) {
+        snapshot->nearest(lat, lon, k, EBikeStatus::Unlocked, nearest);
+    });
+    return 0;
+}
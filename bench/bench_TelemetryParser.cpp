@@ -0,0 +1,55 @@
+/**
+ * @file bench_TelemetryParser.cpp
+ * @brief Micro-benchmark of the telemetry parser against the Poco JSON path
+ * @date October 2026
+ */
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "MessageHandler.h"
+#include "proto/TelemetryParser.h"
+
+/**
+ * @brief Time a parse function over a set of messages
+ * @param name Label printed with the result
+ * @param messages Messages to parse, cycled through
+ * @param iterations Number of messages to parse in total
+ * @param parse The parse function under test
+ */
+template <typename Parse>
+void run(const char* name, const std::vector<std::string>& messages, int iterations, Parse parse) {
+    int64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        TelemetryReading reading = parse(messages[i % messages.size()]);
+        checksum += reading.ebikeId + reading.latitudeE6;
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << name << ": " << elapsed / iterations << " ns/message"
+              << " (checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::stoi(argv[1]) : 1000000;
+
+    // Messages as produced by ebikeClient
+    std::vector<std::string> messages;
+    for (int id = 1; id <= 64; ++id) {
+        messages.push_back("{\"ebike_id\":" + std::to_string(id)
+                           + ",\"timestamp\":\"2025-02-12T11:26:34Z\",\"gps\":{\"latitude\":51.4590"
+                           + std::to_string(id % 10) + "9,\"longitude\":-2.58292" + std::to_string(id % 10) + "}}");
+    }
+
+    run("Poco JSON parser", messages, iterations, [](const std::string& message) {
+        return MessageHandler::parseWithPoco(message);
+    });
+    run("TelemetryParser ", messages, iterations, [](const std::string& message) {
+        TelemetryReading reading;
+        TelemetryParser::parse(message, reading);
+        return reading;
+    });
+    return 0;
+}
@@ -58,9 +58,30 @@
      */
      // Update the format method in GPSSensor.h to produce JSON
     std::string format(std::vector<uint8_t> reading) override {
+        double lat = 0.0;
+        double lon = 0.0;
+        if (!parse(reading, lat, lon)) {
+            return "{}"; // Empty JSON object for missing or invalid data
+        }
+        
+        // Format as JSON
+        std::stringstream jsonSS;
+        jsonSS << "{\"latitude\":" << std::fixed << std::setprecision(6) << lat 
+            << ",\"longitude\":" << std::fixed << std::setprecision(6) << lon << "}";
+        return jsonSS.str();
+    }
+ 
+    /**
+     * @brief Extract latitude and longitude from the raw byte vector
+     * @param reading The vector of bytes containing GPS data
+     * @param lat Receives the latitude in degrees
+     * @param lon Receives the longitude in degrees
+     * @return true if both coordinates could be parsed
+     */
+    bool parse(const std::vector<uint8_t>& reading, double& lat, double& lon) const {
         // Check if we have data
         if (reading.empty()) {
-            return "{}"; // Empty JSON object if no data
+            return false;
         }
         
         // Convert the byte vector to a string
@@ -71,7 +92,7 @@
         if (negSignPos == std::string::npos) {
             // Debug output to help diagnose the issue
             std::cerr << "Debug - Raw data: " << dataStr << std::endl;
-            return "{}"; // Empty JSON object for invalid data
+            return false;
         }
         
         // Extract latitude and longitude as strings
@@ -79,19 +100,14 @@
         std::string lonStr = dataStr.substr(negSignPos);
         
         try {
-            // Parse latitude and longitude to double for proper JSON formatting
-            double lat = std::stod(latStr);
-            double lon = std::stod(lonStr);
-            
-            // Format as JSON
-            std::stringstream jsonSS;
-            jsonSS << "{\"latitude\":" << std::fixed << std::setprecision(6) << lat 
-                << ",\"longitude\":" << std::fixed << std::setprecision(6) << lon << "}";
-            return jsonSS.str();
+            // Parse latitude and longitude to double
+            lat = std::stod(latStr);
+            lon = std::stod(lonStr);
+            return true;
         }
         catch (const std::exception& e) {
             std::cerr << "Error parsing GPS coordinates: " << e.what() << std::endl;
-            return "{}";
+            return false;
         }
     }
  };
@@ -9,117 +9,240 @@
  
  #include <Poco/JSON/Parser.h>
  #include <Poco/JSON/Object.h>
- #include <Poco/JSON/Array.h>
  #include <Poco/Dynamic/Var.h>
  #include <string>
- #include <iostream>
+ #include <string_view>
  #include <chrono>
- #include <ctime>
- #include <sstream>
- #include <iomanip>
+ #include <cstdint>
+ #include <stdexcept>
+ #include "fleet/FleetStore.h"
+ #include "fleet/FleetPublisher.h"
+ #include "fleet/Telemetry.h"
+ #include "proto/TelemetryParser.h"
+ #include "proto/TelemetryFrame.h"
+ #include "proto/AckTracker.h"
+ #include "util/AsyncLog.h"
+ #include "util/Metrics.h"
+ #include "util/LatencyHistogram.h"
  
  /**
   * @class MessageHandler
-  * @brief Handles incoming messages from eBike clients and converts them to GeoJSON
+  * @brief Handles incoming messages from eBike clients and updates the fleet store
   * 
-  * This class is responsible for parsing JSON messages from eBike clients,
-  * converting them to GeoJSON format, and adding them to the shared ebikes array.
+  * This class is responsible for decoding JSON or binary messages from
+  * eBike clients and recording the position they carry in its fleet store. The store
+  * holds one shard of the fleet and is private to the ingest worker owning
+  * that shard; HTTP threads see it through the snapshots published by
+  * publishIfDue().
   */
  class MessageHandler {
  public:
      /**
       * @brief Constructor for MessageHandler
-      * @param ebikes Reference to the shared array of e-bikes in GeoJSON format
+      * @param publisher Publisher that makes the fleet visible to HTTP threads
+      * @param shard The shard of the fleet this handler's store holds
+      * @param historyPoints Positions kept per eBike in the store's track history
       */
-     MessageHandler(Poco::JSON::Array::Ptr& ebikes) : _ebikes(ebikes) {}
+     MessageHandler(FleetPublisher& publisher, std::size_t shard = 0, std::size_t historyPoints = TrackHistory::DefaultPoints)
+         : _store(historyPoints, publisher.firstVersion()), _publisher(publisher), _shard(shard) {}
+ 
+     // Preformatted responses to JSON messages and to malformed frames
+     static constexpr std::string_view ResponseOk = "OK";
+     static constexpr std::string_view ResponseInvalidMessage = "ERROR: Invalid telemetry message";
+     static constexpr std::string_view ResponseMalformedFrame = "ERROR: Malformed binary telemetry frame";
  
      /**
-      * @brief Get the current time as a formatted string
-      * @return String with current timestamp in ISO format
+      * @brief Decode a telemetry message with the general Poco JSON parser
+      * @param message The message received from the client
+      * @return The decoded reading
+      * @throws std::exception if the message is not valid telemetry
       */
-     std::string getCurrentTimeISO() {
-         auto now = std::chrono::system_clock::now();
-         std::time_t time = std::chrono::system_clock::to_time_t(now);
+     static TelemetryReading parseWithPoco(std::string_view message) {
+         Poco::JSON::Parser parser;
+         Poco::Dynamic::Var result = parser.parse(std::string(message));
+         Poco::JSON::Object::Ptr json = result.extract<Poco::JSON::Object::Ptr>();
          
-         std::stringstream ss;
-         ss << std::put_time(std::gmtime(&time), "%Y-%m-%dT%H:%M:%SZ");
-         return ss.str();
+         // Extract the data
+         TelemetryReading reading;
+         reading.ebikeId = json->getValue<int>("ebike_id");
+         std::string timestamp = json->getValue<std::string>("timestamp");
+         if (!TelemetryParser::parseTimestamp(timestamp, reading.timestampMs)) {
+             throw std::invalid_argument("Invalid timestamp: " + timestamp);
+         }
+         Poco::JSON::Object::Ptr gpsData = json->getObject("gps");
+         double latitude = gpsData->getValue<double>("latitude");
+         double longitude = gpsData->getValue<double>("longitude");
+         if (!(latitude >= -90.0 && latitude <= 90.0) || !(longitude >= -180.0 && longitude <= 180.0)) {
+             throw std::invalid_argument("Position out of range");
+         }
+         reading.latitudeE6 = toMicrodegrees(latitude);
+         reading.longitudeE6 = toMicrodegrees(longitude);
+         return reading;
+     }
+ 
+     /**
+      * @brief Pick the shard that owns the eBike a message is about
+      * 
+      * Only the e-bike ID is looked at; messages without a recognisable
+      * ID go to shard 0, whose handler reports them as errors.
+      * 
+      * @param message The message received from the client
+      * @param shards Number of shards
+      * @return The shard index
+      */
+     static std::size_t shardOf(std::string_view message, std::size_t shards) {
+         int ebikeId = 0;
+         bool found = TelemetryFrame::isFrame(message)
+             ? TelemetryFrame::peekEbikeId(message, ebikeId)
+             : TelemetryParser::peekEbikeId(message, ebikeId);
+         return found ? static_cast<uint32_t>(ebikeId) % shards : 0;
      }
  
      /**
       * @brief Handle incoming message from eBike client
+      * 
+      * Nothing is allocated once every eBike has reported: the response is
+      * one of the preformatted constants below, or an acknowledgment frame
+      * encoded into the caller's buffer.
+      * 
       * @param message The message received from the client
       * @param sourceIp The source IP address of the client
       * @param sourcePort The source port of the client
-      * @return Response message to send back to the client
+      * @param ackBuffer Space for an acknowledgment frame, at least TelemetryFrame::AckSize bytes
+      * @return Response message to send back to the client, valid while ackBuffer is
       */
-     std::string handleMessage(const std::string& message, const std::string& sourceIp, int sourcePort) {
-         try {
-             // Parse the JSON message
-             Poco::JSON::Parser parser;
-             Poco::Dynamic::Var result = parser.parse(message);
-             Poco::JSON::Object::Ptr json = result.extract<Poco::JSON::Object::Ptr>();
-             
-             // Extract the data
-             int ebikeId = json->getValue<int>("ebike_id");
-             std::string timestamp = json->getValue<std::string>("timestamp");
-             Poco::JSON::Object::Ptr gpsData = json->getObject("gps");
-             double latitude = gpsData->getValue<double>("latitude");
-             double longitude = gpsData->getValue<double>("longitude");
-             
-             // Create GeoJSON feature
-             Poco::JSON::Object::Ptr geoJson = new Poco::JSON::Object;
-             geoJson->set("type", "Feature");
-             
-             // Set geometry
-             Poco::JSON::Object::Ptr geometry = new Poco::JSON::Object;
-             geometry->set("type", "Point");
-             Poco::JSON::Array::Ptr coordinates = new Poco::JSON::Array;
-             coordinates->add(longitude); // GeoJSON uses [lon, lat] order
-             coordinates->add(latitude);
-             geometry->set("coordinates", coordinates);
-             geoJson->set("geometry", geometry);
-             
-             // Set properties
-             Poco::JSON::Object::Ptr properties = new Poco::JSON::Object;
-             properties->set("id", ebikeId);
-             properties->set("timestamp", timestamp);
-             properties->set("status", "unlocked"); // Default status
-             geoJson->set("properties", properties);
-             
-             // Check if this ebike already exists in the array
-             bool found = false;
-             for (size_t i = 0; i < _ebikes->size(); i++) {
-                 Poco::JSON::Object::Ptr existingFeature = _ebikes->getObject(i);
-                 Poco::JSON::Object::Ptr existingProps = existingFeature->getObject("properties");
-                 if (existingProps->getValue<int>("id") == ebikeId) {
-                     // Update existing feature
-                     _ebikes->set(i, geoJson);
-                     found = true;
-                     break;
-                 }
+     std::string_view handleMessage(std::string_view message, std::string_view sourceIp, int sourcePort, uint8_t* ackBuffer) {
+         TelemetryReading reading;
+         uint64_t startNs = StageLatencies::nowNs();
+         if (TelemetryFrame::isFrame(message)) {
+             // Binary frame, either a single reading or a batch applied in one go
+             std::size_t count = 0;
+             uint64_t storeNs = 0;
+             AckTracker::State ack;
+             if (TelemetryFrame::type(message) == TelemetryFrame::TypeBatch) {
+                 // Entries are applied as they are decoded, so the time spent in the store is taken out
+                 count = TelemetryFrame::decodeBatch(message, [this, &reading, &ack, &storeNs](const TelemetryReading& entry) {
+                     uint64_t updateNs = StageLatencies::nowNs();
+                     _store.update(entry);
+                     storeNs += StageLatencies::nowNs() - updateNs;
+                     ack = _acks.receive(entry.ebikeId, entry.sequence);
+                     reading = entry;
+                 });
+             } else if (TelemetryFrame::decodeReading(message, reading)) {
+                 uint64_t updateNs = StageLatencies::nowNs();
+                 _store.update(reading);
+                 storeNs = StageLatencies::nowNs() - updateNs;
+                 ack = _acks.receive(reading.ebikeId, reading.sequence);
+                 count = 1;
              }
-             
-             // If not found, add as new feature
-             if (!found) {
-                 _ebikes->add(geoJson);
+             if (count == 0) {
+                 Metrics::add(Counter::MalformedMessages);
+                 EBIKE_LOG_LIMITED(LogLevel::Warn, 5) << "Error handling message: Malformed binary telemetry frame from "
+                                                      << sourceIp << ":" << sourcePort;
+                 return ResponseMalformedFrame;
              }
+             uint64_t endNs = StageLatencies::nowNs();
+             StageLatencies::record(Stage::Parse, endNs - startNs - storeNs);
+             StageLatencies::record(Stage::Store, storeNs);
+             markPending(endNs);
              
-             std::cout << "Received data from eBike " << ebikeId 
-                       << " at " << latitude << ", " << longitude 
-                       << " from " << sourceIp << ":" << sourcePort << std::endl;
+             logReceived(reading, count, sourceIp, sourcePort);
+             Metrics::add(Counter::ReadingsApplied, count);
+             Metrics::add(Counter::AcksSent);
              
-             // Return acknowledgment
-             return "OK";
-         } catch (const std::exception& e) {
-             std::cerr << "Error handling message: " << e.what() << std::endl;
-             std::cerr << "Message content: " << message << std::endl;
-             return "ERROR: " + std::string(e.what());
+             // Acknowledge everything received so far from this eBike
+             std::size_t ackSize = TelemetryFrame::encodeAck(reading.ebikeId, ack.cumulative, ack.selective, ackBuffer);
+             return std::string_view(reinterpret_cast<const char*>(ackBuffer), ackSize);
+         }
+         
+         // JSON outside the expected schema is handed to the general Poco parser
+         if (!TelemetryParser::parse(message, reading)) {
+             try {
+                 reading = parseWithPoco(message);
+             } catch (const std::exception& e) {
+                 Metrics::add(Counter::MalformedMessages);
+                 EBIKE_LOG_LIMITED(LogLevel::Warn, 5) << "Error handling message: " << e.what()
+                                                      << "; message content: " << message;
+                 return ResponseInvalidMessage;
+             }
+         }
+         uint64_t updateNs = StageLatencies::nowNs();
+         _store.update(reading);
+         uint64_t endNs = StageLatencies::nowNs();
+         StageLatencies::record(Stage::Parse, updateNs - startNs);
+         StageLatencies::record(Stage::Store, endNs - updateNs);
+         markPending(endNs);
+         
+         logReceived(reading, 1, sourceIp, sourcePort);
+         Metrics::add(Counter::ReadingsApplied);
+         Metrics::add(Counter::AcksSent);
+         
+         // Return acknowledgment
+         return ResponseOk;
+     }
+ 
+     /**
+      * @brief Publish a snapshot of the fleet if one is due
+      * 
+      * Called by the ingest worker after handling messages and whenever it
+      * is idle, so updates become visible within one publication interval.
+      * 
+      * @return true if a snapshot was published
+      */
+     bool publishIfDue() {
+         if (!_publisher.publishIfDue(_shard, _store)) {
+             return false;
+         }
+         if (_pendingSinceNs != 0) {
+             StageLatencies::record(Stage::Publish, StageLatencies::nowNs() - _pendingSinceNs);
+             _pendingSinceNs = 0;
          }
+         return true;
+     }
+ 
+     /**
+      * @brief Get the interval at which snapshots are published
+      * @return The publication interval
+      */
+     std::chrono::milliseconds publishInterval() const {
+         return _publisher.interval();
      }
  
  private:
-     Poco::JSON::Array::Ptr& _ebikes; ///< Reference to the shared ebikes array
+     /**
+      * @brief Note when the store first changed after the last publication
+      * @param updateNs When it changed
+      */
+     void markPending(uint64_t updateNs) {
+         if (_pendingSinceNs == 0) {
+             _pendingSinceNs = updateNs;
+         }
+     }
+
+     /**
+      * @brief Log a received message, at most 20 lines a second per kind
+      * @param reading The last reading it carried
+      * @param count Number of readings it carried
+      * @param sourceIp The source IP address of the client
+      * @param sourcePort The source port of the client
+      */
+     void logReceived(const TelemetryReading& reading, std::size_t count, std::string_view sourceIp, int sourcePort) {
+         if (count > 1) {
+             EBIKE_LOG_LIMITED(LogLevel::Info, 20) << "Received data from eBike " << reading.ebikeId
+                 << " at " << fromMicrodegrees(reading.latitudeE6) << ", " << fromMicrodegrees(reading.longitudeE6)
+                 << " (batch of " << count << " readings) from " << sourceIp << ":" << sourcePort;
+         } else {
+             EBIKE_LOG_LIMITED(LogLevel::Info, 20) << "Received data from eBike " << reading.ebikeId
+                 << " at " << fromMicrodegrees(reading.latitudeE6) << ", " << fromMicrodegrees(reading.longitudeE6)
+                 << " from " << sourceIp << ":" << sourcePort;
+         }
+     }
+ 
+     FleetStore _store;             ///< State of this shard, owned by its ingest worker
+     AckTracker _acks;              ///< Received sequence numbers per eBike
+     FleetPublisher& _publisher;    ///< Publisher for snapshots of _store
+     std::size_t _shard;            ///< Shard of the fleet held by _store
+     uint64_t _pendingSinceNs = 0;  ///< Time of the oldest update not yet published; 0 if none
  };
  
  #endif // MESSAGE_HANDLER_Hs
\ No newline at end of file
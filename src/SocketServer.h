@@ -8,21 +8,39 @@
  #define SOCKET_SERVER_H
  
  #include <thread>
- #include <iostream>
  #include <chrono>
  #include <atomic>
+ #include <mutex>
+ #include <condition_variable>
+ #include <memory>
  #include <string>
+ #include <string_view>
+ #include <vector>
+ #include <array>
  #include <arpa/inet.h>
  #include "sim/socket.h"
  #include "sim/in.h"
  #include "MessageHandler.h"
+ #include "fleet/FleetPublisher.h"
+ #include "proto/TelemetryFrame.h"
+ #include "util/SpscQueue.h"
+ #include "util/BufferPool.h"
+ #include "util/AsyncLog.h"
+ #include "util/Metrics.h"
+ #include "util/LatencyHistogram.h"
  
  /**
   * @class SocketServer
   * @brief UDP socket server for receiving messages from eBikes
-  * 
+  *
   * This class creates a UDP socket server that listens for incoming
-  * messages from eBike clients and processes them using a MessageHandler.
+  * messages from eBike clients and processes them on a set of ingest
+  * workers. The fleet is partitioned by e-bike ID into one shard per
+  * worker, as configured on the FleetPublisher; each worker owns the
+  * MessageHandler, and so the store, of its shard. A receive thread
+  * drains the socket and dispatches every datagram to the worker owning
+  * its e-bike through a lock-free queue. Workers share nothing but the
+  * socket, on which they send their acknowledgments directly.
   */
  class SocketServer {
  public:
@@ -30,14 +48,20 @@
       * @brief Constructor for SocketServer
       * @param ip The IP address to bind to
       * @param port The port to bind to
-      * @param messageHandler The message handler for processing incoming messages
+      * @param publisher The publisher; one ingest worker is run per shard
+      * @param historyPoints Positions kept per eBike in the track history
       */
-     SocketServer(const std::string& ip, int port, MessageHandler& messageHandler)
-         : _ip(ip), _port(port), _messageHandler(messageHandler), _running(false) {}
- 
+     SocketServer(const std::string& ip, int port, FleetPublisher& publisher,
+                  std::size_t historyPoints = TrackHistory::DefaultPoints)
+         : _ip(ip), _port(port), _running(false) {
+         for (std::size_t shard = 0; shard < publisher.shards(); ++shard) {
+             _workers.emplace_back(new Worker(publisher, shard, historyPoints, poolSize(publisher.shards())));
+         }
+     }
+     
      /**
       * @brief Start the socket server
-      * 
+      *
       * This method starts the socket server in a separate thread and
       * returns immediately. The server runs until stop() is called.
       */
@@ -45,11 +69,11 @@
          _running = true;
          _serverThread = std::thread(&SocketServer::run, this);
      }
- 
+     
      /**
       * @brief Stop the socket server
-      * 
-      * This method stops the socket server and waits for the server thread to terminate.
+      *
+      * This method stops the socket server and waits for the server and worker threads to terminate.
       */
      void stop() {
          _running = false;
@@ -57,13 +81,57 @@
              _serverThread.join();
          }
      }
+     
+     /**
+      * @brief Get the number of datagrams dropped because a worker fell behind
+      * @return The drop count since start()
+      */
+     uint64_t dropped() const {
+         return _dropped.load(std::memory_order_relaxed);
+     }
  
  private:
+     static constexpr unsigned int BatchSize = 64;      ///< Datagrams moved per receive or send call
+     static constexpr std::size_t QueueCapacity = 256;  ///< Datagrams queued per worker
+     
+     /**
+      * @struct QueuedDatagram
+      * @brief A received datagram waiting for its worker
+      */
+     struct QueuedDatagram {
+         sockaddr_in addr;         ///< Client address
+         std::size_t length = 0;   ///< Bytes received
+         char* data = nullptr;     ///< Receive buffer lent by the pool
+         uint64_t receivedNs = 0;  ///< When recvmmsg returned it, for the stage latencies
+     };
+     
+     /**
+      * @struct Worker
+      * @brief An ingest worker and the shard of the fleet it owns
+      */
+     struct Worker {
+         Worker(FleetPublisher& publisher, std::size_t shard, std::size_t historyPoints, std::size_t poolSize)
+             : handler(publisher, shard, historyPoints), queue(QueueCapacity), returned(poolSize) {}
+         
+         MessageHandler handler;              ///< Handler owning the worker's shard
+         SpscQueue<QueuedDatagram> queue;     ///< Datagrams from the receive thread
+         SpscQueue<char*> returned;           ///< Handled receive buffers going back to the pool
+         std::thread thread;                  ///< The worker thread
+         std::mutex mutex;                    ///< Protects parking on wake
+         std::condition_variable wake;        ///< Signalled when work arrives for a parked worker
+         std::atomic<bool> parked{false};     ///< true while the worker waits for work
+     };
+     
      /**
       * @brief Main server loop
-      * 
-      * This method runs the main server loop that listens for incoming messages
-      * and processes them using the message handler.
+      *
+      * This method binds the socket, starts the ingest workers and then
+      * receives datagrams in batches, handing each to the worker owning
+      * its e-bike. Datagrams are received straight into buffers from a
+      * pool and passed on by pointer; workers send the buffers back once
+      * handled, so nothing is copied or allocated per datagram. A datagram
+      * is dropped if its worker's queue is full; clients retransmit
+      * whatever is not acknowledged.
       */
      void run() {
          try {
@@ -80,42 +148,200 @@
              inet_pton(AF_INET, _ip.c_str(), &(serverAddr.sin_addr));
              sock.bind(serverAddr);
              
-             std::cout << "Socket Server waiting for messages..." << std::endl;
+             // Wake up regularly to notice stop()
+             sock.setReceiveTimeout(static_cast<int>(_workers.front()->handler.publishInterval().count()));
+             
+             for (auto& worker : _workers) {
+                 worker->thread = std::thread(&SocketServer::work, this, std::ref(*worker), std::ref(sock));
+             }
+             
+             EBIKE_LOG(LogLevel::Info) << "Socket Server waiting for messages on " << _workers.size() << " ingest worker(s)...";
              
-             char buffer[1024];
-             sockaddr_in clientAddr;
+             // Receive buffers: enough to fill every worker queue and one more batch
+             BufferPool pool(poolSize(_workers.size()), TelemetryFrame::MaxDatagramSize);
+             std::vector<sim::datagram> requests(BatchSize);
+             std::vector<bool> woken(_workers.size());
              
              while (_running) {
-                 // Zero out the buffer
-                 memset(buffer, 0, sizeof(buffer));
+                 // Take back the buffers workers have finished with
+                 for (auto& worker : _workers) {
+                     while (char** buffer = worker->returned.front()) {
+                         pool.release(*buffer);
+                         worker->returned.pop();
+                     }
+                 }
                  
-                 // Receive data from clients
-                 ssize_t bytesReceived = sock.recvfrom(buffer, sizeof(buffer), 0, clientAddr);
+                 // Lend one buffer per datagram of the batch
+                 unsigned int capacity = 0;
+                 while (capacity < BatchSize) {
+                     char* buffer = pool.acquire();
+                     if (!buffer) {
+                         break;
+                     }
+                     requests[capacity].data = buffer;
+                     requests[capacity].size = pool.bufferSize();
+                     ++capacity;
+                 }
+                 if (capacity == 0) {
+                     // Every buffer is queued; let the workers catch up
+                     std::this_thread::sleep_for(std::chrono::microseconds(100));
+                     continue;
+                 }
                  
-                 if (bytesReceived > 0) {
-                     // Convert client address to string
-                     char clientIP[INET_ADDRSTRLEN];
-                     inet_ntop(AF_INET, &(clientAddr.sin_addr), clientIP, INET_ADDRSTRLEN);
-                     int clientPort = ntohs(clientAddr.sin_port);
-                     
-                     // Process the message
-                     std::string message(buffer, bytesReceived);
-                     std::string response = _messageHandler.handleMessage(message, clientIP, clientPort);
+                 // Drain everything queued, up to one batch, in a single call
+                 int received = sock.recvmmsg(requests.data(), capacity, 0);
+                 uint64_t receivedNs = StageLatencies::nowNs();
+                 if (received > 0) {
+                     Metrics::add(Counter::DatagramsReceived, static_cast<uint64_t>(received));
+                 }
+                 
+                 // Hand each datagram to the worker owning its eBike
+                 woken.assign(_workers.size(), false);
+                 for (int i = 0; i < received; ++i) {
+                     const sim::datagram& request = requests[i];
+                     char* buffer = static_cast<char*>(request.data);
+                     std::string_view message(buffer, request.length);
+                     std::size_t shard = MessageHandler::shardOf(message, _workers.size());
                      
-                     // Send response back to client
-                     sock.sendto(response.c_str(), response.length(), 0, clientAddr);
+                     QueuedDatagram* slot = _workers[shard]->queue.claim();
+                     if (!slot) {
+                         _dropped.fetch_add(1, std::memory_order_relaxed);
+                         Metrics::add(Counter::DatagramsDropped);
+                         pool.release(buffer);
+                         continue;
+                     }
+                     slot->addr = request.addr;
+                     slot->length = request.length;
+                     slot->data = buffer;
+                     slot->receivedNs = receivedNs;
+                     _workers[shard]->queue.commit();
+                     woken[shard] = true;
+                 }
+                 
+                 // Keep the buffers this batch did not need
+                 for (unsigned int i = received > 0 ? static_cast<unsigned int>(received) : 0; i < capacity; ++i) {
+                     pool.release(static_cast<char*>(requests[i].data));
+                 }
+                 
+                 // Wake workers that ran out of work before this batch
+                 std::atomic_thread_fence(std::memory_order_seq_cst);
+                 for (std::size_t shard = 0; shard < _workers.size(); ++shard) {
+                     Worker& worker = *_workers[shard];
+                     if (woken[shard] && worker.parked.load(std::memory_order_relaxed)) {
+                         std::lock_guard<std::mutex> lock(worker.mutex);
+                         worker.wake.notify_one();
+                     }
                  }
              }
+             
+             stopWorkers();
          } catch (const std::exception& e) {
-             std::cerr << "Socket Server error: " << e.what() << std::endl;
+             EBIKE_LOG(LogLevel::Error) << "Socket Server error: " << e.what();
+             stopWorkers();
          }
      }
+     
+     /**
+      * @brief Ingest worker loop
+      *
+      * Handles the datagrams queued for one shard, answers them in a
+      * single batch and publishes the shard when due. The worker parks
+      * when its queue is empty, waking at least once per publication
+      * interval so pending updates still get published.
+      *
+      * @param worker The worker to run
+      * @param sock The bound socket, shared for sending responses
+      */
+     void work(Worker& worker, sim::socket& sock) {
+         std::vector<std::array<uint8_t, TelemetryFrame::AckSize>> ackBuffers(BatchSize);
+         std::vector<sim::datagram> replies(BatchSize);
+         std::vector<uint64_t> receivedNs(BatchSize);
+         char clientIP[INET_ADDRSTRLEN];
+         
+         while (_running) {
+             unsigned int handled = 0;
+             while (handled < BatchSize) {
+                 QueuedDatagram* request = worker.queue.front();
+                 if (!request) {
+                     break;
+                 }
+                 receivedNs[handled] = request->receivedNs;
+                 StageLatencies::record(Stage::Queue, StageLatencies::nowNs() - request->receivedNs);
+                 
+                 // Convert client address to string
+                 inet_ntop(AF_INET, &(request->addr.sin_addr), clientIP, INET_ADDRSTRLEN);
+                 int clientPort = ntohs(request->addr.sin_port);
+                 
+                 // Process the message in place in its receive buffer
+                 std::string_view message(request->data, request->length);
+                 std::string_view response = worker.handler.handleMessage(message, clientIP, clientPort, ackBuffers[handled].data());
+                 
+                 replies[handled].data = const_cast<char*>(response.data());
+                 replies[handled].size = response.size();
+                 replies[handled].addr = request->addr;
+                 
+                 // The pool's size guarantees room for every buffer coming back
+                 *worker.returned.claim() = request->data;
+                 worker.returned.commit();
+                 worker.queue.pop();
+                 ++handled;
+             }
+             
+             // Send every response back in a single call
+             if (handled > 0) {
+                 sock.sendmmsg(replies.data(), handled, 0);
+                 uint64_t sentNs = StageLatencies::nowNs();
+                 for (unsigned int i = 0; i < handled; ++i) {
+                     StageLatencies::record(Stage::Ack, sentNs - receivedNs[i]);
+                 }
+             }
+             
+             // Make recent updates visible to the web server
+             worker.handler.publishIfDue();
+             
+             if (handled == 0) {
+                 std::unique_lock<std::mutex> lock(worker.mutex);
+                 worker.parked.store(true, std::memory_order_relaxed);
+                 std::atomic_thread_fence(std::memory_order_seq_cst);
+                 worker.wake.wait_for(lock, worker.handler.publishInterval(), [&worker, this] {
+                     return !worker.queue.empty() || !_running;
+                 });
+                 worker.parked.store(false, std::memory_order_relaxed);
+             }
+         }
+     }
+     
+     /**
+      * @brief Wake and join every ingest worker once _running is false
+      */
+     void stopWorkers() {
+         _running = false;
+         for (auto& worker : _workers) {
+             {
+                 std::lock_guard<std::mutex> lock(worker->mutex);
+                 worker->wake.notify_one();
+             }
+             if (worker->thread.joinable()) {
+                 worker->thread.join();
+             }
+         }
+     }
+     
+     /**
+      * @brief Get the number of receive buffers
+      * @param workers Number of ingest workers
+      * @return Enough for every worker queue to be full while one more batch is received
+      */
+     static std::size_t poolSize(std::size_t workers) {
+         return workers * QueueCapacity + BatchSize;
+     }
  
      std::string _ip;
      int _port;
-     MessageHandler& _messageHandler;
+     std::vector<std::unique_ptr<Worker>> _workers;  ///< One ingest worker per shard
      std::atomic<bool> _running;
+     std::atomic<uint64_t> _dropped{0};              ///< Datagrams dropped on full worker queues
      std::thread _serverThread;
  };
  
- #endif // SOCKET_SERVER_H
\ No newline at end of file
+ #endif // SOCKET_SERVER_H
@@ -6,41 +6,76 @@
 #include <iostream>
 #include <chrono>
 #include <thread>
-#include <ctime>
-#include <iomanip>
 #include <sstream>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
 #include <arpa/inet.h>
 #include "hal/CSVHALManager.h"
 #include "GPSSensor.h"
 #include "sim/socket.h"
 #include "sim/in.h"
+#include "fleet/Telemetry.h"
+#include "proto/TelemetryFrame.h"
+#include "proto/AckTracker.h"
+#include "proto/SendWindow.h"
+#include "util/TimeCodec.h"
+#include "util/AsyncLog.h"
 
 /**
- * @brief Format current time as a string
- * @return String with formatted current date and time
+ * @struct ClientOptions
+ * @brief Optional command line settings of the eBike client
  */
-std::string getCurrentTime() {
-    auto now = std::chrono::system_clock::now();
-    std::time_t time = std::chrono::system_clock::to_time_t(now);
-    
-    std::stringstream ss;
-    ss << "[" << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S") << "]";
-    return ss.str();
-}
+struct ClientOptions {
+    bool binary = false;                ///< Send binary frames instead of JSON
+    std::size_t batchSize = 1;          ///< Readings per datagram (binary only)
+    int windowMs = 0;                   ///< Send a partial batch once its oldest reading is this old (0 = off)
+    std::size_t maxDatagram = 1400;     ///< Upper bound on the size of a batch datagram
+    int intervalMs = 5000;              ///< Delay between two sensor readings
+    std::size_t inflight = 8;           ///< Datagrams in flight before waiting for ACKs (binary only)
+    int timeoutMs = 500;                ///< Retransmission timeout
+};
 
 /**
- * @brief Get current time in ISO format
- * @return String with current timestamp in ISO format
+ * @brief Parse the optional command line arguments
+ * @param argc Number of command line arguments
+ * @param argv Array of command line arguments
+ * @param first Index of the first optional argument
+ * @param options Receives the parsed options
+ * @return false if an argument is not recognised
  */
-std::string getCurrentTimeISO() {
-    auto now = std::chrono::system_clock::now();
-    std::time_t time = std::chrono::system_clock::to_time_t(now);
+bool parseOptions(int argc, char* argv[], int first, ClientOptions& options) {
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "json" || arg == "binary") {
+            options.binary = arg == "binary";
+        } else if (arg == "--batch" && i + 1 < argc) {
+            options.batchSize = static_cast<std::size_t>(std::max(1, std::stoi(argv[++i])));
+        } else if (arg == "--window" && i + 1 < argc) {
+            options.windowMs = std::stoi(argv[++i]);
+        } else if (arg == "--max-datagram" && i + 1 < argc) {
+            options.maxDatagram = std::min(static_cast<std::size_t>(std::stoi(argv[++i])), TelemetryFrame::MaxDatagramSize);
+        } else if (arg == "--interval" && i + 1 < argc) {
+            options.intervalMs = std::stoi(argv[++i]);
+        } else if (arg == "--inflight" && i + 1 < argc) {
+            options.inflight = static_cast<std::size_t>(std::max(1, std::stoi(argv[++i])));
+        } else if (arg == "--rto" && i + 1 < argc) {
+            options.timeoutMs = std::max(1, std::stoi(argv[++i]));
+        } else {
+            return false;
+        }
+    }
     
-    std::stringstream ss;
-    ss << std::put_time(std::gmtime(&time), "%Y-%m-%dT%H:%M:%SZ");
-    return ss.str();
+    // Batching is only available with binary frames
+    if (options.batchSize > 1 || options.windowMs > 0) {
+        options.binary = true;
+    }
+    // A batch must also fit in the gateway's acknowledgment window
+    options.batchSize = std::min({options.batchSize, TelemetryFrame::batchCapacity(options.maxDatagram),
+                                  static_cast<std::size_t>(AckTracker::WindowSize)});
+    return true;
 }
 
 /**
@@ -50,9 +85,12 @@ std::string getCurrentTimeISO() {
  * @return Exit code
  */
 int main(int argc, char* argv[]) {
-    // Check if we have the right number of arguments
-    if (argc != 5) {
-        std::cerr << "Usage: " << argv[0] << " <client_ip> <ebike_id> <csv_file> <port_id>" << std::endl;
+    // Parse optional arguments after the four required ones
+    ClientOptions options;
+    if (argc < 5 || !parseOptions(argc, argv, 5, options)) {
+        std::cerr << "Usage: " << argv[0] << " <client_ip> <ebike_id> <csv_file> <port_id> [json|binary]"
+                  << " [--batch N] [--window ms] [--max-datagram bytes] [--interval ms]"
+                  << " [--inflight N] [--rto ms]" << std::endl;
         return 1;
     }
 
@@ -62,16 +100,23 @@ int main(int argc, char* argv[]) {
         int ebikeId = std::stoi(argv[2]);
         std::string csvFile = argv[3];
         int portId = std::stoi(argv[4]);
+        uint32_t sequence = 0;
         
         // Server address (the gateway)
         std::string serverIp = "192.168.1.1"; // Assuming gateway is at 192.168.1.1
         int serverPort = 8080; // Assuming gateway listens on port 8080
+        int clientPort = 8081; // Port the gateway sends acknowledgments to
         
         // Set the IP address for the simulated NIC
         sim::set_ipaddr(clientIp.c_str());
         
-        // Create a UDP socket
+        // Create a UDP socket and bind it so acknowledgments can reach us
         sim::socket sock(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in clientAddr;
+        clientAddr.sin_family = AF_INET;
+        clientAddr.sin_port = htons(clientPort);
+        inet_pton(AF_INET, clientIp.c_str(), &(clientAddr.sin_addr));
+        sock.bind(clientAddr);
         
         // Create HAL manager with 1 port
         CSVHALManager halManager(1);
@@ -97,48 +142,162 @@ int main(int argc, char* argv[]) {
         // Buffer for receiving responses
         char buffer[1024];
         
-        while (hasMoreData) {
-            try {
-                // Read the next data point
-                std::vector<uint8_t> reading = halManager.read(portId);
-                
-                // Format and display the reading with timestamp
-                std::string timestamp = getCurrentTime();
-                std::string gpsData = gpsSensor->format(reading);
-                std::cout << timestamp << " " << gpsSensor->format(reading) << std::endl;
-                
-                // Prepare JSON message to send
-                std::stringstream jsonSS;
-                jsonSS << "{\"ebike_id\":" << ebikeId 
-                       << ",\"timestamp\":\"" << getCurrentTimeISO() 
-                       << "\",\"gps\":" << gpsData << "}";
-                std::string jsonMsg = jsonSS.str();
-                
-                // Send the message to the server
-                sock.sendto(jsonMsg.c_str(), jsonMsg.length(), 0, serverAddr);
-                
-                // Receive response
-                sockaddr_in responseAddr;
-                ssize_t bytesReceived = sock.recvfrom(buffer, sizeof(buffer), 0, responseAddr);
-                
-                if (bytesReceived > 0) {
-                    // Process response
-                    std::string response(buffer, bytesReceived);
+        // Sent datagrams awaiting acknowledgment. JSON messages carry no
+        // sequence number, so they are sent one at a time. Binary readings
+        // stay within the gateway's window of selectively acknowledged
+        // sequence numbers, which never moves past a missing reading.
+        typedef SendWindow::Clock Clock;
+        SendWindow window(options.binary ? options.inflight : 1, std::chrono::milliseconds(options.timeoutMs), 10,
+                          options.binary ? AckTracker::WindowSize : 0);
+        uint32_t jsonSequence = 0;
+        
+        // Readings waiting to be sent as one batch frame
+        std::vector<TelemetryReading> pending;
+        pending.reserve(options.batchSize);
+        Clock::time_point pendingSince;
+        std::vector<uint8_t> frame(TelemetryFrame::MaxDatagramSize);
+        
+        auto transmit = [&](const void* data, std::size_t size) {
+            sock.sendto(data, size, 0, serverAddr);
+        };
+        
+        // Send the pending readings, as a single-reading frame or one batch frame
+        auto flush = [&](Clock::time_point now) {
+            if (pending.empty()) {
+                return;
+            }
+            std::size_t frameSize = pending.size() == 1
+                ? TelemetryFrame::encodeReading(pending.front(), frame.data())
+                : TelemetryFrame::encodeBatch(ebikeId, pending.data(), pending.size(), frame.data());
+            transmit(frame.data(), frameSize);
+            window.push(pending.front().sequence, pending.back().sequence, frame.data(), frameSize, now);
+            pending.clear();
+        };
+        
+        // Process a response from the gateway
+        auto handleResponse = [&](ssize_t bytesReceived, const sockaddr_in& responseAddr) {
+            std::string_view response(buffer, static_cast<std::size_t>(bytesReceived));
+            
+            // Get response source
+            char responseIp[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &(responseAddr.sin_addr), responseIp, INET_ADDRSTRLEN);
+            int responsePort = ntohs(responseAddr.sin_port);
+            
+            int ackedId = 0;
+            uint32_t cumulative = 0;
+            uint64_t selective = 0;
+            if (TelemetryFrame::decodeAck(response, ackedId, cumulative, selective)) {
+                std::size_t acked = window.acknowledge(cumulative, selective);
+                EBIKE_LOG(LogLevel::Info) << "Received ACK up to " << cumulative << " (" << acked
+                                          << " datagram(s) acknowledged) from " << responseIp << ":" << responsePort;
+            } else {
+                // Plain-text reply to a JSON message
+                window.acknowledgeOldest();
+                EBIKE_LOG(LogLevel::Info) << "Received response: " << response
+                                          << " from " << responseIp << ":" << responsePort;
+            }
+        };
+        
+        // Room for another reading: a free datagram slot, and a sequence number the gateway can acknowledge
+        auto canTakeReading = [&]() {
+            return !window.full() && window.admits(sequence + 1);
+        };
+        
+        Clock::time_point nextReading = Clock::now();
+        while (hasMoreData || !pending.empty() || !window.empty()) {
+            Clock::time_point now = Clock::now();
+            
+            // A reading given up on leaves a gap the gateway's window never
+            // moves past; once nothing else is in flight, start a new session
+            if (options.binary && window.empty() && !window.admits(sequence + 1)) {
+                EBIKE_LOG(LogLevel::Warn) << "Acknowledgments stalled at a lost reading; restarting sequence numbers";
+                sequence = 0;
+                for (TelemetryReading& telemetry : pending) {
+                    telemetry.sequence = ++sequence;
+                }
+                window.restartSequence();
+            }
+            
+            // Take a reading when one is due, unless the window is full
+            if (hasMoreData && now >= nextReading && canTakeReading()) {
+                try {
+                    // Read the next data point
+                    std::vector<uint8_t> reading = halManager.read(portId);
+                    nextReading = now + std::chrono::milliseconds(options.intervalMs);
                     
-                    // Get response source
-                    char responseIp[INET_ADDRSTRLEN];
-                    inet_ntop(AF_INET, &(responseAddr.sin_addr), responseIp, INET_ADDRSTRLEN);
-                    int responsePort = ntohs(responseAddr.sin_port);
+                    // Format and log the reading; the log line carries the timestamp
+                    int64_t timestampMs = TimeCodec::nowMs();
+                    std::string gpsData = gpsSensor->format(reading);
+                    EBIKE_LOG(LogLevel::Info) << gpsData;
                     
-                    std::cout << "Received response: " << response << std::endl;
-                    std::cout << "From: " << responseIp << ":" << responsePort << std::endl;
+                    if (options.binary) {
+                        // Queue the reading for the next binary frame
+                        TelemetryReading telemetry;
+                        double latitude = 0.0;
+                        double longitude = 0.0;
+                        if (gpsSensor->parse(reading, latitude, longitude)) {
+                            telemetry.ebikeId = ebikeId;
+                            telemetry.sequence = ++sequence;
+                            telemetry.timestampMs = timestampMs;
+                            telemetry.latitudeE6 = toMicrodegrees(latitude);
+                            telemetry.longitudeE6 = toMicrodegrees(longitude);
+                            if (pending.empty()) {
+                                pendingSince = now;
+                            }
+                            pending.push_back(telemetry);
+                        }
+                        if (pending.size() >= options.batchSize) {
+                            flush(now);
+                        }
+                    } else {
+                        // Prepare JSON message to send
+                        std::stringstream jsonSS;
+                        jsonSS << "{\"ebike_id\":" << ebikeId 
+                               << ",\"timestamp\":\"" << TimeCodec::formatCached(timestampMs) 
+                               << "\",\"gps\":" << gpsData << "}";
+                        std::string jsonMsg = jsonSS.str();
+                        
+                        transmit(jsonMsg.c_str(), jsonMsg.length());
+                        ++jsonSequence;
+                        window.push(jsonSequence, jsonSequence, jsonMsg.c_str(), jsonMsg.length(), now);
+                    }
+                } catch (const std::out_of_range& e) {
+                    // No more data available
+                    hasMoreData = false;
                 }
-                
-                // Simulate a delay between readings (5 seconds)
-                std::this_thread::sleep_for(std::chrono::seconds(5));
-            } catch (const std::out_of_range& e) {
-                // No more data available
-                hasMoreData = false;
+            }
+            
+            // Send a partial batch once its oldest reading has waited out the batching window,
+            // or when no more readings will arrive to fill it
+            bool windowExpired = options.windowMs > 0
+                && now - pendingSince >= std::chrono::milliseconds(options.windowMs);
+            if (!pending.empty() && !window.full() && (windowExpired || !hasMoreData)) {
+                flush(now);
+            }
+            
+            // Retransmit anything whose acknowledgment is overdue
+            std::size_t dropped = window.retransmitExpired(now, transmit);
+            if (dropped > 0) {
+                EBIKE_LOG(LogLevel::Warn) << "Gave up on " << dropped << " unacknowledged datagram(s)";
+            }
+            
+            // Wait for acknowledgments until the next reading, batch or retransmission is due
+            Clock::time_point wakeUp = now + std::chrono::milliseconds(options.timeoutMs);
+            if (hasMoreData && canTakeReading()) {
+                wakeUp = std::min(wakeUp, nextReading);
+            }
+            if (!pending.empty() && options.windowMs > 0) {
+                wakeUp = std::min(wakeUp, pendingSince + std::chrono::milliseconds(options.windowMs));
+            }
+            wakeUp = window.nextDeadline(wakeUp);
+            auto waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(wakeUp - Clock::now()).count();
+            sock.setReceiveTimeout(static_cast<int>(std::max<long long>(1, waitMs)));
+            
+            // Receive response
+            sockaddr_in responseAddr;
+            ssize_t bytesReceived = sock.recvfrom(buffer, sizeof(buffer), 0, responseAddr);
+            if (bytesReceived > 0) {
+                handleResponse(bytesReceived, responseAddr);
             }
         }
         
@@ -151,4 +310,4 @@ int main(int argc, char* argv[]) {
     }
     
     return 0;
-}
\ No newline at end of file
+}
@@ -7,11 +7,15 @@
 #include <string>
 #include <memory>
 #include <csignal>
-#include <Poco/JSON/Array.h>
+#include <thread>
+#include <algorithm>
 #include <Poco/Net/HTTPServer.h>
 #include <Poco/Net/ServerSocket.h>
 #include <Poco/Net/HTTPServerParams.h>
 #include "sim/in.h"
+#include "util/AsyncLog.h"
+#include "util/LatencyHistogram.h"
+#include "fleet/FleetPublisher.h"
 #include "web/WebServer.h"
 #include "web/EbikeHandler.h"
 #include "MessageHandler.h"
@@ -20,13 +24,18 @@
 // Global flag for handling Ctrl+C
 volatile sig_atomic_t g_running = 1;
 
+// Set by SIGUSR1 to print the stage latencies from the main loop
+volatile sig_atomic_t g_dumpLatencies = 0;
+
 /**
- * @brief Signal handler for Ctrl+C
+ * @brief Signal handler for Ctrl+C and SIGUSR1
  * @param signal The signal received
  */
 void signalHandler(int signal) {
     if (signal == SIGINT) {
         g_running = 0;
+    } else if (signal == SIGUSR1) {
+        g_dumpLatencies = 1;
     }
 }
 
@@ -39,36 +48,84 @@ void signalHandler(int signal) {
 int main(int argc, char* argv[]) {
     // Register signal handler for Ctrl+C
     std::signal(SIGINT, signalHandler);
+    std::signal(SIGUSR1, signalHandler);
     
     try {
         // Your assigned port number (replace with your own port)
         int webPort = 8080; // Use your assigned port here
         
-        // Create a shared array to store eBike data
-        Poco::JSON::Array::Ptr ebikes = new Poco::JSON::Array;
+        // One ingest worker, and one shard of the fleet, per two cores by default
+        std::size_t ingestWorkers = std::max(1u, std::thread::hardware_concurrency() / 2);
+        std::size_t historyPoints = TrackHistory::DefaultPoints;
+        WebServerConfig webConfig;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--ingest-workers" && i + 1 < argc) {
+                ingestWorkers = static_cast<std::size_t>(std::max(1, std::stoi(argv[++i])));
+            } else if (arg == "--history-points" && i + 1 < argc) {
+                historyPoints = static_cast<std::size_t>(std::max(0, std::stoi(argv[++i])));
+            } else if (arg == "--stream-rate" && i + 1 < argc) {
+                webConfig.streamRate = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--stream-subscribers" && i + 1 < argc) {
+                webConfig.maxStreamSubscribers = std::max(0, std::stoi(argv[++i]));
+            } else if (arg == "--assets" && i + 1 < argc) {
+                webConfig.assetDirectory = argv[++i];
+            } else if (arg == "--http-threads" && i + 1 < argc) {
+                webConfig.maxThreads = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--http-queue" && i + 1 < argc) {
+                webConfig.maxQueued = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--keep-alive-timeout" && i + 1 < argc) {
+                webConfig.keepAliveTimeoutSeconds = std::max(0, std::stoi(argv[++i]));
+            } else if (arg == "--keep-alive-requests" && i + 1 < argc) {
+                webConfig.maxKeepAliveRequests = std::max(0, std::stoi(argv[++i]));
+            } else if (arg == "--http-timeout" && i + 1 < argc) {
+                webConfig.timeoutSeconds = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--log-level" && i + 1 < argc) {
+                LogLevel level;
+                if (!AsyncLog::parseLevel(argv[++i], level)) {
+                    std::cerr << "Unknown log level: " << argv[i] << std::endl;
+                    return 1;
+                }
+                AsyncLog::instance().setLevel(level);
+            } else {
+                std::cerr << "Usage: " << argv[0] << " [--ingest-workers N] [--history-points N]"
+                          << " [--stream-rate N] [--stream-subscribers N] [--assets DIR] [--http-threads N] [--http-queue N]"
+                          << " [--keep-alive-timeout S] [--keep-alive-requests N] [--http-timeout S]"
+                          << " [--log-level debug|info|warn|error]" << std::endl;
+                return 1;
+            }
+        }
+        
+        // Create the publisher through which the web server sees eBike data; versions start from
+        // the clock so clients holding a version from an earlier run are sent the full fleet
+        FleetPublisher fleetPublisher(std::chrono::milliseconds(100), ingestWorkers, FleetPublisher::epochVersion());
         
         // Create and start the web server
-        WebServer webServer(ebikes);
+        WebServer webServer(fleetPublisher, webConfig);
         webServer.start(webPort);
         
         std::cout << "Server started on http://localhost:" << webPort << std::endl;
         std::cout << "Press Ctrl+C to stop the server..." << std::endl;
         
-        // Create message handler for processing incoming messages
-        MessageHandler messageHandler(ebikes);
-        
-        // Create and start the socket server (UDP)
-        SocketServer socketServer("192.168.1.1", 8080, messageHandler);
+        // Create and start the socket server (UDP), with a message handler per ingest worker
+        SocketServer socketServer("192.168.1.1", 8080, fleetPublisher, historyPoints);
         socketServer.start();
         
-        // Wait until Ctrl+C is pressed
+        // Wait until Ctrl+C is pressed, printing the stage latencies whenever SIGUSR1 arrives
         while (g_running) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            if (g_dumpLatencies) {
+                g_dumpLatencies = 0;
+                std::string table;
+                StageLatencies::appendTable(table);
+                std::cout << table << std::flush;
+            }
         }
         
         // Stop the socket server
         socketServer.stop();
         
+        AsyncLog::instance().flush();
         std::cout << "Server stopped." << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -0,0 +1,319 @@
+/**
+ * @file FleetPublisher.h
+ * @brief Hand-off of fleet snapshots from the ingest thread to HTTP threads
+ * @date October 2026
+ */
+
+ #ifndef FLEET_PUBLISHER_H
+ #define FLEET_PUBLISHER_H
+
+ #include <atomic>
+ #include <chrono>
+ #include <memory>
+ #include <mutex>
+ #include <vector>
+ #include <cstddef>
+ #include <cstdint>
+ #include "fleet/FleetStore.h"
+ #include "fleet/FleetSnapshot.h"
+
+ /**
+  * @class FleetPublisher
+  * @brief Publishes immutable fleet snapshots in RCU style
+  *
+  * Each ingest worker owns the FleetStore of one shard of the fleet and
+  * periodically swaps a fresh snapshot of it into this publisher, which
+  * concatenates the latest snapshot of every shard into the fleet-wide
+  * snapshot HTTP threads see. HTTP threads take a reference-counted
+  * pointer to whatever snapshot is current and keep using it for the
+  * whole request; the previous snapshot is freed when its last reader
+  * drops it. Reading only exchanges a pointer, so a slow HTTP response
+  * never holds up ingest.
+  *
+  * With several shards, publishing a shard only swaps its snapshot in;
+  * the fleet-wide snapshot is rebuilt at most once per interval, by
+  * whichever writer finds it due, so its cost does not grow with the
+  * number of shards. A shard's changes are visible within two intervals.
+  *
+  * Versions count up from a first version the gateway takes from the
+  * clock at startup, so a version handed out before a restart is older
+  * than every version of the new run rather than passing for one of them.
+  */
+ class FleetPublisher {
+ public:
+     /**
+      * @brief Constructor for FleetPublisher
+      * @param interval Minimum time between two publications of a shard
+      * @param shards Number of independently written shards
+      * @param firstVersion Version of the empty fleet; the shards' stores must start from it
+      */
+     explicit FleetPublisher(std::chrono::milliseconds interval = std::chrono::milliseconds(100), std::size_t shards = 1,
+                             uint64_t firstVersion = 0)
+         : _interval(interval),
+           _shards(shards > 0 ? shards : 1),
+           _firstVersion(firstVersion),
+           _current(emptySnapshot(firstVersion)) {
+         for (Shard& shard : _shards) {
+             shard.publishedVersion = firstVersion;
+             shard.combinedVersion = firstVersion;
+             shard.snapshot = _current;
+         }
+     }
+
+     /**
+      * @brief Get a first version for this run of the gateway
+      *
+      * Milliseconds since the Unix epoch, times 2048: later than any version
+      * of an earlier run unless it applied over two million updates a second,
+      * and below 2^53 until 2109, so JavaScript clients read it exactly.
+      *
+      * @return The first version
+      */
+     static uint64_t epochVersion() {
+         return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch()).count()) * 2048;
+     }
+
+     /**
+      * @brief Get the most recently published snapshot
+      * @return The snapshot; never null
+      */
+     std::shared_ptr<const FleetSnapshot> current() const {
+         return std::atomic_load_explicit(&_current, std::memory_order_acquire);
+     }
+
+     /**
+      * @brief Publish a snapshot of a shard unconditionally
+      *
+      * With several shards, readers see it once the fleet-wide snapshot is
+      * next rebuilt: now if the interval has elapsed since the last rebuild,
+      * otherwise from a later publishIfDue() of any shard.
+      *
+      * @param shard The shard the store holds
+      * @param store The shard writer's store
+      */
+     void publish(std::size_t shard, FleetStore& store) {
+         Shard& state = _shards[shard];
+         std::shared_ptr<const FleetSnapshot> snapshot = store.snapshot();
+         state.publishedVersion = store.version();
+         state.lastPublish = std::chrono::steady_clock::now();
+
+         if (_shards.size() == 1) {
+             state.snapshot = snapshot;
+             std::atomic_store_explicit(&_current, std::move(snapshot), std::memory_order_release);
+             return;
+         }
+
+         {
+             std::lock_guard<std::mutex> lock(_shardsMutex);
+             state.snapshot = std::move(snapshot);
+             _pending.store(true, std::memory_order_relaxed);
+         }
+         combineIfDue(state.lastPublish);
+     }
+
+     /**
+      * @brief Publish a snapshot of the only shard unconditionally
+      * @param store The writer's store
+      */
+     void publish(FleetStore& store) {
+         publish(0, store);
+     }
+
+     /**
+      * @brief Publish a snapshot of a shard if it changed and the interval has elapsed
+      *
+      * Must only be called from the thread that writes to the shard's store.
+      * Also rebuilds the fleet-wide snapshot if shards were published since
+      * the last rebuild and it is due, so writers call this when idle too.
+      *
+      * @param shard The shard the store holds
+      * @param store The shard writer's store
+      * @return true if a snapshot was published
+      */
+     bool publishIfDue(std::size_t shard, FleetStore& store) {
+         const Shard& state = _shards[shard];
+         if (store.version() == state.publishedVersion
+             || std::chrono::steady_clock::now() - state.lastPublish < _interval) {
+             // Shards published since the last rebuild still need to reach readers
+             if (_pending.load(std::memory_order_relaxed)) {
+                 combineIfDue(std::chrono::steady_clock::now());
+             }
+             return false;
+         }
+         publish(shard, store);
+         return true;
+     }
+
+     /**
+      * @brief Publish a snapshot of the only shard if it is due
+      * @param store The writer's store
+      * @return true if a snapshot was published
+      */
+     bool publishIfDue(FleetStore& store) {
+         return publishIfDue(0, store);
+     }
+
+     /**
+      * @brief Get the minimum time between two publications
+      * @return The publication interval
+      */
+     std::chrono::milliseconds interval() const {
+         return _interval;
+     }
+
+     /**
+      * @brief Get the version of the empty fleet
+      * @return The first version given at construction
+      */
+     uint64_t firstVersion() const {
+         return _firstVersion;
+     }
+
+     /**
+      * @brief Get the number of shards
+      * @return The shard count given at construction
+      */
+     std::size_t shards() const {
+         return _shards.size();
+     }
+
+ private:
+     /**
+      * @struct Shard
+      * @brief Publication state of one shard, padded so writers do not share cache lines
+      */
+     struct alignas(64) Shard {
+         uint64_t publishedVersion = 0;                      ///< Store version of the last publication (shard writer only)
+         std::chrono::steady_clock::time_point lastPublish;  ///< Time of the last publication (shard writer only)
+         std::shared_ptr<const FleetSnapshot> snapshot;      ///< Latest snapshot (guarded by _shardsMutex)
+         uint64_t combinedVersion = 0;                       ///< Store version of the snapshot last combined (guarded by _combineMutex)
+         std::vector<uint64_t> versions;                     ///< Fleet-wide version of the last change per slot (guarded by _combineMutex)
+         std::size_t firstSlot = 0;                          ///< First combined slot of the shard (guarded by _combineMutex)
+         std::size_t slotCount = 0;                          ///< Slots of the shard when last combined (guarded by _combineMutex)
+     };
+
+     static std::shared_ptr<const FleetSnapshot> emptySnapshot(uint64_t version) {
+         return std::make_shared<const FleetSnapshot>(version, FleetColumns(), std::make_shared<const SlotIndex>());
+     }
+
+     /**
+      * @brief Rebuild the fleet-wide snapshot if shards were published and the interval has elapsed
+      *
+      * Only one writer rebuilds at a time; the others carry on, and a shard
+      * swapped in while a rebuild was running is picked up by the next one.
+      *
+      * @param now The current time
+      */
+     void combineIfDue(std::chrono::steady_clock::time_point now) {
+         std::unique_lock<std::mutex> lock(_combineMutex, std::try_to_lock);
+         if (!lock.owns_lock() || now - _lastCombine < _interval) {
+             return;
+         }
+         _parts.clear();
+         {
+             std::lock_guard<std::mutex> shardsLock(_shardsMutex);
+             if (!_pending.load(std::memory_order_relaxed)) {
+                 return;
+             }
+             _pending.store(false, std::memory_order_relaxed);
+             for (const Shard& shard : _shards) {
+                 _parts.push_back(shard.snapshot);
+             }
+         }
+         _lastCombine = now;
+         std::atomic_store_explicit(&_current, combine(), std::memory_order_release);
+     }
+
+     /**
+      * @brief Concatenate the latest snapshot of every shard
+      *
+      * The fleet-wide version is the first version plus the updates of
+      * every shard, so it increases whenever any shard changes. Slot
+      * versions in a shard's snapshot count that shard's updates only, so
+      * the slots changed since the shard was last combined are restamped
+      * with the new fleet-wide version, keeping them comparable with the
+      * versions of earlier combined snapshots. The ID index is only
+      * rebuilt when e-bikes have joined, since slots never move otherwise;
+      * when a join shifts the slots of a later shard, the snapshot's layout
+      * version is raised so slot-keyed consumers start over.
+      *
+      * @return The fleet-wide snapshot of _parts
+      */
+     std::shared_ptr<const FleetSnapshot> combine() {
+         uint64_t version = _firstVersion;
+         std::size_t size = 0;
+         for (const std::shared_ptr<const FleetSnapshot>& part : _parts) {
+             version += part->version() - _firstVersion;
+             size += part->size();
+         }
+
+         for (std::size_t i = 0; i < _shards.size(); ++i) {
+             Shard& shard = _shards[i];
+             const std::vector<uint64_t>& storeVersions = _parts[i]->versions();
+             if (_parts[i]->version() == shard.combinedVersion && shard.versions.size() == storeVersions.size()) {
+                 continue;
+             }
+             shard.versions.resize(storeVersions.size());
+             for (std::size_t slot = 0; slot < storeVersions.size(); ++slot) {
+                 if (storeVersions[slot] > shard.combinedVersion) {
+                     shard.versions[slot] = version;
+                 }
+             }
+             shard.combinedVersion = _parts[i]->version();
+         }
+
+         FleetColumns columns;
+         std::vector<ShardRange> ranges;
+         ranges.reserve(_shards.size());
+         columns.ids.reserve(size);
+         columns.latitudes.reserve(size);
+         columns.longitudes.reserve(size);
+         columns.timestamps.reserve(size);
+         columns.statuses.reserve(size);
+         columns.versions.reserve(size);
+         for (std::size_t i = 0; i < _shards.size(); ++i) {
+             Shard& shard = _shards[i];
+             const FleetSnapshot& part = *_parts[i];
+             if (shard.firstSlot != columns.ids.size() && shard.slotCount > 0) {
+                 _layoutVersion = version;
+             }
+             shard.firstSlot = columns.ids.size();
+             shard.slotCount = part.size();
+             for (const ShardRange& range : part.ranges()) {
+                 ranges.push_back({columns.ids.size() + range.firstSlot, range.history, range.grid});
+             }
+             columns.ids.insert(columns.ids.end(), part.ids().begin(), part.ids().end());
+             columns.latitudes.insert(columns.latitudes.end(), part.latitudes().begin(), part.latitudes().end());
+             columns.longitudes.insert(columns.longitudes.end(), part.longitudes().begin(), part.longitudes().end());
+             columns.timestamps.insert(columns.timestamps.end(), part.timestamps().begin(), part.timestamps().end());
+             columns.statuses.insert(columns.statuses.end(), part.statuses().begin(), part.statuses().end());
+             columns.versions.insert(columns.versions.end(), shard.versions.begin(), shard.versions.end());
+         }
+
+         if (!_combinedIndex || _combinedIndex->size() != size) {
+             auto index = std::make_shared<SlotIndex>();
+             index->reserve(size);
+             for (std::size_t slot = 0; slot < size; ++slot) {
+                 index->emplace(columns.ids[slot], slot);
+             }
+             _combinedIndex = std::move(index);
+         }
+         return std::make_shared<const FleetSnapshot>(version, std::move(columns), _combinedIndex, std::move(ranges),
+                                                      _layoutVersion);
+     }
+
+     std::chrono::milliseconds _interval;                       ///< Minimum time between publications of a shard, and between rebuilds
+     std::vector<Shard> _shards;                                ///< Per-shard publication state
+     uint64_t _firstVersion;                                    ///< Version of the empty fleet
+     std::mutex _shardsMutex;                                   ///< Guards the shards' latest snapshots and _pending
+     std::atomic<bool> _pending{false};                         ///< A shard was published since the last rebuild
+     std::mutex _combineMutex;                                  ///< Held by the writer rebuilding the fleet-wide snapshot
+     std::chrono::steady_clock::time_point _lastCombine;        ///< Time of the last rebuild (guarded by _combineMutex)
+     std::vector<std::shared_ptr<const FleetSnapshot>> _parts;  ///< Shard snapshots being combined (guarded by _combineMutex)
+     std::shared_ptr<const SlotIndex> _combinedIndex;           ///< Index shared by combined snapshots (guarded by _combineMutex)
+     uint64_t _layoutVersion = 0;                               ///< Version at which combined slots last moved (guarded by _combineMutex)
+     std::shared_ptr<const FleetSnapshot> _current;             ///< Current snapshot, accessed atomically
+ };
+
+ #endif // FLEET_PUBLISHER_H
@@ -0,0 +1,405 @@
+/**
+ * @file FleetSnapshot.h
+ * @brief Immutable, shareable copy of the fleet state
+ * @date October 2026
+ */
+
+ #ifndef FLEET_SNAPSHOT_H
+ #define FLEET_SNAPSHOT_H
+
+ #include <algorithm>
+ #include <cmath>
+ #include <optional>
+ #include <unordered_map>
+ #include <vector>
+ #include <memory>
+ #include <cstddef>
+ #include <cstdint>
+ #include "fleet/Telemetry.h"
+ #include "fleet/TrackHistory.h"
+ #include "fleet/SpatialGrid.h"
+ #include "fleet/Geodesy.h"
+
+ /**
+  * @struct FleetColumns
+  * @brief Per-slot fleet telemetry laid out as a struct of arrays
+  */
+ struct FleetColumns {
+     std::vector<int32_t> ids;            ///< e-bike ID per slot
+     std::vector<int32_t> latitudes;      ///< Latitude in microdegrees per slot
+     std::vector<int32_t> longitudes;     ///< Longitude in microdegrees per slot
+     std::vector<int64_t> timestamps;     ///< Epoch milliseconds of the last report per slot
+     std::vector<EBikeStatus> statuses;   ///< Availability per slot
+     std::vector<uint64_t> versions;      ///< Version of the last change per slot
+
+     std::size_t size() const { return ids.size(); }
+ };
+
+ /// Maps e-bike IDs to slots. Slots are only ever appended, never reused.
+ typedef std::unordered_map<int, std::size_t> SlotIndex;
+
+ /**
+  * @struct ShardRange
+  * @brief Per-store structures covering the slots from firstSlot up to the next range
+  *
+  * A store's snapshot has one range; a combined snapshot has one per shard.
+  */
+ struct ShardRange {
+     std::size_t firstSlot = 0;                     ///< First snapshot slot held by the store
+     std::shared_ptr<const TrackHistory> history;  ///< Rings indexed by slot - firstSlot
+     std::shared_ptr<const GridIndex> grid;         ///< Grid of slot - firstSlot at the snapshot's version
+ };
+
+ /**
+  * @struct NearbyBike
+  * @brief An e-bike found by a nearest-neighbour query
+  */
+ struct NearbyBike {
+     std::size_t slot = 0;         ///< Slot in the snapshot
+     double distanceMeters = 0.0;  ///< Great-circle distance from the query position
+ };
+
+ /**
+  * @class FleetSnapshot
+  * @brief A published, read-only view of the fleet at one store version
+  *
+  * Snapshots are created by the ingest thread and handed to HTTP threads
+  * through FleetPublisher. They are never modified after construction, so
+  * any number of readers can use one without synchronisation. Track
+  * histories are the exception: they are shared with the live stores and
+  * read through their seqlocks, so a history may be newer than the snapshot.
+  */
+ class FleetSnapshot {
+ public:
+     /**
+      * @brief Constructor for FleetSnapshot
+      * @param version The store version the snapshot was taken at
+      * @param columns Copy of the store columns
+      * @param index ID-to-slot index, shared between snapshots while the fleet does not grow
+      * @param ranges Track histories and grids of the slots, in slot order
+      * @param layoutVersion Version at which e-bikes last moved to other slots
+      */
+     FleetSnapshot(uint64_t version, FleetColumns columns, std::shared_ptr<const SlotIndex> index,
+                   std::vector<ShardRange> ranges = {}, uint64_t layoutVersion = 0)
+         : _version(version), _columns(std::move(columns)), _index(std::move(index)),
+           _ranges(std::move(ranges)), _layoutVersion(layoutVersion) {}
+
+     /**
+      * @brief Get the store version the snapshot was taken at
+      * @return The version, which increases with every applied update
+      */
+     uint64_t version() const { return _version; }
+
+     /**
+      * @brief Get the number of e-bikes in the snapshot
+      * @return The fleet size
+      */
+     std::size_t size() const { return _columns.size(); }
+
+     /**
+      * @brief Get the version at which e-bikes last moved to other slots
+      *
+      * A store's slots never move. A combined snapshot concatenates its
+      * shards, so an e-bike joining one shard shifts every slot of the shards
+      * after it; anything keyed by slot that spans this version is stale.
+      *
+      * @return The version; 0 if slots have never moved
+      */
+     uint64_t layoutVersion() const { return _layoutVersion; }
+
+     /**
+      * @brief Look up the slot of an e-bike
+      * @param ebikeId The e-bike ID
+      * @param slot Receives the slot if the e-bike is known
+      * @return true if the e-bike is in the snapshot
+      */
+     bool find(int ebikeId, std::size_t& slot) const {
+         auto it = _index->find(ebikeId);
+         if (it == _index->end()) {
+             return false;
+         }
+         slot = it->second;
+         return true;
+     }
+
+     /**
+      * @brief Copy the recent positions of an e-bike within a time range
+      * @param slot Slot of the e-bike
+      * @param fromMs Earliest reading time to include
+      * @param toMs Latest reading time to include
+      * @param out Receives the positions, oldest first
+      * @return Number of positions copied
+      */
+     std::size_t history(std::size_t slot, int64_t fromMs, int64_t toMs, std::vector<TrackSample>& out) const {
+         // Ranges of shards without e-bikes share their firstSlot with the next range
+         const ShardRange* range = nullptr;
+         for (const ShardRange& candidate : _ranges) {
+             if (candidate.firstSlot <= slot) {
+                 range = &candidate;
+             }
+         }
+         if (!range || !range->history) {
+             out.clear();
+             return 0;
+         }
+         return range->history->read(slot - range->firstSlot, fromMs, toMs, out);
+     }
+
+     /**
+      * @brief Find the e-bikes changed after a version
+      *
+      * Slots are stamped with the version at which they last changed, so
+      * this is one pass over a single column; bikes never leave, so a
+      * change list is a complete delta.
+      *
+      * @param since A version of an earlier snapshot
+      * @param limit Most changes worth listing; past that a full copy is no bigger
+      * @param slots Receives the changed slots in slot order; cleared first
+      * @return false if since is newer than this snapshot or more than limit e-bikes
+      *         changed, as for a version from before a gateway restart
+      */
+     bool changedSince(uint64_t since, std::size_t limit, std::vector<std::size_t>& slots) const {
+         slots.clear();
+         if (since > _version) {
+             return false;
+         }
+         const std::vector<uint64_t>& versions = _columns.versions;
+         for (std::size_t slot = 0; slot < versions.size(); ++slot) {
+             if (versions[slot] > since) {
+                 if (slots.size() == limit) {
+                     slots.clear();
+                     return false;
+                 }
+                 slots.push_back(slot);
+             }
+         }
+         return true;
+     }
+
+     /**
+      * @brief Find the e-bikes inside a bounding box
+      * @param minLatitudeE6 Southern edge in microdegrees
+      * @param minLongitudeE6 Western edge in microdegrees
+      * @param maxLatitudeE6 Northern edge in microdegrees
+      * @param maxLongitudeE6 Eastern edge in microdegrees
+      * @param slots Receives the slots of the e-bikes inside, edges included; cleared first
+      * @return Number of e-bikes found
+      */
+     std::size_t queryBox(int32_t minLatitudeE6, int32_t minLongitudeE6, int32_t maxLatitudeE6, int32_t maxLongitudeE6,
+                          std::vector<std::size_t>& slots) const {
+         slots.clear();
+         for (const ShardRange& range : _ranges) {
+             if (!range.grid) {
+                 continue;
+             }
+             const GridIndex& grid = *range.grid;
+             grid.forEachInCells(grid.rowOf(minLatitudeE6), grid.rowOf(maxLatitudeE6),
+                                 grid.columnOf(minLongitudeE6), grid.columnOf(maxLongitudeE6),
+                                 [&](std::size_t local) {
+                 std::size_t slot = range.firstSlot + local;
+                 int32_t latitude = _columns.latitudes[slot];
+                 int32_t longitude = _columns.longitudes[slot];
+                 if (latitude >= minLatitudeE6 && latitude <= maxLatitudeE6
+                     && longitude >= minLongitudeE6 && longitude <= maxLongitudeE6) {
+                     slots.push_back(slot);
+                 }
+             });
+         }
+         return slots.size();
+     }
+
+     /**
+      * @brief Find the e-bikes closest to a position
+      *
+      * Grid cells are visited in square rings of growing size around the
+      * position's cell, keeping the k closest e-bikes by haversine distance.
+      * The search stops once no unvisited cell can hold anything closer
+      * than the k-th e-bike found, or once the rings cover every e-bike.
+      * Far from the fleet, where a ring would have more cells than the grids
+      * have non-empty cells, the remaining non-empty cells are checked one by
+      * one instead. Longitudes do not wrap at the antimeridian. Every shard's
+      * grid is assumed to use the same cell size.
+      *
+      * @param latitudeE6 Latitude of the position in microdegrees
+      * @param longitudeE6 Longitude of the position in microdegrees
+      * @param k Maximum number of e-bikes to return
+      * @param status If set, only e-bikes with this status are considered
+      * @param nearest Receives the e-bikes, closest first; cleared first
+      * @return Number of e-bikes found
+      */
+     std::size_t nearest(int32_t latitudeE6, int32_t longitudeE6, std::size_t k, std::optional<EBikeStatus> status,
+                         std::vector<NearbyBike>& nearest) const {
+         nearest.clear();
+         const GridCells* cells = nullptr;
+         int32_t reach = -1;
+         std::size_t cellCount = 0;
+         for (const ShardRange& range : _ranges) {
+             if (range.grid) {
+                 cells = range.grid.get();
+                 reach = std::max(reach, range.grid->reach(range.grid->rowOf(latitudeE6), range.grid->columnOf(longitudeE6)));
+                 cellCount += range.grid->cellCount();
+             }
+         }
+         if (!cells || k == 0) {
+             return 0;
+         }
+         int32_t row = cells->rowOf(latitudeE6);
+         int32_t column = cells->columnOf(longitudeE6);
+
+         // Max-heap on distance holding the best k so far
+         auto closer = [](const NearbyBike& a, const NearbyBike& b) { return a.distanceMeters < b.distanceMeters; };
+         auto consider = [&](std::size_t slot) {
+             if (status && _columns.statuses[slot] != *status) {
+                 return;
+             }
+             double distance = geodesy::distanceMeters(latitudeE6, longitudeE6,
+                                                       _columns.latitudes[slot], _columns.longitudes[slot]);
+             if (nearest.size() < k) {
+                 nearest.push_back({slot, distance});
+                 std::push_heap(nearest.begin(), nearest.end(), closer);
+             } else if (distance < nearest.front().distanceMeters) {
+                 std::pop_heap(nearest.begin(), nearest.end(), closer);
+                 nearest.back() = {slot, distance};
+                 std::push_heap(nearest.begin(), nearest.end(), closer);
+             }
+         };
+
+         int32_t ring = 0;
+         bool complete = false;
+         for (; ring <= reach && static_cast<std::size_t>(ring) * 8 <= cellCount; ++ring) {
+             for (const ShardRange& range : _ranges) {
+                 if (!range.grid) {
+                     continue;
+                 }
+                 auto visit = [&](std::size_t local) { consider(range.firstSlot + local); };
+                 const GridIndex& grid = *range.grid;
+                 if (ring == 0) {
+                     grid.forEachInCells(row, row, column, column, visit);
+                     continue;
+                 }
+                 grid.forEachInCells(row - ring, row - ring, column - ring, column + ring, visit);
+                 grid.forEachInCells(row + ring, row + ring, column - ring, column + ring, visit);
+                 grid.forEachInCells(row - ring + 1, row + ring - 1, column - ring, column - ring, visit);
+                 grid.forEachInCells(row - ring + 1, row + ring - 1, column + ring, column + ring, visit);
+             }
+             if (nearest.size() == k
+                 && nearest.front().distanceMeters <= unvisitedBound(*cells, latitudeE6, longitudeE6, row, column, ring)) {
+                 complete = true;
+                 break;
+             }
+         }
+
+         // Check the cells beyond the last ring one by one, skipping those too far away to matter
+         if (!complete && ring <= reach) {
+             for (const ShardRange& range : _ranges) {
+                 if (!range.grid) {
+                     continue;
+                 }
+                 range.grid->forEachCell([&](int32_t cellRow, int32_t cellColumn, const uint32_t* begin, const uint32_t* end) {
+                     if (std::max(std::abs(cellRow - row), std::abs(cellColumn - column)) < ring) {
+                         return;
+                     }
+                     if (nearest.size() == k && nearest.front().distanceMeters
+                         <= cellBound(*cells, latitudeE6, longitudeE6, cellRow, cellColumn)) {
+                         return;
+                     }
+                     for (const uint32_t* local = begin; local != end; ++local) {
+                         consider(range.firstSlot + *local);
+                     }
+                 });
+             }
+         }
+
+         std::sort_heap(nearest.begin(), nearest.end(), closer);
+         return nearest.size();
+     }
+
+     /**
+      * @brief Get the per-store structures of the snapshot's slots
+      * @return The ranges, in slot order
+      */
+     const std::vector<ShardRange>& ranges() const { return _ranges; }
+
+     // Column accessors, indexed by slot
+     const std::vector<int32_t>& ids() const { return _columns.ids; }
+     const std::vector<int32_t>& latitudes() const { return _columns.latitudes; }
+     const std::vector<int32_t>& longitudes() const { return _columns.longitudes; }
+     const std::vector<int64_t>& timestamps() const { return _columns.timestamps; }
+     const std::vector<EBikeStatus>& statuses() const { return _columns.statuses; }
+     const std::vector<uint64_t>& versions() const { return _columns.versions; }
+
+ private:
+     /**
+      * @brief Lower bound on the distance from a position to any cell outside a square of cells
+      *
+      * A point outside the square is either beyond its northern or southern
+      * edge, and then at least the latitude gap away, or within its band of
+      * latitudes but beyond its eastern or western edge, where the haversine
+      * formula with the smallest cosine in the band bounds the distance.
+      *
+      * @param cells Cell geometry
+      * @param latitudeE6 Latitude of the position in microdegrees
+      * @param longitudeE6 Longitude of the position in microdegrees
+      * @param row Row of the position's cell
+      * @param column Column of the position's cell
+      * @param ring Half-width of the square in cells, around the position's cell
+      * @return The bound in meters
+      */
+     static double unvisitedBound(const GridCells& cells, int32_t latitudeE6, int32_t longitudeE6,
+                                  int32_t row, int32_t column, int32_t ring) {
+         int64_t cell = cells.cellE6();
+         int64_t south = (static_cast<int64_t>(row) - ring) * cell;
+         int64_t north = (static_cast<int64_t>(row) + ring + 1) * cell;
+         int64_t west = (static_cast<int64_t>(column) - ring) * cell;
+         int64_t east = (static_cast<int64_t>(column) + ring + 1) * cell;
+
+         double latitudeGap = std::min(latitudeE6 - south, north - latitudeE6) * geodesy::RadiansPerMicrodegree;
+         double longitudeGap = std::min(longitudeE6 - west, east - longitudeE6) * geodesy::RadiansPerMicrodegree;
+         double bandEdge = std::min<int64_t>(std::max(std::abs(south), std::abs(north)), 90000000) * geodesy::RadiansPerMicrodegree;
+
+         double beyondBand = geodesy::EarthRadiusMeters * latitudeGap;
+         double withinBand = geodesy::metersFromHaversine(std::cos(latitudeE6 * geodesy::RadiansPerMicrodegree)
+                                                          * std::cos(bandEdge)
+                                                          * geodesy::haversine(std::min(longitudeGap, geodesy::Pi)));
+         return std::min(beyondBand, withinBand);
+     }
+
+     /**
+      * @brief Lower bound on the distance from a position to any point of a cell
+      *
+      * The larger of the latitude gap and the haversine bound on the
+      * longitude gap, with the smallest cosine over the cell's latitudes.
+      *
+      * @param cells Cell geometry
+      * @param latitudeE6 Latitude of the position in microdegrees
+      * @param longitudeE6 Longitude of the position in microdegrees
+      * @param row Row of the cell
+      * @param column Column of the cell
+      * @return The bound in meters
+      */
+     static double cellBound(const GridCells& cells, int32_t latitudeE6, int32_t longitudeE6, int32_t row, int32_t column) {
+         int64_t cell = cells.cellE6();
+         int64_t south = static_cast<int64_t>(row) * cell;
+         int64_t north = south + cell;
+         int64_t west = static_cast<int64_t>(column) * cell;
+         int64_t east = west + cell;
+
+         int64_t latitudeGap = std::max<int64_t>({south - latitudeE6, latitudeE6 - north, 0});
+         int64_t longitudeGap = std::max<int64_t>({west - longitudeE6, longitudeE6 - east, 0});
+         double bandEdge = std::min<int64_t>(std::max(std::abs(south), std::abs(north)), 90000000) * geodesy::RadiansPerMicrodegree;
+
+         double byLatitude = geodesy::EarthRadiusMeters * latitudeGap * geodesy::RadiansPerMicrodegree;
+         double byLongitude = geodesy::metersFromHaversine(
+             std::cos(latitudeE6 * geodesy::RadiansPerMicrodegree) * std::cos(bandEdge)
+             * geodesy::haversine(std::min(longitudeGap * geodesy::RadiansPerMicrodegree, geodesy::Pi)));
+         return std::max(byLatitude, byLongitude);
+     }
+
+     uint64_t _version;                        ///< Store version at publication
+     FleetColumns _columns;                    ///< Copied fleet columns
+     std::shared_ptr<const SlotIndex> _index;  ///< e-bike ID -> slot
+     std::vector<ShardRange> _ranges;          ///< Track histories and grids by slot range
+     uint64_t _layoutVersion;                  ///< Version at which slots last moved
+ };
+
+ #endif // FLEET_SNAPSHOT_H
@@ -0,0 +1,195 @@
+/**
+ * @file FleetStore.h
+ * @brief Columnar store holding the latest telemetry of every e-bike
+ * @date October 2026
+ */
+
+ #ifndef FLEET_STORE_H
+ #define FLEET_STORE_H
+
+ #include <limits>
+ #include <memory>
+ #include <vector>
+ #include <cstddef>
+ #include <cstdint>
+ #include "fleet/Telemetry.h"
+ #include "fleet/FleetSnapshot.h"
+ #include "fleet/TrackHistory.h"
+ #include "fleet/SpatialGrid.h"
+
+ /**
+  * @class FleetStore
+  * @brief Fleet state laid out as a struct of arrays
+  *
+  * Every e-bike owns a dense slot, assigned on its first report, and each
+  * field lives in its own array indexed by that slot. A hash index maps
+  * e-bike IDs to slots so updates are O(1) and write in place, while
+  * fleet-wide scans walk contiguous memory. A bike costs 29 bytes of column
+  * data plus its index entry; GeoJSON is only produced by the web layer.
+  * Every change stamps the slot with the store version it produced, so
+  * readers can ask which e-bikes changed after a version they have seen.
+  * Accepted reports are also appended to the slot's TrackHistory ring and
+  * move the slot within the SpatialGrid.
+  *
+  * The store is owned by a single writer and is not thread-safe; readers
+  * on other threads use the immutable snapshots it produces.
+  */
+ class FleetStore {
+ public:
+     /**
+      * @brief Constructor for FleetStore
+      * @param historyPoints Positions kept per e-bike in its track history; 0 disables it
+      * @param firstVersion Version of the empty store; updates count up from it
+      */
+     explicit FleetStore(std::size_t historyPoints = TrackHistory::DefaultPoints, uint64_t firstVersion = 0)
+         : _version(firstVersion), _history(std::make_shared<TrackHistory>(historyPoints)) {}
+
+     /**
+      * @brief Record a position report, creating the e-bike if it is new
+      * 
+      * Reports older than the one already stored, such as late
+      * retransmissions, are ignored so a bike never jumps back in time.
+      * 
+      * @param reading The decoded telemetry reading
+      * @return The slot holding the e-bike
+      */
+     std::size_t update(const TelemetryReading& reading) {
+         std::size_t slot = slotFor(reading.ebikeId);
+         if (reading.timestampMs < _columns.timestamps[slot]) {
+             return slot;
+         }
+         _columns.latitudes[slot] = reading.latitudeE6;
+         _columns.longitudes[slot] = reading.longitudeE6;
+         _columns.timestamps[slot] = reading.timestampMs;
+         _history->append(slot, reading);
+         _grid.place(slot, reading.latitudeE6, reading.longitudeE6);
+         _columns.versions[slot] = ++_version;
+         return slot;
+     }
+
+     /**
+      * @brief Set the availability of an e-bike
+      * @param ebikeId The e-bike ID
+      * @param status The new status
+      * @return false if the e-bike has never reported
+      */
+     bool setStatus(int ebikeId, EBikeStatus status) {
+         auto it = _slots.find(ebikeId);
+         if (it == _slots.end()) {
+             return false;
+         }
+         _columns.statuses[it->second] = status;
+         _columns.versions[it->second] = ++_version;
+         return true;
+     }
+
+     /**
+      * @brief Look up the slot of an e-bike
+      * @param ebikeId The e-bike ID
+      * @param slot Receives the slot if the e-bike is known
+      * @return true if the e-bike is in the store
+      */
+     bool find(int ebikeId, std::size_t& slot) const {
+         auto it = _slots.find(ebikeId);
+         if (it == _slots.end()) {
+             return false;
+         }
+         slot = it->second;
+         return true;
+     }
+
+     /**
+      * @brief Get the number of e-bikes in the store
+      * @return The fleet size, which is also the number of slots in use
+      */
+     std::size_t size() const {
+         return _columns.size();
+     }
+
+     /**
+      * @brief Get the store version
+      * @return A counter that increases with every applied update
+      */
+     uint64_t version() const {
+         return _version;
+     }
+
+     /**
+      * @brief Reserve column capacity for an expected fleet size
+      * @param capacity Number of e-bikes to make room for
+      */
+     void reserve(std::size_t capacity) {
+         _columns.ids.reserve(capacity);
+         _columns.latitudes.reserve(capacity);
+         _columns.longitudes.reserve(capacity);
+         _columns.timestamps.reserve(capacity);
+         _columns.statuses.reserve(capacity);
+         _columns.versions.reserve(capacity);
+         _slots.reserve(capacity);
+     }
+
+     /**
+      * @brief Take an immutable copy of the current state
+      *
+      * Columns are copied; the ID index is only copied again when e-bikes
+      * have joined since the previous snapshot, and the grid only when
+      * e-bikes have also changed cell.
+      *
+      * @return The snapshot
+      */
+     std::shared_ptr<const FleetSnapshot> snapshot() {
+         if (!_publishedIndex || _publishedIndex->size() != _slots.size()) {
+             _publishedIndex = std::make_shared<const SlotIndex>(_slots);
+         }
+         return std::make_shared<const FleetSnapshot>(_version, _columns, _publishedIndex,
+                                                      std::vector<ShardRange>{{0, _history, _grid.freeze()}});
+     }
+
+     /**
+      * @brief Get the track history of the store's e-bikes
+      * @return The history, indexed by slot
+      */
+     const TrackHistory& history() const {
+         return *_history;
+     }
+
+     // Column accessors, indexed by slot
+     const std::vector<int32_t>& ids() const { return _columns.ids; }
+     const std::vector<int32_t>& latitudes() const { return _columns.latitudes; }
+     const std::vector<int32_t>& longitudes() const { return _columns.longitudes; }
+     const std::vector<int64_t>& timestamps() const { return _columns.timestamps; }
+     const std::vector<EBikeStatus>& statuses() const { return _columns.statuses; }
+     const std::vector<uint64_t>& versions() const { return _columns.versions; }
+
+ private:
+     /**
+      * @brief Get the slot of an e-bike, appending a new one if needed
+      * @param ebikeId The e-bike ID
+      * @return The slot index
+      */
+     std::size_t slotFor(int ebikeId) {
+         // Look up first: emplace() allocates a node even when the key exists
+         auto it = _slots.find(ebikeId);
+         if (it != _slots.end()) {
+             return it->second;
+         }
+         std::size_t slot = _columns.size();
+         _slots.emplace(ebikeId, slot);
+         _columns.ids.push_back(ebikeId);
+         _columns.latitudes.push_back(0);
+         _columns.longitudes.push_back(0);
+         _columns.timestamps.push_back(std::numeric_limits<int64_t>::min());
+         _columns.statuses.push_back(EBikeStatus::Unlocked);
+         _columns.versions.push_back(0);
+         return slot;
+     }
+
+     FleetColumns _columns;                            ///< Per-slot telemetry
+     SlotIndex _slots;                                 ///< e-bike ID -> slot
+     uint64_t _version;                                ///< First version plus the updates applied
+     std::shared_ptr<const SlotIndex> _publishedIndex; ///< Index copy shared by snapshots
+     std::shared_ptr<TrackHistory> _history;           ///< Recent positions per slot, shared with snapshots
+     SpatialGrid _grid;                                ///< Cell of every slot, frozen into snapshots
+ };
+
+ #endif // FLEET_STORE_H
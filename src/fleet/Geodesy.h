@@ -0,0 +1,57 @@
+/**
+ * @file Geodesy.h
+ * @brief Great-circle distances between fixed-point positions
+ * @date October 2026
+ */
+
+ #ifndef GEODESY_H
+ #define GEODESY_H
+
+ #include <algorithm>
+ #include <cmath>
+ #include <cstdint>
+
+ namespace geodesy {
+
+ constexpr double EarthRadiusMeters = 6371008.8;            ///< Mean Earth radius
+ constexpr double Pi = 3.14159265358979323846;
+ constexpr double RadiansPerMicrodegree = Pi / 180e6;
+
+ /**
+  * @brief Haversine of an angle, sin^2(angle / 2)
+  * @param radians The angle
+  * @return The haversine
+  */
+ inline double haversine(double radians) {
+     double s = std::sin(radians / 2);
+     return s * s;
+ }
+
+ /**
+  * @brief Turn a haversine back into a distance along the Earth's surface
+  * @param h Haversine of the central angle
+  * @return The distance in meters
+  */
+ inline double metersFromHaversine(double h) {
+     return 2 * EarthRadiusMeters * std::asin(std::sqrt(std::min(1.0, std::max(0.0, h))));
+ }
+
+ /**
+  * @brief Great-circle distance between two positions, by the haversine formula
+  * @param latitude1E6 Latitude of the first position in microdegrees
+  * @param longitude1E6 Longitude of the first position in microdegrees
+  * @param latitude2E6 Latitude of the second position in microdegrees
+  * @param longitude2E6 Longitude of the second position in microdegrees
+  * @return The distance in meters
+  */
+ inline double distanceMeters(int32_t latitude1E6, int32_t longitude1E6, int32_t latitude2E6, int32_t longitude2E6) {
+     double latitude1 = latitude1E6 * RadiansPerMicrodegree;
+     double latitude2 = latitude2E6 * RadiansPerMicrodegree;
+     double deltaLongitude = (static_cast<int64_t>(longitude2E6) - longitude1E6) * RadiansPerMicrodegree;
+     return metersFromHaversine(haversine(latitude2 - latitude1)
+                                + std::cos(latitude1) * std::cos(latitude2) * haversine(deltaLongitude));
+ }
+
+ } // namespace geodesy
+
+ #endif // GEODESY_H
@@ -0,0 +1,274 @@
+/**
+ * @file SpatialGrid.h
+ * @brief Uniform grid index over e-bike positions
+ * @date October 2026
+ */
+
+ #ifndef SPATIAL_GRID_H
+ #define SPATIAL_GRID_H
+
+ #include <algorithm>
+ #include <cstdlib>
+ #include <limits>
+ #include <memory>
+ #include <unordered_map>
+ #include <vector>
+ #include <cstddef>
+ #include <cstdint>
+
+ /**
+  * @class GridCells
+  * @brief Mapping from grid cells to coordinates, shared by the live and frozen grids
+  *
+  * Cells are squares of cellE6 microdegrees of latitude and longitude.
+  * A cell is keyed by its row (latitude band) in the high 32 bits and its
+  * column (longitude band) in the low 32 bits, both offset to be unsigned,
+  * so sorting keys orders cells row by row, west to east.
+  */
+ class GridCells {
+ public:
+     static constexpr int32_t DefaultCellE6 = 5000; ///< 0.005 degrees, about 560 m north-south
+
+     explicit GridCells(int32_t cellE6 = DefaultCellE6) : _cellE6(cellE6 > 0 ? cellE6 : DefaultCellE6) {}
+
+     int32_t cellE6() const { return _cellE6; }
+
+     /// Row of the cell holding a latitude
+     int32_t rowOf(int32_t latitudeE6) const { return floorDiv(latitudeE6, _cellE6); }
+
+     /// Column of the cell holding a longitude
+     int32_t columnOf(int32_t longitudeE6) const { return floorDiv(longitudeE6, _cellE6); }
+
+     /// Key of a cell
+     static uint64_t key(int32_t row, int32_t column) {
+         return (static_cast<uint64_t>(static_cast<uint32_t>(row) ^ 0x80000000u) << 32)
+             | (static_cast<uint32_t>(column) ^ 0x80000000u);
+     }
+
+     /// Row of a cell key
+     static int32_t rowOfKey(uint64_t key) {
+         return static_cast<int32_t>(static_cast<uint32_t>(key >> 32) ^ 0x80000000u);
+     }
+
+     /// Column of a cell key
+     static int32_t columnOfKey(uint64_t key) {
+         return static_cast<int32_t>(static_cast<uint32_t>(key) ^ 0x80000000u);
+     }
+
+ private:
+     static int32_t floorDiv(int32_t value, int32_t divisor) {
+         return value / divisor - (value % divisor < 0 ? 1 : 0);
+     }
+
+     int32_t _cellE6; ///< Cell size in microdegrees
+ };
+
+ /**
+  * @class GridIndex
+  * @brief Immutable grid index, as published with a snapshot
+  *
+  * Non-empty cells are stored in key order with the slots of each cell in
+  * one flat array, so a bounding box is answered by one binary search per
+  * row of cells it spans followed by a contiguous walk.
+  */
+ class GridIndex : public GridCells {
+ public:
+     /**
+      * @brief Constructor for GridIndex
+      * @param cells Cell geometry
+      * @param keys Keys of the non-empty cells, sorted
+      * @param offsets Start of each cell's slots, plus the total at the end
+      * @param slots Slots of every cell
+      */
+     GridIndex(const GridCells& cells, std::vector<uint64_t> keys, std::vector<uint32_t> offsets, std::vector<uint32_t> slots)
+         : GridCells(cells), _keys(std::move(keys)), _offsets(std::move(offsets)), _slots(std::move(slots)) {
+         if (!_keys.empty()) {
+             _minRow = rowOfKey(_keys.front());
+             _maxRow = rowOfKey(_keys.back());
+             _minColumn = std::numeric_limits<int32_t>::max();
+             _maxColumn = std::numeric_limits<int32_t>::min();
+             for (uint64_t cell : _keys) {
+                 _minColumn = std::min(_minColumn, columnOfKey(cell));
+                 _maxColumn = std::max(_maxColumn, columnOfKey(cell));
+             }
+         }
+     }
+
+     /**
+      * @brief Visit the slots of every cell in a range of rows and columns
+      *
+      * Slots are only known to lie in a visited cell; callers check the
+      * exact position themselves.
+      *
+      * @param minRow First row
+      * @param maxRow Last row
+      * @param minColumn First column
+      * @param maxColumn Last column
+      * @param visit Called with each slot
+      */
+     template <typename Visit>
+     void forEachInCells(int32_t minRow, int32_t maxRow, int32_t minColumn, int32_t maxColumn, Visit&& visit) const {
+         if (_keys.empty() || minRow > maxRow || minColumn > maxColumn) {
+             return;
+         }
+         // Rows and columns beyond every e-bike are skipped without a search
+         minRow = std::max(minRow, _minRow);
+         maxRow = std::min(maxRow, _maxRow);
+         minColumn = std::max(minColumn, _minColumn);
+         maxColumn = std::min(maxColumn, _maxColumn);
+         if (minRow > maxRow || minColumn > maxColumn) {
+             return;
+         }
+         for (int32_t row = minRow; row <= maxRow; ++row) {
+             uint64_t last = key(row, maxColumn);
+             auto it = std::lower_bound(_keys.begin(), _keys.end(), key(row, minColumn));
+             for (; it != _keys.end() && *it <= last; ++it) {
+                 std::size_t cell = static_cast<std::size_t>(it - _keys.begin());
+                 for (uint32_t i = _offsets[cell]; i < _offsets[cell + 1]; ++i) {
+                     visit(static_cast<std::size_t>(_slots[i]));
+                 }
+             }
+             if (row == maxRow) {
+                 break;
+             }
+         }
+     }
+
+     /**
+      * @brief Visit every non-empty cell
+      * @param visit Called with the row, the column and the range of slots of each cell
+      */
+     template <typename Visit>
+     void forEachCell(Visit&& visit) const {
+         for (std::size_t cell = 0; cell < _keys.size(); ++cell) {
+             visit(rowOfKey(_keys[cell]), columnOfKey(_keys[cell]),
+                   _slots.data() + _offsets[cell], _slots.data() + _offsets[cell + 1]);
+         }
+     }
+
+     /**
+      * @brief Get the number of non-empty cells
+      * @return The cell count
+      */
+     std::size_t cellCount() const {
+         return _keys.size();
+     }
+
+     /**
+      * @brief Get the Chebyshev distance, in cells, from a cell to the farthest non-empty cell
+      * @param row Row of the cell
+      * @param column Column of the cell
+      * @return The distance; -1 if the grid is empty
+      */
+     int32_t reach(int32_t row, int32_t column) const {
+         if (_keys.empty()) {
+             return -1;
+         }
+         return std::max({std::abs(row - _minRow), std::abs(row - _maxRow),
+                          std::abs(column - _minColumn), std::abs(column - _maxColumn)});
+     }
+
+ private:
+     std::vector<uint64_t> _keys;     ///< Non-empty cells in key order
+     std::vector<uint32_t> _offsets;  ///< Start of each cell in _slots, then _slots.size()
+     std::vector<uint32_t> _slots;    ///< Slots grouped by cell
+     int32_t _minRow = 0;             ///< Extent of the non-empty cells
+     int32_t _maxRow = 0;
+     int32_t _minColumn = 0;
+     int32_t _maxColumn = 0;
+ };
+
+ /**
+  * @class SpatialGrid
+  * @brief Grid index over the positions in one FleetStore, updated in place
+  *
+  * Each cell keeps a bucket of the slots in it, and each slot remembers
+  * its cell and its position in that bucket, so moving an e-bike to
+  * another cell is two O(1) bucket edits and a move within its cell costs
+  * nothing. Buckets keep their capacity when e-bikes leave, so a fleet
+  * moving around a city stops allocating once it has visited its cells.
+  *
+  * freeze() turns the buckets into a GridIndex for snapshots, and only
+  * rebuilds it when some e-bike joined or changed cell since the last call.
+  * The grid is owned by the store's writer and is not thread-safe.
+  */
+ class SpatialGrid : public GridCells {
+ public:
+     explicit SpatialGrid(int32_t cellE6 = DefaultCellE6) : GridCells(cellE6) {}
+
+     /**
+      * @brief Put a slot at a position
+      * @param slot The slot; either already placed or the next new one
+      * @param latitudeE6 Latitude in microdegrees
+      * @param longitudeE6 Longitude in microdegrees
+      */
+     void place(std::size_t slot, int32_t latitudeE6, int32_t longitudeE6) {
+         uint64_t cell = key(rowOf(latitudeE6), columnOf(longitudeE6));
+         if (slot < _cellOf.size()) {
+             if (_cellOf[slot] == cell) {
+                 return;
+             }
+             remove(slot);
+         } else {
+             _cellOf.push_back(cell);
+             _positionOf.push_back(0);
+         }
+
+         std::vector<uint32_t>& bucket = _buckets[cell];
+         _cellOf[slot] = cell;
+         _positionOf[slot] = static_cast<uint32_t>(bucket.size());
+         bucket.push_back(static_cast<uint32_t>(slot));
+         _frozen.reset();
+     }
+
+     /**
+      * @brief Get an immutable copy of the grid
+      * @return The index; the same object as last time if no slot changed cell
+      */
+     std::shared_ptr<const GridIndex> freeze() {
+         if (_frozen) {
+             return _frozen;
+         }
+
+         std::vector<uint64_t> keys;
+         keys.reserve(_buckets.size());
+         for (const auto& bucket : _buckets) {
+             if (!bucket.second.empty()) {
+                 keys.push_back(bucket.first);
+             }
+         }
+         std::sort(keys.begin(), keys.end());
+
+         std::vector<uint32_t> offsets;
+         std::vector<uint32_t> slots;
+         offsets.reserve(keys.size() + 1);
+         slots.reserve(_cellOf.size());
+         for (uint64_t cell : keys) {
+             offsets.push_back(static_cast<uint32_t>(slots.size()));
+             const std::vector<uint32_t>& bucket = _buckets.find(cell)->second;
+             slots.insert(slots.end(), bucket.begin(), bucket.end());
+         }
+         offsets.push_back(static_cast<uint32_t>(slots.size()));
+
+         _frozen = std::make_shared<const GridIndex>(*this, std::move(keys), std::move(offsets), std::move(slots));
+         return _frozen;
+     }
+
+ private:
+     /// Take a slot out of its bucket, filling the gap with the bucket's last slot
+     void remove(std::size_t slot) {
+         std::vector<uint32_t>& bucket = _buckets.find(_cellOf[slot])->second;
+         uint32_t position = _positionOf[slot];
+         uint32_t moved = bucket.back();
+         bucket[position] = moved;
+         _positionOf[moved] = position;
+         bucket.pop_back();
+     }
+
+     std::unordered_map<uint64_t, std::vector<uint32_t>> _buckets; ///< Slots per cell key
+     std::vector<uint64_t> _cellOf;                                ///< Cell key per slot
+     std::vector<uint32_t> _positionOf;                            ///< Index in its bucket per slot
+     std::shared_ptr<const GridIndex> _frozen;                     ///< Last frozen copy, reset on change
+ };
+
+ #endif // SPATIAL_GRID_H
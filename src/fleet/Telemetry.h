@@ -0,0 +1,84 @@
+/**
+ * @file Telemetry.h
+ * @brief Compact telemetry types shared by the ingest path and the fleet store
+ * @date October 2026
+ */
+
+ #ifndef TELEMETRY_H
+ #define TELEMETRY_H
+
+ #include <cstdint>
+ #include <cmath>
+ #include <string_view>
+
+ /**
+  * @enum EBikeStatus
+  * @brief Availability of an e-bike, stored as a single byte per bike
+  */
+ enum class EBikeStatus : uint8_t {
+     Unlocked = 0,
+     Locked = 1,
+     Maintenance = 2
+ };
+
+ /**
+  * @brief Get the name of a status as used in GeoJSON properties
+  * @param status The status
+  * @return The status name
+  */
+ inline const char* statusName(EBikeStatus status) {
+     switch (status) {
+         case EBikeStatus::Locked: return "locked";
+         case EBikeStatus::Maintenance: return "maintenance";
+         case EBikeStatus::Unlocked: break;
+     }
+     return "unlocked";
+ }
+
+ /**
+  * @brief Look up a status by its GeoJSON name
+  * @param name "unlocked", "locked" or "maintenance"
+  * @param status Receives the status
+  * @return false if the name is unknown
+  */
+ inline bool parseStatus(std::string_view name, EBikeStatus& status) {
+     for (EBikeStatus candidate : {EBikeStatus::Unlocked, EBikeStatus::Locked, EBikeStatus::Maintenance}) {
+         if (name == statusName(candidate)) {
+             status = candidate;
+             return true;
+         }
+     }
+     return false;
+ }
+
+ /**
+  * @brief Convert degrees to fixed-point microdegrees
+  * @param degrees Latitude or longitude in degrees
+  * @return The value in millionths of a degree
+  */
+ inline int32_t toMicrodegrees(double degrees) {
+     return static_cast<int32_t>(std::lround(degrees * 1e6));
+ }
+
+ /**
+  * @brief Convert fixed-point microdegrees back to degrees
+  * @param microdegrees Latitude or longitude in millionths of a degree
+  * @return The value in degrees
+  */
+ inline double fromMicrodegrees(int32_t microdegrees) {
+     return microdegrees / 1e6;
+ }
+
+ /**
+  * @struct TelemetryReading
+  * @brief A single decoded position report from an e-bike
+  */
+ struct TelemetryReading {
+     int ebikeId = 0;          ///< e-bike ID
+     uint32_t sequence = 0;    ///< Per-bike sequence number (0 for JSON messages)
+     int64_t timestampMs = 0;  ///< Reading time in milliseconds since the Unix epoch
+     int32_t latitudeE6 = 0;   ///< Latitude in microdegrees
+     int32_t longitudeE6 = 0;  ///< Longitude in microdegrees
+ };
+
+ #endif // TELEMETRY_H
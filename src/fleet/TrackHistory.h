@@ -0,0 +1,205 @@
+/**
+ * @file TrackHistory.h
+ * @brief Bounded per-bike rings of recent positions
+ * @date October 2026
+ */
+
+ #ifndef TRACK_HISTORY_H
+ #define TRACK_HISTORY_H
+
+ #include <atomic>
+ #include <memory>
+ #include <vector>
+ #include <cstddef>
+ #include <cstdint>
+ #include "fleet/Telemetry.h"
+
+ /**
+  * @struct TrackSample
+  * @brief One recorded position of an e-bike
+  */
+ struct TrackSample {
+     int64_t timestampMs = 0;  ///< Reading time in milliseconds since the Unix epoch
+     int32_t latitudeE6 = 0;   ///< Latitude in microdegrees
+     int32_t longitudeE6 = 0;  ///< Longitude in microdegrees
+ };
+
+ /**
+  * @class TrackHistory
+  * @brief Fixed-capacity ring of the most recent positions of every e-bike
+  *
+  * Rings are indexed by the FleetStore slot of the e-bike and live in
+  * blocks of BlockBikes rings, each block allocated in one piece the first
+  * time one of its slots is used and never moved or freed afterwards. The
+  * table of blocks is sized at construction, so memory is bounded by
+  * maxBikes x pointsPerBike x 16 bytes and grows in predictable steps.
+  *
+  * There is one writer, the ingest worker owning the store. HTTP threads
+  * read rings concurrently without locks: each ring carries a sequence
+  * counter that is odd while an append is in progress, and a reader copies
+  * the ring and retries if the counter moved (a seqlock).
+  */
+ class TrackHistory {
+ public:
+     static constexpr std::size_t DefaultPoints = 64;        ///< Positions kept per e-bike by default
+     static constexpr std::size_t DefaultMaxBikes = 131072;  ///< e-bikes with a history per store by default
+     static constexpr std::size_t BlockBikes = 1024;         ///< Rings allocated together
+
+     /**
+      * @brief Constructor for TrackHistory
+      * @param pointsPerBike Positions kept per e-bike; 0 disables the history
+      * @param maxBikes Slots that get a ring; later e-bikes have no history
+      */
+     explicit TrackHistory(std::size_t pointsPerBike = DefaultPoints, std::size_t maxBikes = DefaultMaxBikes)
+         : _points(pointsPerBike),
+           _blocks(pointsPerBike > 0 ? (maxBikes + BlockBikes - 1) / BlockBikes : 0) {}
+
+     TrackHistory(const TrackHistory&) = delete;
+     TrackHistory& operator=(const TrackHistory&) = delete;
+
+     /**
+      * @brief Record a position, overwriting the oldest once the ring is full
+      *
+      * Must only be called by the writer of the owning store.
+      *
+      * @param slot Store slot of the e-bike
+      * @param reading The reading to record
+      */
+     void append(std::size_t slot, const TelemetryReading& reading) {
+         std::size_t blockIndex = slot / BlockBikes;
+         if (blockIndex >= _blocks.size()) {
+             return;
+         }
+         Block* block = _blocks[blockIndex].load(std::memory_order_relaxed);
+         if (!block) {
+             block = new Block(_points);
+             _blocks[blockIndex].store(block, std::memory_order_release);
+         }
+         std::size_t index = slot % BlockBikes;
+         Ring& ring = block->rings[index];
+         Entry* entries = block->entries.get() + index * _points;
+
+         uint32_t sequence = ring.sequence.load(std::memory_order_relaxed);
+         ring.sequence.store(sequence + 1, std::memory_order_relaxed);
+         std::atomic_thread_fence(std::memory_order_release);
+
+         uint64_t written = ring.written.load(std::memory_order_relaxed);
+         Entry& entry = entries[written % _points];
+         entry.timestampMs.store(reading.timestampMs, std::memory_order_relaxed);
+         entry.latitudeE6.store(reading.latitudeE6, std::memory_order_relaxed);
+         entry.longitudeE6.store(reading.longitudeE6, std::memory_order_relaxed);
+         ring.written.store(written + 1, std::memory_order_relaxed);
+
+         ring.sequence.store(sequence + 2, std::memory_order_release);
+     }
+
+     /**
+      * @brief Copy the recorded positions of an e-bike within a time range
+      *
+      * Safe to call from any thread while the writer appends.
+      *
+      * @param slot Store slot of the e-bike
+      * @param fromMs Earliest reading time to include
+      * @param toMs Latest reading time to include
+      * @param out Receives the positions, oldest first; cleared first
+      * @return Number of positions copied
+      */
+     std::size_t read(std::size_t slot, int64_t fromMs, int64_t toMs, std::vector<TrackSample>& out) const {
+         out.clear();
+         std::size_t blockIndex = slot / BlockBikes;
+         const Block* block = blockIndex < _blocks.size() ? _blocks[blockIndex].load(std::memory_order_acquire) : nullptr;
+         if (!block) {
+             return 0;
+         }
+         std::size_t index = slot % BlockBikes;
+         const Ring& ring = block->rings[index];
+         const Entry* entries = block->entries.get() + index * _points;
+         out.reserve(_points);
+
+         for (;;) {
+             uint32_t before = ring.sequence.load(std::memory_order_acquire);
+             if (before % 2 == 0) {
+                 uint64_t written = ring.written.load(std::memory_order_relaxed);
+                 uint64_t first = written > _points ? written - _points : 0;
+                 for (uint64_t i = first; i < written; ++i) {
+                     const Entry& entry = entries[i % _points];
+                     TrackSample sample;
+                     sample.timestampMs = entry.timestampMs.load(std::memory_order_relaxed);
+                     sample.latitudeE6 = entry.latitudeE6.load(std::memory_order_relaxed);
+                     sample.longitudeE6 = entry.longitudeE6.load(std::memory_order_relaxed);
+                     if (sample.timestampMs >= fromMs && sample.timestampMs <= toMs) {
+                         out.push_back(sample);
+                     }
+                 }
+                 std::atomic_thread_fence(std::memory_order_acquire);
+                 if (ring.sequence.load(std::memory_order_relaxed) == before) {
+                     return out.size();
+                 }
+                 out.clear();
+             }
+         }
+     }
+
+     /**
+      * @brief Get the number of positions kept per e-bike
+      * @return The ring capacity
+      */
+     std::size_t pointsPerBike() const {
+         return _points;
+     }
+
+     /**
+      * @brief Get the memory reserved for rings so far
+      * @return Bytes held by allocated blocks
+      */
+     std::size_t bytesReserved() const {
+         std::size_t blocks = 0;
+         for (const std::atomic<Block*>& block : _blocks) {
+             blocks += block.load(std::memory_order_relaxed) ? 1 : 0;
+         }
+         return blocks * BlockBikes * (sizeof(Ring) + _points * sizeof(Entry));
+     }
+
+     ~TrackHistory() {
+         for (std::atomic<Block*>& block : _blocks) {
+             delete block.load(std::memory_order_relaxed);
+         }
+     }
+
+ private:
+     /**
+      * @struct Entry
+      * @brief Stored position; fields are atomics so torn reads are well defined
+      */
+     struct Entry {
+         std::atomic<int64_t> timestampMs{0};
+         std::atomic<int32_t> latitudeE6{0};
+         std::atomic<int32_t> longitudeE6{0};
+     };
+
+     /**
+      * @struct Ring
+      * @brief Seqlock and write position of one e-bike's ring
+      */
+     struct Ring {
+         std::atomic<uint32_t> sequence{0};  ///< Odd while an append is in progress
+         std::atomic<uint64_t> written{0};   ///< Positions appended since the e-bike joined
+     };
+
+     /**
+      * @struct Block
+      * @brief Rings of BlockBikes consecutive slots and their entries
+      */
+     struct Block {
+         explicit Block(std::size_t points)
+             : rings(new Ring[BlockBikes]), entries(new Entry[BlockBikes * points]) {}
+
+         std::unique_ptr<Ring[]> rings;
+         std::unique_ptr<Entry[]> entries;
+     };
+
+     std::size_t _points;                      ///< Ring capacity per e-bike
+     std::vector<std::atomic<Block*>> _blocks; ///< Blocks by slot / BlockBikes; fixed length
+ };
+
+ #endif // TRACK_HISTORY_H
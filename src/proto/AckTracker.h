@@ -0,0 +1,87 @@
+/**
+ * @file AckTracker.h
+ * @brief Per-bike record of received sequence numbers for cumulative and selective ACKs
+ * @date October 2026
+ */
+
+ #ifndef ACK_TRACKER_H
+ #define ACK_TRACKER_H
+
+ #include <unordered_map>
+ #include <cstdint>
+
+ /**
+  * @class AckTracker
+  * @brief Tracks which sequence numbers of each e-bike have arrived
+  *
+  * For every e-bike it keeps the highest sequence number up to which
+  * everything was received (the cumulative ACK) and a 64-bit bitmap of
+  * the sequence numbers received beyond it (the selective ACK). Clients
+  * with many readings in flight use both to retransmit only what was lost.
+  *
+  * Sequence numbers start at 1. A reading with sequence number 1 after the
+  * window has moved on starts a new session, as happens when a client
+  * restarts. Only sequence numbers that arrived are ever acknowledged: a
+  * reading beyond the bitmap is not recorded, so the client sends it again
+  * once the missing ones before it have arrived. Clients keep the span of
+  * their unacknowledged readings within WindowSize so this stays rare.
+  */
+ class AckTracker {
+ public:
+     static constexpr uint32_t WindowSize = 64; ///< Sequence numbers tracked beyond the cumulative ACK
+
+     /**
+      * @struct State
+      * @brief Acknowledgment state of one e-bike
+      */
+     struct State {
+         uint32_t cumulative = 0; ///< Everything up to and including this was received
+         uint64_t selective = 0;  ///< Bit i: cumulative + 1 + i was received
+     };
+
+     /**
+      * @brief Record the arrival of a sequence number
+      * @param ebikeId The e-bike that sent it
+      * @param sequence The sequence number
+      * @return The acknowledgment state after recording it
+      */
+     State receive(int ebikeId, uint32_t sequence) {
+         State& state = _states[ebikeId];
+
+         if (sequence == 1 && state.cumulative > WindowSize) {
+             state = State();
+         }
+         if (sequence <= state.cumulative) {
+             return state; // Duplicate
+         }
+
+         // Beyond the window; moving it would acknowledge the missing readings before this one
+         uint32_t offset = sequence - state.cumulative - 1;
+         if (offset >= WindowSize) {
+             return state;
+         }
+         state.selective |= uint64_t(1) << offset;
+
+         // Advance the cumulative ACK over every contiguous sequence number
+         while (state.selective & 1) {
+             state.selective >>= 1;
+             ++state.cumulative;
+         }
+         return state;
+     }
+
+     /**
+      * @brief Get the acknowledgment state of an e-bike
+      * @param ebikeId The e-bike
+      * @return The state; zero for e-bikes that never sent a sequence number
+      */
+     State state(int ebikeId) const {
+         auto it = _states.find(ebikeId);
+         return it == _states.end() ? State() : it->second;
+     }
+
+ private:
+     std::unordered_map<int, State> _states; ///< e-bike ID -> acknowledgment state
+ };
+
+ #endif // ACK_TRACKER_H
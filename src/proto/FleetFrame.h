@@ -0,0 +1,351 @@
+/**
+ * @file FleetFrame.h
+ * @brief Compact binary frames pushing fleet positions to dashboards
+ * @date October 2026
+ */
+
+ #ifndef FLEET_FRAME_H
+ #define FLEET_FRAME_H
+
+ #include <cstdlib>
+ #include <vector>
+ #include <cstddef>
+ #include <cstdint>
+ #include "fleet/FleetSnapshot.h"
+ #include "proto/TelemetryFrame.h"
+
+ /**
+  * @class FleetFrame
+  * @brief Layout of keyframes and delta frames, and a decoder for them
+  *
+  * Frames start with a 32-byte header, all integers little-endian:
+  *
+  *   offset  size  field
+  *        0     4  magic 0xEB 0x1E, format version, frame type
+  *        4     8  fleet version the frame brings the receiver to
+  *       12     8  base version: the version a delta applies to; 0 for keyframes
+  *       20     2  quantum of delta entries in microdegrees
+  *       22     2  reserved, zero
+  *       24     4  number of absolute entries A
+  *       28     4  number of delta entries D
+  *
+  * followed by A absolute entries of 17 bytes:
+  *
+  *        0     4  slot
+  *        4     4  e-bike ID
+  *        8     4  latitude, microdegrees
+  *       12     4  longitude, microdegrees
+  *       16     1  status (0 unlocked, 1 locked, 2 maintenance)
+  *
+  * and D delta entries of 9 bytes:
+  *
+  *        0     4  slot
+  *        4     2  latitude change, signed, in quanta
+  *        6     2  longitude change, signed, in quanta
+  *        8     1  status
+  *
+  * A keyframe lists every e-bike and replaces whatever the receiver held.
+  * A delta only lists the e-bikes that moved by at least half a quantum or
+  * changed status; e-bikes that joined, or jumped further than a delta can
+  * carry, come as absolute entries. Slots are dense and never reused, so a
+  * receiver can keep positions in arrays indexed by slot. A combined
+  * snapshot can move e-bikes to other slots when one joins an earlier
+  * shard; no delta spans such a move, the sender starts over with a
+  * keyframe instead (see FleetFrameEncoder::canDelta). Deltas are
+  * relative to the positions the receiver was sent, not to the true ones,
+  * so rounding errors never add up beyond half a quantum.
+  */
+ class FleetFrame {
+ public:
+     static constexpr uint8_t TypeKeyframe = 4;             ///< Every e-bike, absolute
+     static constexpr uint8_t TypeDelta = 5;                ///< Changes since the base version
+     static constexpr std::size_t HeaderSize = 32;          ///< Size of the frame header
+     static constexpr std::size_t AbsoluteEntrySize = 17;   ///< Size of an absolute entry
+     static constexpr std::size_t DeltaEntrySize = 9;       ///< Size of a delta entry
+     static constexpr int32_t DefaultQuantumE6 = 10;        ///< About 1.1 m of latitude
+
+     /**
+      * @struct View
+      * @brief Fleet as a receiver of frames sees it
+      */
+     struct View {
+         uint64_t version = 0;              ///< Version of the last applied frame
+         std::vector<int32_t> ids;          ///< e-bike ID per slot
+         std::vector<int32_t> latitudes;    ///< Latitude in microdegrees per slot
+         std::vector<int32_t> longitudes;   ///< Longitude in microdegrees per slot
+         std::vector<uint8_t> statuses;     ///< Status byte per slot
+     };
+
+     /**
+      * @brief Apply a frame to a view
+      * @param data The frame
+      * @param size Size of the frame in bytes
+      * @param view The view; left unchanged if the frame is malformed or a delta for another version
+      * @return true if the frame was applied
+      */
+     static bool apply(const uint8_t* data, std::size_t size, View& view) {
+         if (size < HeaderSize || data[0] != TelemetryFrame::Magic0 || data[1] != TelemetryFrame::Magic1
+             || data[2] != TelemetryFrame::Version || (data[3] != TypeKeyframe && data[3] != TypeDelta)) {
+             return false;
+         }
+         bool keyframe = data[3] == TypeKeyframe;
+         uint64_t version = get64(data + 4);
+         uint64_t base = get64(data + 12);
+         int32_t quantum = get16(data + 20);
+         uint32_t absolutes = get32(data + 24);
+         uint32_t deltas = get32(data + 28);
+         if ((!keyframe && base != view.version)
+             || size != HeaderSize + absolutes * AbsoluteEntrySize + static_cast<std::size_t>(deltas) * DeltaEntrySize) {
+             return false;
+         }
+
+         // Check every slot before touching the view. Slots are dense, so absolute
+         // entries can only add slots right after those already held.
+         std::size_t held = keyframe ? 0 : view.ids.size();
+         std::size_t resulting = held;
+         const uint8_t* entry = data + HeaderSize;
+         for (uint32_t i = 0; i < absolutes; ++i, entry += AbsoluteEntrySize) {
+             std::size_t slot = get32(entry);
+             if (slot >= held + absolutes) {
+                 return false;
+             }
+             resulting = slot >= resulting ? slot + 1 : resulting;
+         }
+         for (uint32_t i = 0; i < deltas; ++i, entry += DeltaEntrySize) {
+             if (get32(entry) >= resulting) {
+                 return false;
+             }
+         }
+
+         if (keyframe) {
+             view = View();
+         }
+         view.ids.resize(resulting, 0);
+         view.latitudes.resize(resulting, 0);
+         view.longitudes.resize(resulting, 0);
+         view.statuses.resize(resulting, 0);
+         entry = data + HeaderSize;
+         for (uint32_t i = 0; i < absolutes; ++i, entry += AbsoluteEntrySize) {
+             std::size_t slot = get32(entry);
+             view.ids[slot] = static_cast<int32_t>(get32(entry + 4));
+             view.latitudes[slot] = static_cast<int32_t>(get32(entry + 8));
+             view.longitudes[slot] = static_cast<int32_t>(get32(entry + 12));
+             view.statuses[slot] = entry[16];
+         }
+         for (uint32_t i = 0; i < deltas; ++i, entry += DeltaEntrySize) {
+             std::size_t slot = get32(entry);
+             view.latitudes[slot] += static_cast<int16_t>(get16(entry + 4)) * quantum;
+             view.longitudes[slot] += static_cast<int16_t>(get16(entry + 6)) * quantum;
+             view.statuses[slot] = entry[8];
+         }
+         view.version = version;
+         return true;
+     }
+
+ protected:
+     static void put16(uint8_t* out, uint16_t value) {
+         out[0] = static_cast<uint8_t>(value);
+         out[1] = static_cast<uint8_t>(value >> 8);
+     }
+
+     static void put32(uint8_t* out, uint32_t value) {
+         put16(out, static_cast<uint16_t>(value));
+         put16(out + 2, static_cast<uint16_t>(value >> 16));
+     }
+
+     static void put64(uint8_t* out, uint64_t value) {
+         put32(out, static_cast<uint32_t>(value));
+         put32(out + 4, static_cast<uint32_t>(value >> 32));
+     }
+
+     static uint16_t get16(const uint8_t* in) {
+         return static_cast<uint16_t>(in[0] | (in[1] << 8));
+     }
+
+     static uint32_t get32(const uint8_t* in) {
+         return get16(in) | (static_cast<uint32_t>(get16(in + 2)) << 16);
+     }
+
+     static uint64_t get64(const uint8_t* in) {
+         return get32(in) | (static_cast<uint64_t>(get32(in + 4)) << 32);
+     }
+ };
+
+ /**
+  * @class FleetFrameEncoder
+  * @brief Turns successive snapshots into a chain of keyframes and deltas
+  *
+  * The encoder remembers the positions its frames have told receivers, so
+  * every receiver that applied the whole chain holds exactly its view. It
+  * has one writer and is not thread-safe.
+  */
+ class FleetFrameEncoder : public FleetFrame {
+ public:
+     /**
+      * @brief Constructor for FleetFrameEncoder
+      * @param quantumE6 Resolution of delta entries in microdegrees, 1 to 65535
+      */
+     explicit FleetFrameEncoder(int32_t quantumE6 = DefaultQuantumE6)
+         : _quantum(quantumE6 >= 1 && quantumE6 <= 0xFFFF ? quantumE6 : DefaultQuantumE6) {}
+
+     /**
+      * @brief Get the version of the last encoded frame
+      * @return The version; 0 before the first keyframe
+      */
+     uint64_t version() const {
+         return _view.version;
+     }
+
+     /**
+      * @brief Encode every e-bike of a snapshot, exactly, and continue the chain from it
+      * @param snapshot The snapshot
+      * @param out Receives the frame; replaced
+      */
+     void encodeKeyframe(const FleetSnapshot& snapshot, std::vector<uint8_t>& out) {
+         _view.version = snapshot.version();
+         _view.ids = snapshot.ids();
+         _view.latitudes = snapshot.latitudes();
+         _view.longitudes = snapshot.longitudes();
+         _view.statuses.resize(snapshot.size());
+         for (std::size_t slot = 0; slot < snapshot.size(); ++slot) {
+             _view.statuses[slot] = static_cast<uint8_t>(snapshot.statuses()[slot]);
+         }
+         encodeView(out);
+     }
+
+     /**
+      * @brief Encode the current view as a keyframe, for a receiver joining the chain
+      * @param out Receives the frame; replaced
+      */
+     void encodeView(std::vector<uint8_t>& out) const {
+         std::size_t count = _view.ids.size();
+         out.resize(HeaderSize + count * AbsoluteEntrySize);
+         putHeader(out.data(), TypeKeyframe, _view.version, 0, count, 0);
+         uint8_t* entry = out.data() + HeaderSize;
+         for (std::size_t slot = 0; slot < count; ++slot, entry += AbsoluteEntrySize) {
+             putAbsolute(entry, slot);
+         }
+     }
+
+     /**
+      * @brief Check whether a snapshot can be sent as a delta on the current view
+      * @param snapshot A snapshot newer than the view
+      * @return false if the view is empty or slots have moved since its version,
+      *         in which case only a keyframe brings receivers up to date
+      */
+     bool canDelta(const FleetSnapshot& snapshot) const {
+         return _view.version > 0 && snapshot.layoutVersion() <= _view.version;
+     }
+
+     /**
+      * @brief Encode the changes between the current view and a newer snapshot
+      *
+      * Only the slots the snapshot stamps as changed since the view's version
+      * are looked at. When none of them moved by half a quantum or more, or
+      * changed status, nothing is encoded and the view keeps its version, so
+      * the small moves are picked up by a later delta. The caller checks
+      * canDelta() first.
+      *
+      * @param snapshot A snapshot newer than the view
+      * @param out Receives the frame; replaced
+      * @return false if there was nothing to send
+      */
+     bool encodeDelta(const FleetSnapshot& snapshot, std::vector<uint8_t>& out) {
+         snapshot.changedSince(_view.version, snapshot.size(), _changed);
+         _absolutes.clear();
+         _deltas.clear();
+         for (std::size_t slot : _changed) {
+             uint8_t status = static_cast<uint8_t>(snapshot.statuses()[slot]);
+             if (slot >= _view.ids.size()) {
+                 _view.ids.push_back(snapshot.ids()[slot]);
+                 _view.latitudes.push_back(snapshot.latitudes()[slot]);
+                 _view.longitudes.push_back(snapshot.longitudes()[slot]);
+                 _view.statuses.push_back(status);
+                 _absolutes.push_back(slot);
+                 continue;
+             }
+             int64_t latitudeSteps = steps(static_cast<int64_t>(snapshot.latitudes()[slot]) - _view.latitudes[slot]);
+             int64_t longitudeSteps = steps(static_cast<int64_t>(snapshot.longitudes()[slot]) - _view.longitudes[slot]);
+             if (latitudeSteps == 0 && longitudeSteps == 0 && status == _view.statuses[slot]) {
+                 continue;
+             }
+             _view.statuses[slot] = status;
+             if (std::llabs(latitudeSteps) > 0x7FFF || std::llabs(longitudeSteps) > 0x7FFF) {
+                 _view.latitudes[slot] = snapshot.latitudes()[slot];
+                 _view.longitudes[slot] = snapshot.longitudes()[slot];
+                 _absolutes.push_back(slot);
+                 continue;
+             }
+             _view.latitudes[slot] += static_cast<int32_t>(latitudeSteps * _quantum);
+             _view.longitudes[slot] += static_cast<int32_t>(longitudeSteps * _quantum);
+             _deltas.push_back({static_cast<uint32_t>(slot), static_cast<int16_t>(latitudeSteps),
+                                static_cast<int16_t>(longitudeSteps)});
+         }
+         if (_absolutes.empty() && _deltas.empty()) {
+             return false;
+         }
+
+         uint64_t base = _view.version;
+         _view.version = snapshot.version();
+         out.resize(HeaderSize + _absolutes.size() * AbsoluteEntrySize + _deltas.size() * DeltaEntrySize);
+         putHeader(out.data(), TypeDelta, _view.version, base, _absolutes.size(), _deltas.size());
+         uint8_t* entry = out.data() + HeaderSize;
+         for (std::size_t slot : _absolutes) {
+             putAbsolute(entry, slot);
+             entry += AbsoluteEntrySize;
+         }
+         for (const Delta& delta : _deltas) {
+             put32(entry, delta.slot);
+             put16(entry + 4, static_cast<uint16_t>(delta.latitudeSteps));
+             put16(entry + 6, static_cast<uint16_t>(delta.longitudeSteps));
+             entry[8] = _view.statuses[delta.slot];
+             entry += DeltaEntrySize;
+         }
+         return true;
+     }
+
+ private:
+     /**
+      * @struct Delta
+      * @brief A delta entry before encoding
+      */
+     struct Delta {
+         uint32_t slot;
+         int16_t latitudeSteps;
+         int16_t longitudeSteps;
+     };
+
+     /// Round a change in microdegrees to the nearest number of quanta
+     int64_t steps(int64_t change) const {
+         return change >= 0 ? (change + _quantum / 2) / _quantum : -((-change + _quantum / 2) / _quantum);
+     }
+
+     void putHeader(uint8_t* out, uint8_t type, uint64_t version, uint64_t base, std::size_t absolutes, std::size_t deltas) const {
+         out[0] = TelemetryFrame::Magic0;
+         out[1] = TelemetryFrame::Magic1;
+         out[2] = TelemetryFrame::Version;
+         out[3] = type;
+         put64(out + 4, version);
+         put64(out + 12, base);
+         put16(out + 20, static_cast<uint16_t>(_quantum));
+         put16(out + 22, 0);
+         put32(out + 24, static_cast<uint32_t>(absolutes));
+         put32(out + 28, static_cast<uint32_t>(deltas));
+     }
+
+     void putAbsolute(uint8_t* out, std::size_t slot) const {
+         put32(out, static_cast<uint32_t>(slot));
+         put32(out + 4, static_cast<uint32_t>(_view.ids[slot]));
+         put32(out + 8, static_cast<uint32_t>(_view.latitudes[slot]));
+         put32(out + 12, static_cast<uint32_t>(_view.longitudes[slot]));
+         out[16] = _view.statuses[slot];
+     }
+
+     int32_t _quantum;                    ///< Microdegrees per delta step
+     View _view;                          ///< What receivers of the chain hold
+     std::vector<std::size_t> _changed;   ///< Scratch: slots changed since the view
+     std::vector<std::size_t> _absolutes; ///< Scratch: slots sent as absolute entries
+     std::vector<Delta> _deltas;          ///< Scratch: delta entries
+ };
+
+ #endif // FLEET_FRAME_H
@@ -0,0 +1,180 @@
+/**
+ * @file SendWindow.h
+ * @brief Client-side window of unacknowledged telemetry datagrams
+ * @date October 2026
+ */
+
+ #ifndef SEND_WINDOW_H
+ #define SEND_WINDOW_H
+
+ #include <algorithm>
+ #include <chrono>
+ #include <deque>
+ #include <vector>
+ #include <cstddef>
+ #include <cstdint>
+
+ /**
+  * @class SendWindow
+  * @brief Keeps sent datagrams until the gateway acknowledges them
+  *
+  * Each datagram covers a contiguous range of sequence numbers (one for a
+  * single reading, several for a batch). Up to capacity() datagrams may be
+  * in flight at once. Acknowledgments remove every datagram whose readings
+  * are all covered by the cumulative ACK or the selective ACK bitmap;
+  * datagrams that stay unacknowledged past the retransmission timeout are
+  * sent again, and dropped after a maximum number of attempts. An optional
+  * span limit keeps new sequence numbers within the gateway's ACK window
+  * (AckTracker::WindowSize past the highest cumulative ACK seen).
+  */
+ class SendWindow {
+ public:
+     typedef std::chrono::steady_clock Clock;
+
+     /**
+      * @brief Constructor for SendWindow
+      * @param capacity Maximum number of datagrams in flight
+      * @param timeout Time after which an unacknowledged datagram is retransmitted
+      * @param maxAttempts Number of transmissions after which a datagram is dropped
+      * @param maxSpan Sequence numbers that may be sent past the cumulative ACK; 0 for no limit
+      */
+     SendWindow(std::size_t capacity, std::chrono::milliseconds timeout, int maxAttempts = 10, uint32_t maxSpan = 0)
+         : _capacity(capacity > 0 ? capacity : 1), _timeout(timeout), _maxAttempts(maxAttempts), _maxSpan(maxSpan) {}
+
+     std::size_t capacity() const { return _capacity; }
+     std::size_t size() const { return _inFlight.size(); }
+     bool full() const { return _inFlight.size() >= _capacity; }
+     bool empty() const { return _inFlight.empty(); }
+
+     /**
+      * @brief Check whether a sequence number lies within the span limit
+      * @param sequence The sequence number
+      * @return true if the gateway can acknowledge it without the cumulative ACK moving first
+      */
+     bool admits(uint32_t sequence) const {
+         return _maxSpan == 0 || sequence <= _acknowledged + _maxSpan;
+     }
+
+     /**
+      * @brief Forget the cumulative ACK, when the client starts its sequence numbers over
+      */
+     void restartSequence() {
+         _acknowledged = 0;
+     }
+
+     /**
+      * @brief Record a datagram that has just been sent
+      * @param firstSequence First sequence number it carries
+      * @param lastSequence Last sequence number it carries
+      * @param data The datagram bytes
+      * @param size Size of the datagram
+      * @param now Time it was sent
+      */
+     void push(uint32_t firstSequence, uint32_t lastSequence, const void* data, std::size_t size, Clock::time_point now) {
+         const uint8_t* bytes = static_cast<const uint8_t*>(data);
+         _inFlight.push_back(Datagram{firstSequence, lastSequence, std::vector<uint8_t>(bytes, bytes + size), now, 1});
+     }
+
+     /**
+      * @brief Apply an acknowledgment from the gateway
+      * @param cumulative Every sequence number up to this one was received
+      * @param selective Bit i set means sequence number cumulative + 1 + i was received
+      * @return Number of datagrams removed from the window
+      */
+     std::size_t acknowledge(uint32_t cumulative, uint64_t selective) {
+         _acknowledged = std::max(_acknowledged, cumulative);
+         std::size_t before = _inFlight.size();
+         for (auto it = _inFlight.begin(); it != _inFlight.end();) {
+             if (covered(*it, cumulative, selective)) {
+                 it = _inFlight.erase(it);
+             } else {
+                 ++it;
+             }
+         }
+         return before - _inFlight.size();
+     }
+
+     /**
+      * @brief Acknowledge the oldest datagram, for peers that only reply "OK"
+      */
+     void acknowledgeOldest() {
+         if (!_inFlight.empty()) {
+             _inFlight.pop_front();
+         }
+     }
+
+     /**
+      * @brief Retransmit every datagram whose timeout has expired
+      * @param now The current time
+      * @param send Called as send(const uint8_t* data, std::size_t size) for each datagram
+      * @return Number of datagrams dropped because they ran out of attempts
+      */
+     template <typename Send>
+     std::size_t retransmitExpired(Clock::time_point now, Send&& send) {
+         std::size_t dropped = 0;
+         for (auto it = _inFlight.begin(); it != _inFlight.end();) {
+             if (now - it->sentAt < _timeout) {
+                 ++it;
+             } else if (it->attempts >= _maxAttempts) {
+                 it = _inFlight.erase(it);
+                 ++dropped;
+             } else {
+                 send(it->bytes.data(), it->bytes.size());
+                 it->sentAt = now;
+                 ++it->attempts;
+                 ++it;
+             }
+         }
+         return dropped;
+     }
+
+     /**
+      * @brief Get the time at which the next retransmission is due
+      * @param fallback Returned when nothing is in flight
+      * @return The earliest retransmission deadline
+      */
+     Clock::time_point nextDeadline(Clock::time_point fallback) const {
+         Clock::time_point deadline = fallback;
+         for (const Datagram& datagram : _inFlight) {
+             if (datagram.sentAt + _timeout < deadline) {
+                 deadline = datagram.sentAt + _timeout;
+             }
+         }
+         return deadline;
+     }
+
+ private:
+     /**
+      * @struct Datagram
+      * @brief A sent, unacknowledged datagram
+      */
+     struct Datagram {
+         uint32_t firstSequence;
+         uint32_t lastSequence;
+         std::vector<uint8_t> bytes;
+         Clock::time_point sentAt;
+         int attempts;
+     };
+
+     static bool covered(const Datagram& datagram, uint32_t cumulative, uint64_t selective) {
+         for (uint32_t sequence = datagram.firstSequence; sequence <= datagram.lastSequence; ++sequence) {
+             if (sequence <= cumulative) {
+                 continue;
+             }
+             uint32_t offset = sequence - cumulative - 1;
+             if (offset >= 64 || !(selective & (uint64_t(1) << offset))) {
+                 return false;
+             }
+         }
+         return true;
+     }
+
+     std::size_t _capacity;               ///< Maximum datagrams in flight
+     std::chrono::milliseconds _timeout;  ///< Retransmission timeout
+     int _maxAttempts;                    ///< Transmissions before a datagram is dropped
+     uint32_t _maxSpan;                   ///< Sequence numbers allowed past _acknowledged; 0 for no limit
+     uint32_t _acknowledged = 0;          ///< Highest cumulative ACK seen
+     std::deque<Datagram> _inFlight;      ///< Unacknowledged datagrams, oldest first
+ };
+
+ #endif // SEND_WINDOW_H
@@ -0,0 +1,299 @@
+/**
+ * @file TelemetryFrame.h
+ * @brief Compact binary wire format for e-bike telemetry
+ * @date October 2026
+ */
+
+ #ifndef TELEMETRY_FRAME_H
+ #define TELEMETRY_FRAME_H
+
+ #include <string_view>
+ #include <cstddef>
+ #include <cstdint>
+ #include "fleet/Telemetry.h"
+
+ /**
+  * @class TelemetryFrame
+  * @brief Encoder and decoder for versioned fixed-layout telemetry frames
+  *
+  * A reading frame is 28 bytes, all integers little-endian:
+  *
+  *   offset  size  field
+  *        0     2  magic 0xEB 0x1E (cannot start a JSON message)
+  *        2     1  format version
+  *        3     1  frame type
+  *        4     4  e-bike ID
+  *        8     4  sequence number
+  *       12     8  timestamp, milliseconds since the Unix epoch
+  *       20     4  latitude, microdegrees
+  *       24     4  longitude, microdegrees
+  *
+  * A batch frame carries several readings of one e-bike in one datagram:
+  *
+  *   offset  size  field
+  *        0     4  magic, version, frame type
+  *        4     4  e-bike ID
+  *        8     2  number of readings N
+  *       10     2  reserved, zero
+  *       12  20*N  readings: sequence (4), timestamp (8), latitude (4), longitude (4)
+  *
+  * The gateway answers binary frames with a 20-byte acknowledgment frame:
+  *
+  *   offset  size  field
+  *        0     4  magic, version, frame type
+  *        4     4  e-bike ID
+  *        8     4  cumulative ACK: every sequence number up to this one was received
+  *       12     8  selective ACK: bit i set means sequence cumulative + 1 + i was received
+  *
+  * Receivers tell frames from JSON by the magic bytes, so both formats can
+  * share one port.
+  */
+ class TelemetryFrame {
+ public:
+     static constexpr uint8_t Magic0 = 0xEB;              ///< First magic byte
+     static constexpr uint8_t Magic1 = 0x1E;              ///< Second magic byte
+     static constexpr uint8_t Version = 1;                ///< Current format version
+     static constexpr uint8_t TypeReading = 1;            ///< A single position reading
+     static constexpr uint8_t TypeBatch = 2;              ///< Several readings of one e-bike
+     static constexpr uint8_t TypeAck = 3;                ///< Acknowledgment from the gateway
+     static constexpr std::size_t HeaderSize = 4;         ///< Magic, version and type
+     static constexpr std::size_t ReadingSize = 28;       ///< Size of a reading frame
+     static constexpr std::size_t BatchHeaderSize = 12;   ///< Size of a batch frame before its entries
+     static constexpr std::size_t BatchEntrySize = 20;    ///< Size of one reading in a batch frame
+     static constexpr std::size_t AckSize = 20;           ///< Size of an acknowledgment frame
+     static constexpr std::size_t MaxDatagramSize = 8192; ///< Largest frame a receiver must accept
+
+     /**
+      * @brief Check whether a message is a binary frame rather than JSON
+      * @param message The raw message
+      * @return true if the message starts with the frame magic
+      */
+     static bool isFrame(std::string_view message) {
+         return message.size() >= HeaderSize && static_cast<uint8_t>(message[0]) == Magic0
+             && static_cast<uint8_t>(message[1]) == Magic1;
+     }
+
+     /**
+      * @brief Encode a reading frame
+      * @param reading The reading to encode, including its sequence number
+      * @param out Buffer of at least ReadingSize bytes
+      * @return Number of bytes written
+      */
+     static std::size_t encodeReading(const TelemetryReading& reading, uint8_t* out) {
+         out[0] = Magic0;
+         out[1] = Magic1;
+         out[2] = Version;
+         out[3] = TypeReading;
+         put32(out + 4, static_cast<uint32_t>(reading.ebikeId));
+         put32(out + 8, reading.sequence);
+         put64(out + 12, static_cast<uint64_t>(reading.timestampMs));
+         put32(out + 20, static_cast<uint32_t>(reading.latitudeE6));
+         put32(out + 24, static_cast<uint32_t>(reading.longitudeE6));
+         return ReadingSize;
+     }
+
+     /**
+      * @brief Get the frame type of a binary frame
+      * @param message A message for which isFrame() is true
+      * @return The frame type byte
+      */
+     static uint8_t type(std::string_view message) {
+         return static_cast<uint8_t>(message[3]);
+     }
+
+     /**
+      * @brief Get the e-bike ID of a reading or batch frame without decoding it
+      * @param message A message for which isFrame() is true
+      * @param ebikeId Receives the e-bike ID
+      * @return false if the message is too short to carry one
+      */
+     static bool peekEbikeId(std::string_view message, int& ebikeId) {
+         if (message.size() < 8) {
+             return false;
+         }
+         ebikeId = static_cast<int32_t>(get32(reinterpret_cast<const uint8_t*>(message.data()) + 4));
+         return true;
+     }
+
+     /**
+      * @brief Get the number of readings that fit in a batch frame
+      * @param datagramSize Maximum size of the datagram in bytes
+      * @return The maximum number of readings, at least 1
+      */
+     static std::size_t batchCapacity(std::size_t datagramSize) {
+         std::size_t capacity = datagramSize > BatchHeaderSize ? (datagramSize - BatchHeaderSize) / BatchEntrySize : 0;
+         if (capacity > 0xFFFF) {
+             capacity = 0xFFFF;
+         }
+         return capacity > 0 ? capacity : 1;
+     }
+
+     /**
+      * @brief Encode a batch frame
+      * @param ebikeId The e-bike that took every reading
+      * @param readings The readings, including their sequence numbers
+      * @param count Number of readings (at most 65535)
+      * @param out Buffer of at least BatchHeaderSize + count * BatchEntrySize bytes
+      * @return Number of bytes written
+      */
+     static std::size_t encodeBatch(int ebikeId, const TelemetryReading* readings, std::size_t count, uint8_t* out) {
+         out[0] = Magic0;
+         out[1] = Magic1;
+         out[2] = Version;
+         out[3] = TypeBatch;
+         put32(out + 4, static_cast<uint32_t>(ebikeId));
+         put16(out + 8, static_cast<uint16_t>(count));
+         put16(out + 10, 0);
+
+         uint8_t* entry = out + BatchHeaderSize;
+         for (std::size_t i = 0; i < count; ++i, entry += BatchEntrySize) {
+             put32(entry, readings[i].sequence);
+             put64(entry + 4, static_cast<uint64_t>(readings[i].timestampMs));
+             put32(entry + 12, static_cast<uint32_t>(readings[i].latitudeE6));
+             put32(entry + 16, static_cast<uint32_t>(readings[i].longitudeE6));
+         }
+         return BatchHeaderSize + count * BatchEntrySize;
+     }
+
+     /**
+      * @brief Decode a batch frame, passing every reading to a callback
+      *
+      * The whole frame is validated before the first reading is delivered,
+      * so a malformed batch is rejected without being partially applied.
+      *
+      * @param message The raw message
+      * @param apply Called as apply(const TelemetryReading&) for each reading in order
+      * @return The number of readings, or 0 if the frame is malformed
+      */
+     template <typename Apply>
+     static std::size_t decodeBatch(std::string_view message, Apply&& apply) {
+         const uint8_t* in = reinterpret_cast<const uint8_t*>(message.data());
+         if (!isFrame(message) || in[2] != Version || in[3] != TypeBatch || message.size() < BatchHeaderSize) {
+             return 0;
+         }
+         std::size_t count = get16(in + 8);
+         if (count == 0 || message.size() != BatchHeaderSize + count * BatchEntrySize) {
+             return 0;
+         }
+         const uint8_t* entry = in + BatchHeaderSize;
+         for (std::size_t i = 0; i < count; ++i, entry += BatchEntrySize) {
+             if (!validCoordinates(static_cast<int32_t>(get32(entry + 12)), static_cast<int32_t>(get32(entry + 16)))) {
+                 return 0;
+             }
+         }
+
+         TelemetryReading reading;
+         reading.ebikeId = static_cast<int32_t>(get32(in + 4));
+         entry = in + BatchHeaderSize;
+         for (std::size_t i = 0; i < count; ++i, entry += BatchEntrySize) {
+             reading.sequence = get32(entry);
+             reading.timestampMs = static_cast<int64_t>(get64(entry + 4));
+             reading.latitudeE6 = static_cast<int32_t>(get32(entry + 12));
+             reading.longitudeE6 = static_cast<int32_t>(get32(entry + 16));
+             apply(reading);
+         }
+         return count;
+     }
+
+     /**
+      * @brief Encode an acknowledgment frame
+      * @param ebikeId The e-bike being acknowledged
+      * @param cumulative Highest sequence number up to which everything was received
+      * @param selective Bitmap of sequence numbers received beyond the cumulative ACK
+      * @param out Buffer of at least AckSize bytes
+      * @return Number of bytes written
+      */
+     static std::size_t encodeAck(int ebikeId, uint32_t cumulative, uint64_t selective, uint8_t* out) {
+         out[0] = Magic0;
+         out[1] = Magic1;
+         out[2] = Version;
+         out[3] = TypeAck;
+         put32(out + 4, static_cast<uint32_t>(ebikeId));
+         put32(out + 8, cumulative);
+         put64(out + 12, selective);
+         return AckSize;
+     }
+
+     /**
+      * @brief Decode an acknowledgment frame
+      * @param message The raw message
+      * @param ebikeId Receives the acknowledged e-bike
+      * @param cumulative Receives the cumulative ACK
+      * @param selective Receives the selective ACK bitmap
+      * @return false if the message is not a well-formed acknowledgment frame
+      */
+     static bool decodeAck(std::string_view message, int& ebikeId, uint32_t& cumulative, uint64_t& selective) {
+         const uint8_t* in = reinterpret_cast<const uint8_t*>(message.data());
+         if (!isFrame(message) || in[2] != Version || in[3] != TypeAck || message.size() != AckSize) {
+             return false;
+         }
+         ebikeId = static_cast<int32_t>(get32(in + 4));
+         cumulative = get32(in + 8);
+         selective = get64(in + 12);
+         return true;
+     }
+
+     /**
+      * @brief Decode a reading frame
+      * @param message The raw message
+      * @param reading Receives the decoded reading
+      * @return false if the message is not a well-formed reading frame of a known version
+      */
+     static bool decodeReading(std::string_view message, TelemetryReading& reading) {
+         const uint8_t* in = reinterpret_cast<const uint8_t*>(message.data());
+         if (!isFrame(message) || in[2] != Version || in[3] != TypeReading || message.size() != ReadingSize) {
+             return false;
+         }
+         reading.ebikeId = static_cast<int32_t>(get32(in + 4));
+         reading.sequence = get32(in + 8);
+         reading.timestampMs = static_cast<int64_t>(get64(in + 12));
+         reading.latitudeE6 = static_cast<int32_t>(get32(in + 20));
+         reading.longitudeE6 = static_cast<int32_t>(get32(in + 24));
+         return validCoordinates(reading.latitudeE6, reading.longitudeE6);
+     }
+
+ private:
+     static bool validCoordinates(int32_t latitudeE6, int32_t longitudeE6) {
+         return latitudeE6 >= -90000000 && latitudeE6 <= 90000000
+             && longitudeE6 >= -180000000 && longitudeE6 <= 180000000;
+     }
+
+     static void put16(uint8_t* out, uint16_t value) {
+         out[0] = static_cast<uint8_t>(value);
+         out[1] = static_cast<uint8_t>(value >> 8);
+     }
+
+     static uint16_t get16(const uint8_t* in) {
+         return static_cast<uint16_t>(in[0] | (in[1] << 8));
+     }
+
+     static void put32(uint8_t* out, uint32_t value) {
+         for (int i = 0; i < 4; ++i) {
+             out[i] = static_cast<uint8_t>(value >> (8 * i));
+         }
+     }
+
+     static void put64(uint8_t* out, uint64_t value) {
+         for (int i = 0; i < 8; ++i) {
+             out[i] = static_cast<uint8_t>(value >> (8 * i));
+         }
+     }
+
+     static uint32_t get32(const uint8_t* in) {
+         uint32_t value = 0;
+         for (int i = 3; i >= 0; --i) {
+             value = (value << 8) | in[i];
+         }
+         return value;
+     }
+
+     static uint64_t get64(const uint8_t* in) {
+         uint64_t value = 0;
+         for (int i = 7; i >= 0; --i) {
+             value = (value << 8) | in[i];
+         }
+         return value;
+     }
+ };
+
+ #endif // TELEMETRY_FRAME_H
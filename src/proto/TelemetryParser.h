@@ -0,0 +1,206 @@
+/**
+ * @file TelemetryParser.h
+ * @brief Single-pass parser for the JSON telemetry messages sent by ebikeClient
+ * @date October 2026
+ */
+
+ #ifndef TELEMETRY_PARSER_H
+ #define TELEMETRY_PARSER_H
+
+ #include <string_view>
+ #include <charconv>
+ #include <cstdint>
+ #include "fleet/Telemetry.h"
+ #include "util/TimeCodec.h"
+
+ /**
+  * @class TelemetryParser
+  * @brief Hand-written parser for the fixed telemetry schema
+  *
+  * Parses messages of the form
+  * {"ebike_id":N,"timestamp":"YYYY-MM-DDTHH:MM:SS[.fff]Z","gps":{"latitude":x,"longitude":y}}
+  * directly from the receive buffer. Keys may appear in any order and
+  * whitespace is allowed, but anything outside the schema (unknown or
+  * duplicate keys, escaped strings, wrong types) makes parse() return false
+  * so the caller can fall back to a general JSON parser. Nothing is
+  * allocated; numbers are read with std::from_chars.
+  */
+ class TelemetryParser {
+ public:
+     /**
+      * @brief Parse a telemetry message
+      * @param message The raw message
+      * @param reading Receives the decoded reading on success
+      * @return true if the message matched the schema
+      */
+     static bool parse(std::string_view message, TelemetryReading& reading) {
+         Cursor in{message.data(), message.data() + message.size()};
+         bool haveId = false, haveTimestamp = false, haveGps = false;
+
+         if (!in.consume('{')) {
+             return false;
+         }
+         do {
+             std::string_view key;
+             if (!in.string(key) || !in.consume(':')) {
+                 return false;
+             }
+             std::string_view timestamp;
+             if (key == "ebike_id" && !haveId && in.integer(reading.ebikeId)) {
+                 haveId = true;
+             } else if (key == "timestamp" && !haveTimestamp && in.string(timestamp)
+                        && parseTimestamp(timestamp, reading.timestampMs)) {
+                 haveTimestamp = true;
+             } else if (key == "gps" && !haveGps && parseGps(in, reading)) {
+                 haveGps = true;
+             } else {
+                 return false;
+             }
+         } while (in.consume(','));
+
+         return haveId && haveTimestamp && haveGps && in.consume('}') && in.atEnd();
+     }
+
+     /**
+      * @brief Find the e-bike ID of a message without parsing the rest of it
+      *
+      * Used to route a message to the worker owning its e-bike. The result
+      * is only a hint; parse() still validates the whole message.
+      *
+      * @param message The raw message
+      * @param ebikeId Receives the ID that follows the first "ebike_id" key
+      * @return true if an ID was found
+      */
+     static bool peekEbikeId(std::string_view message, int& ebikeId) {
+         std::size_t key = message.find("\"ebike_id\"");
+         if (key == std::string_view::npos) {
+             return false;
+         }
+         Cursor in{message.data() + key + 10, message.data() + message.size()};
+         return in.consume(':') && in.integer(ebikeId);
+     }
+
+     /**
+      * @brief Convert an ISO 8601 UTC timestamp to epoch milliseconds
+      * @param timestamp Timestamp of the form YYYY-MM-DDTHH:MM:SS[.fff]Z
+      * @param timestampMs Receives milliseconds since the Unix epoch
+      * @return true if the timestamp was well formed
+      */
+     static bool parseTimestamp(std::string_view timestamp, int64_t& timestampMs) {
+         return TimeCodec::parse(timestamp, timestampMs);
+     }
+
+ private:
+     /**
+      * @struct Cursor
+      * @brief Read position within the message
+      */
+     struct Cursor {
+         const char* pos;
+         const char* end;
+
+         void skipWhitespace() {
+             while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')) {
+                 ++pos;
+             }
+         }
+
+         bool consume(char expected) {
+             skipWhitespace();
+             if (pos < end && *pos == expected) {
+                 ++pos;
+                 return true;
+             }
+             return false;
+         }
+
+         bool atEnd() {
+             skipWhitespace();
+             return pos == end;
+         }
+
+         // A string without escape sequences
+         bool string(std::string_view& value) {
+             if (!consume('"')) {
+                 return false;
+             }
+             const char* start = pos;
+             while (pos < end && *pos != '"') {
+                 if (*pos == '\\') {
+                     return false;
+                 }
+                 ++pos;
+             }
+             if (pos == end) {
+                 return false;
+             }
+             value = std::string_view(start, static_cast<std::size_t>(pos - start));
+             ++pos;
+             return true;
+         }
+
+         bool integer(int& value) {
+             skipWhitespace();
+             auto result = std::from_chars(pos, end, value);
+             if (result.ec != std::errc() || (result.ptr < end && (*result.ptr == '.' || *result.ptr == 'e'
+                                                                  || *result.ptr == 'E'))) {
+                 return false;
+             }
+             pos = result.ptr;
+             return true;
+         }
+
+         bool number(double& value) {
+             skipWhitespace();
+             // from_chars also accepts inf and nan, which are not JSON
+             if (pos == end || (*pos != '-' && (*pos < '0' || *pos > '9'))) {
+                 return false;
+             }
+             auto result = std::from_chars(pos, end, value);
+             if (result.ec != std::errc()) {
+                 return false;
+             }
+             pos = result.ptr;
+             return true;
+         }
+     };
+
+     /**
+      * @brief Parse the nested "gps" object
+      * @param in The cursor, positioned before the opening brace
+      * @param reading Receives latitude and longitude
+      * @return true if both coordinates were present and valid
+      */
+     static bool parseGps(Cursor& in, TelemetryReading& reading) {
+         bool haveLatitude = false, haveLongitude = false;
+         double latitude = 0.0, longitude = 0.0;
+
+         if (!in.consume('{')) {
+             return false;
+         }
+         do {
+             std::string_view key;
+             if (!in.string(key) || !in.consume(':')) {
+                 return false;
+             }
+             if (key == "latitude" && !haveLatitude && in.number(latitude)
+                 && latitude >= -90.0 && latitude <= 90.0) {
+                 haveLatitude = true;
+             } else if (key == "longitude" && !haveLongitude && in.number(longitude)
+                        && longitude >= -180.0 && longitude <= 180.0) {
+                 haveLongitude = true;
+             } else {
+                 return false;
+             }
+         } while (in.consume(','));
+
+         if (!haveLatitude || !haveLongitude || !in.consume('}')) {
+             return false;
+         }
+         reading.latitudeE6 = toMicrodegrees(latitude);
+         reading.longitudeE6 = toMicrodegrees(longitude);
+         return true;
+     }
+ };
+
+ #endif // TELEMETRY_PARSER_H
@@ -3,16 +3,65 @@
 #include <sys/stat.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/time.h>
 #include <fcntl.h>
 #include <cstring>
 #include <thread>
 #include <algorithm>
+#include <vector>
+#include <sys/uio.h>
 
 namespace sim {
 
 // Initialize the static IP map
 std::unordered_map<std::string, std::string> socket::ip_map;
 
+namespace {
+
+// A translated source address with the path it came from
+struct SourceEntry {
+    char path[sizeof(sockaddr_un::sun_path)];
+    struct ::sockaddr_in addr;
+};
+
+// Address translations and scratch space reused by the batch calls. They are
+// per thread so several threads can share one socket, as with real sockets.
+// Sources are keyed by a hash of their path, so looking one up never builds a string
+struct BatchState {
+    std::unordered_map<uint64_t, SourceEntry> sourceCache;
+    std::unordered_map<uint64_t, struct sockaddr_un> destinationCache;
+    std::vector<struct mmsghdr> headers;
+    std::vector<struct iovec> iovecs;
+    std::vector<struct sockaddr_un> unixAddrs;
+};
+
+thread_local BatchState batchState;
+
+// FNV-1a hash of a socket path
+uint64_t hashPath(const char* path, size_t maxLength) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < maxLength && path[i] != '\0'; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(path[i])) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Point each header at its buffer and address slot
+void prepareHeaders(BatchState& state, unsigned int count) {
+    state.headers.resize(count);
+    state.iovecs.resize(count);
+    state.unixAddrs.resize(count);
+    for (unsigned int i = 0; i < count; ++i) {
+        memset(&state.headers[i], 0, sizeof(state.headers[i]));
+        state.headers[i].msg_hdr.msg_name = &state.unixAddrs[i];
+        state.headers[i].msg_hdr.msg_namelen = sizeof(state.unixAddrs[i]);
+        state.headers[i].msg_hdr.msg_iov = &state.iovecs[i];
+        state.headers[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+}  // namespace
+
 // Constructor
 socket::socket(int domain, int type, int protocol) {
     if (domain != AF_INET || type != SOCK_DGRAM) {
@@ -98,6 +147,61 @@ ssize_t socket::recvfrom(void* buffer, size_t size, int flags, struct ::sockaddr
     return received;
 }
 
+// Receive a batch of datagrams
+int socket::recvmmsg(datagram* datagrams, unsigned int count, int flags) {
+    BatchState& state = batchState;
+    prepareHeaders(state, count);
+    for (unsigned int i = 0; i < count; ++i) {
+        state.iovecs[i].iov_base = datagrams[i].data;
+        state.iovecs[i].iov_len = datagrams[i].size;
+    }
+    
+    // Wait for the first datagram, then take everything already queued
+    int received = ::recvmmsg(sockfd, state.headers.data(), count, flags | MSG_WAITFORONE, nullptr);
+    
+    // Convert the UNIX paths back to IPs and ports
+    for (int i = 0; i < received; ++i) {
+        datagrams[i].length = state.headers[i].msg_len;
+        lookupSource(state.unixAddrs[i].sun_path, datagrams[i].addr);
+    }
+    
+    return received;
+}
+
+// Send a batch of datagrams
+int socket::sendmmsg(const datagram* datagrams, unsigned int count, int flags) {
+    BatchState& state = batchState;
+    prepareHeaders(state, count);
+    for (unsigned int i = 0; i < count; ++i) {
+        state.unixAddrs[i] = lookupDestination(datagrams[i].addr);
+        state.iovecs[i].iov_base = datagrams[i].data;
+        state.iovecs[i].iov_len = datagrams[i].size;
+    }
+    
+    // The kernel may stop early, so keep going until everything is sent
+    unsigned int sent = 0;
+    while (sent < count) {
+        int result = ::sendmmsg(sockfd, state.headers.data() + sent, count - sent, flags);
+        if (result <= 0) {
+            return sent > 0 ? static_cast<int>(sent) : result;
+        }
+        sent += static_cast<unsigned int>(result);
+    }
+    
+    return static_cast<int>(sent);
+}
+
+// Set the receive timeout
+void socket::setReceiveTimeout(int milliseconds) {
+    struct timeval timeout;
+    timeout.tv_sec = milliseconds / 1000;
+    timeout.tv_usec = (milliseconds % 1000) * 1000;
+    
+    if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+        throw std::runtime_error("Failed to set receive timeout");
+    }
+}
+
 // Convert IP and port to a UNIX socket path
 std::string socket::ipPortToPath(const struct ::sockaddr_in& addr) {
     char ipStr[INET_ADDRSTRLEN];
@@ -144,6 +248,46 @@ void socket::pathToIpPort(const std::string& path, struct ::sockaddr_in& addr) {
     ::inet_pton(AF_INET, ipPart.c_str(), &(addr.sin_addr));
 }
 
+// Translate a source path, parsing it only the first time it is seen
+void socket::lookupSource(const char* path, struct ::sockaddr_in& addr) {
+    std::unordered_map<uint64_t, SourceEntry>& sourceCache = batchState.sourceCache;
+    const size_t maxLength = sizeof(SourceEntry::path);
+    uint64_t key = hashPath(path, maxLength);
+    auto it = sourceCache.find(key);
+    if (it == sourceCache.end() || strncmp(it->second.path, path, maxLength) != 0) {
+        // Peers are few and long-lived; start over if the cache keeps growing anyway
+        if (sourceCache.size() >= 65536) {
+            sourceCache.clear();
+        }
+        // A colliding path simply replaces the entry
+        SourceEntry& entry = sourceCache[key];
+        strncpy(entry.path, path, maxLength);
+        pathToIpPort(std::string(path, strnlen(path, maxLength)), entry.addr);
+        addr = entry.addr;
+        return;
+    }
+    addr = it->second.addr;
+}
+
+// Translate a destination, building its path only the first time it is seen
+const struct sockaddr_un& socket::lookupDestination(const struct ::sockaddr_in& addr) {
+    uint64_t key = (static_cast<uint64_t>(addr.sin_addr.s_addr) << 16) | addr.sin_port;
+    std::unordered_map<uint64_t, struct sockaddr_un>& destinationCache = batchState.destinationCache;
+    auto it = destinationCache.find(key);
+    if (it == destinationCache.end()) {
+        if (destinationCache.size() >= 65536) {
+            destinationCache.clear();
+        }
+        struct sockaddr_un unixAddr;
+        memset(&unixAddr, 0, sizeof(unixAddr));
+        unixAddr.sun_family = AF_UNIX;
+        std::string path = ipPortToPath(addr);
+        strncpy(unixAddr.sun_path, path.c_str(), sizeof(unixAddr.sun_path) - 1);
+        it = destinationCache.emplace(key, unixAddr).first;
+    }
+    return it->second;
+}
+
 // Get the IP address for the current thread
 std::string socket::get_ipaddr() {
     // Get the thread ID as a string
@@ -15,6 +15,14 @@
 
 namespace sim {
 
+// One datagram of a batch transfer, the counterpart of struct mmsghdr
+struct datagram {
+    void* data;                 // Payload buffer
+    size_t size;                // Bytes to send, or buffer capacity when receiving
+    size_t length;              // Bytes received
+    struct ::sockaddr_in addr;  // Destination when sending, source when receiving
+};
+
 class socket {
 public:
     // Constructor matching the standard UDP socket constructor
@@ -30,6 +38,17 @@ public:
     // Receive data from any source (standard UDP API)
     ssize_t recvfrom(void* buffer, size_t size, int flags, struct ::sockaddr_in& srcAddr);
 
+    // Receive up to count datagrams in one call. Blocks for the first one only,
+    // then returns whatever else is already queued. Returns the number received, or -1
+    int recvmmsg(datagram* datagrams, unsigned int count, int flags);
+
+    // Send count datagrams with as few calls as possible. Returns the number sent, or -1.
+    // Like sendto, this may be called from several threads at once
+    int sendmmsg(const datagram* datagrams, unsigned int count, int flags);
+
+    // Make recvfrom give up with EAGAIN after the given time (0 blocks forever)
+    void setReceiveTimeout(int milliseconds);
+
 private:
     int sockfd;
     std::string unixPath;
@@ -41,6 +60,12 @@ private:
     // Convert a UNIX socket file path back to sockaddr_in
     void pathToIpPort(const std::string& path, struct ::sockaddr_in& addr);
 
+    // Translate a source path through a per-thread cache of recently seen peers; allocates only for new peers
+    void lookupSource(const char* path, struct ::sockaddr_in& addr);
+
+    // Translate a destination through a per-thread cache of recently seen peers
+    const struct sockaddr_un& lookupDestination(const struct ::sockaddr_in& addr);
+
     // Get the IP address of the current thread
     std::string get_ipaddr();
 
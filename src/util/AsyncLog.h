@@ -0,0 +1,400 @@
+/**
+ * @file AsyncLog.h
+ * @brief Asynchronous, levelled and rate-limited logging
+ * @date October 2026
+ */
+
+ #ifndef ASYNC_LOG_H
+ #define ASYNC_LOG_H
+
+ #include <algorithm>
+ #include <atomic>
+ #include <charconv>
+ #include <chrono>
+ #include <condition_variable>
+ #include <cstdint>
+ #include <cstdio>
+ #include <cstring>
+ #include <memory>
+ #include <mutex>
+ #include <string_view>
+ #include <thread>
+ #include <type_traits>
+ #include <vector>
+ #include "util/SpscQueue.h"
+ #include "util/TimeCodec.h"
+
+ /**
+  * @enum LogLevel
+  * @brief Severity of a log line
+  */
+ enum class LogLevel : uint8_t {
+     Debug,
+     Info,
+     Warn,
+     Error
+ };
+
+ /**
+  * @struct LogRecord
+  * @brief One log line as queued by the thread that wrote it
+  */
+ struct LogRecord {
+     static constexpr std::size_t Capacity = 232; ///< Longest line kept; the rest is cut off
+
+     int64_t timestampMs = 0;   ///< When the line was written
+     LogLevel level = LogLevel::Info;
+     uint16_t length = 0;       ///< Bytes used in text
+     char text[Capacity];       ///< Message, not terminated
+ };
+
+ /**
+  * @class AsyncLog
+  * @brief Process-wide logger that moves all I/O to a background writer
+  *
+  * Each thread that logs gets its own lock-free ring of records, registered
+  * with the logger the first time the thread logs. Writing a line formats it
+  * straight into a ring slot; a background thread drains every ring several
+  * times a second and writes the lines to stdout (Warn and Error to stderr)
+  * with one flush per pass. Lines below the minimum level cost a single
+  * relaxed load. When a ring is full the line is dropped and counted rather
+  * than blocking the caller.
+  */
+ class AsyncLog {
+ public:
+     static constexpr std::size_t RingCapacity = 4096;                   ///< Records buffered per thread
+     static constexpr std::chrono::milliseconds FlushInterval{50};      ///< Writer wake-up period
+
+     /**
+      * @brief Get the process-wide logger, starting its writer on first use
+      * @return The logger
+      */
+     static AsyncLog& instance() {
+         static AsyncLog log;
+         return log;
+     }
+
+     /**
+      * @brief Check whether lines of a level are written
+      * @param level The level
+      * @return true if the level is at or above the minimum
+      */
+     static bool enabled(LogLevel level) {
+         return level >= instance()._minimum.load(std::memory_order_relaxed);
+     }
+
+     /**
+      * @brief Set the minimum level of lines that are written
+      * @param level The new minimum
+      */
+     void setLevel(LogLevel level) {
+         _minimum.store(level, std::memory_order_relaxed);
+     }
+
+     /**
+      * @brief Parse a level name
+      * @param name "debug", "info", "warn" or "error"
+      * @param level Receives the level
+      * @return false if the name is unknown
+      */
+     static bool parseLevel(std::string_view name, LogLevel& level) {
+         for (LogLevel candidate : {LogLevel::Debug, LogLevel::Info, LogLevel::Warn, LogLevel::Error}) {
+             if (name == levelName(candidate)) {
+                 level = candidate;
+                 return true;
+             }
+         }
+         return false;
+     }
+
+     /**
+      * @brief Write out everything queued so far and wait until it is written
+      */
+     void flush() {
+         std::unique_lock<std::mutex> lock(_writerMutex);
+         uint64_t target = _passes + 2;
+         _wake.notify_one();
+         _passDone.wait(lock, [this, target] { return _passes >= target || !_running; });
+     }
+
+     /**
+      * @brief Get the calling thread's ring, creating it on first use
+      * @return The ring; owned jointly by the thread and the writer
+      */
+     SpscQueue<LogRecord>& ring() {
+         thread_local RingHandle handle(*this);
+         return handle.ring->records;
+     }
+
+     /**
+      * @brief Count a line dropped because the calling thread's ring was full
+      */
+     void countDropped() {
+         _dropped.fetch_add(1, std::memory_order_relaxed);
+     }
+
+     ~AsyncLog() {
+         {
+             std::lock_guard<std::mutex> lock(_writerMutex);
+             _running = false;
+         }
+         _wake.notify_one();
+         if (_writer.joinable()) {
+             _writer.join();
+         }
+         drain();
+     }
+
+ private:
+     /**
+      * @struct Ring
+      * @brief Records of one thread and whether that thread has exited
+      */
+     struct Ring {
+         Ring() : records(RingCapacity) {}
+
+         SpscQueue<LogRecord> records;     ///< Lines waiting for the writer
+         std::atomic<bool> closed{false};  ///< The owning thread has exited
+         bool drained = false;             ///< Emptied after closing; writer only
+     };
+
+     /**
+      * @struct RingHandle
+      * @brief Thread-local owner that registers its ring and closes it at thread exit
+      */
+     struct RingHandle {
+         explicit RingHandle(AsyncLog& log) : ring(std::make_shared<Ring>()) {
+             std::lock_guard<std::mutex> lock(log._ringsMutex);
+             log._rings.push_back(ring);
+         }
+         ~RingHandle() {
+             ring->closed.store(true, std::memory_order_release);
+         }
+
+         std::shared_ptr<Ring> ring;
+     };
+
+     AsyncLog() : _writer(&AsyncLog::run, this) {}
+
+     static std::string_view levelName(LogLevel level) {
+         switch (level) {
+             case LogLevel::Debug: return "debug";
+             case LogLevel::Info: return "info";
+             case LogLevel::Warn: return "warn";
+             default: return "error";
+         }
+     }
+
+     /**
+      * @brief Writer loop: drain every ring, then sleep until the next flush interval
+      */
+     void run() {
+         std::unique_lock<std::mutex> lock(_writerMutex);
+         while (_running) {
+             lock.unlock();
+             drain();
+             lock.lock();
+             ++_passes;
+             _passDone.notify_all();
+             _wake.wait_for(lock, FlushInterval);
+         }
+     }
+
+     /**
+      * @brief Write every queued record and forget rings whose threads have exited
+      */
+     void drain() {
+         // Held for the whole pass; it only ever delays a thread's first line
+         std::lock_guard<std::mutex> lock(_ringsMutex);
+
+         bool wroteError = false;
+         for (const std::shared_ptr<Ring>& ring : _rings) {
+             bool closed = ring->closed.load(std::memory_order_acquire);
+             while (LogRecord* record = ring->records.front()) {
+                 wroteError = write(*record) || wroteError;
+                 ring->records.pop();
+             }
+             ring->drained = closed;
+         }
+         _rings.erase(std::remove_if(_rings.begin(), _rings.end(),
+                                     [](const std::shared_ptr<Ring>& ring) { return ring->drained; }),
+                      _rings.end());
+
+         uint64_t dropped = _dropped.exchange(0, std::memory_order_relaxed);
+         if (dropped > 0) {
+             std::fprintf(stderr, "%.*s warn  %llu log line(s) dropped, logging too fast\n",
+                          static_cast<int>(TimeCodec::MillisSize), TimeCodec::formatNow().data(),
+                          static_cast<unsigned long long>(dropped));
+             wroteError = true;
+         }
+
+         std::fflush(stdout);
+         if (wroteError) {
+             std::fflush(stderr);
+         }
+     }
+
+     /**
+      * @brief Write one record
+      * @return true if it went to stderr
+      */
+     static bool write(const LogRecord& record) {
+         bool error = record.level >= LogLevel::Warn;
+         std::string_view name = levelName(record.level);
+         std::fprintf(error ? stderr : stdout, "%.*s %-5.*s %.*s\n",
+                      static_cast<int>(TimeCodec::MillisSize), TimeCodec::formatCached(record.timestampMs).data(),
+                      static_cast<int>(name.size()), name.data(),
+                      static_cast<int>(record.length), record.text);
+         return error;
+     }
+
+     std::atomic<LogLevel> _minimum{LogLevel::Info};   ///< Lines below this level are skipped
+     std::atomic<uint64_t> _dropped{0};                ///< Lines lost to full rings since the last pass
+     std::mutex _ringsMutex;                           ///< Guards _rings; held by the writer during a pass
+     std::vector<std::shared_ptr<Ring>> _rings;        ///< Rings of every thread that has logged
+     std::mutex _writerMutex;                          ///< Guards _running and _passes
+     std::condition_variable _wake;                    ///< Wakes the writer early
+     std::condition_variable _passDone;                ///< Signalled after every writer pass
+     bool _running = true;                             ///< Cleared to stop the writer
+     uint64_t _passes = 0;                             ///< Completed writer passes
+     std::thread _writer;                              ///< Background writer; started last
+ };
+
+ /**
+  * @class LogSite
+  * @brief Per-call-site rate limit of lines per second
+  *
+  * Lines over the limit are skipped without being formatted. The first
+  * line after a suppressed stretch reports how many were skipped.
+  */
+ class LogSite {
+ public:
+     /**
+      * @brief Constructor for LogSite
+      * @param perSecond Lines allowed per second; 0 for no limit
+      */
+     explicit LogSite(uint32_t perSecond) : _perSecond(perSecond) {}
+
+     /**
+      * @brief Decide whether the next line from this site is written
+      * @return true if it is within the limit
+      */
+     bool allow() {
+         if (_perSecond == 0) {
+             return true;
+         }
+         int64_t second = std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+         if (_second.load(std::memory_order_relaxed) != second) {
+             _second.store(second, std::memory_order_relaxed);
+             _count.store(0, std::memory_order_relaxed);
+         }
+         if (_count.fetch_add(1, std::memory_order_relaxed) < _perSecond) {
+             return true;
+         }
+         _suppressed.fetch_add(1, std::memory_order_relaxed);
+         return false;
+     }
+
+     /**
+      * @brief Take the number of lines suppressed since the last call
+      * @return The count
+      */
+     uint64_t takeSuppressed() {
+         // Load first so sites that never hit their limit do not write the shared counter
+         if (_suppressed.load(std::memory_order_relaxed) == 0) {
+             return 0;
+         }
+         return _suppressed.exchange(0, std::memory_order_relaxed);
+     }
+
+ private:
+     uint32_t _perSecond;                 ///< Limit per second
+     std::atomic<int64_t> _second{0};     ///< Second the count belongs to
+     std::atomic<uint32_t> _count{0};     ///< Lines seen in that second
+     std::atomic<uint64_t> _suppressed{0}; ///< Lines skipped since last reported
+ };
+
+ /**
+  * @class LogLine
+  * @brief Formats one line directly into the calling thread's ring
+  *
+  * Created by the EBIKE_LOG macros; the line is committed when the
+  * temporary is destroyed at the end of the statement. Nothing is
+  * allocated and no lock is taken.
+  */
+ class LogLine {
+ public:
+     LogLine(LogLevel level, LogSite& site) {
+         AsyncLog& log = AsyncLog::instance();
+         _ring = &log.ring();
+         _record = _ring->claim();
+         if (!_record) {
+             log.countDropped();
+             return;
+         }
+         _record->timestampMs = TimeCodec::nowMs();
+         _record->level = level;
+         _record->length = 0;
+         if (uint64_t suppressed = site.takeSuppressed()) {
+             *this << "(" << suppressed << " similar line(s) suppressed) ";
+         }
+     }
+
+     ~LogLine() {
+         if (_record) {
+             _ring->commit();
+         }
+     }
+
+     LogLine(const LogLine&) = delete;
+     LogLine& operator=(const LogLine&) = delete;
+
+     LogLine& operator<<(std::string_view text) {
+         if (_record) {
+             std::size_t room = LogRecord::Capacity - _record->length;
+             std::size_t count = text.size() < room ? text.size() : room;
+             std::memcpy(_record->text + _record->length, text.data(), count);
+             _record->length = static_cast<uint16_t>(_record->length + count);
+         }
+         return *this;
+     }
+
+     LogLine& operator<<(const char* text) {
+         return *this << std::string_view(text);
+     }
+
+     LogLine& operator<<(char c) {
+         return *this << std::string_view(&c, 1);
+     }
+
+     template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, char>>>
+     LogLine& operator<<(T value) {
+         char digits[32];
+         std::to_chars_result result;
+         if constexpr (std::is_floating_point_v<T>) {
+             result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, 6);
+         } else if constexpr (std::is_same_v<T, bool>) {
+             return *this << (value ? "true" : "false");
+         } else {
+             result = std::to_chars(digits, digits + sizeof(digits), value);
+         }
+         return *this << std::string_view(digits, static_cast<std::size_t>(result.ptr - digits));
+     }
+
+ private:
+     SpscQueue<LogRecord>* _ring = nullptr;  ///< The calling thread's ring
+     LogRecord* _record = nullptr;           ///< Claimed slot, or nullptr if the ring was full
+ };
+
+ /// Log a line at a level: EBIKE_LOG(LogLevel::Info) << "text " << value;
+ #define EBIKE_LOG(level) EBIKE_LOG_LIMITED(level, 0)
+
+ /// Log a line at a level, at most perSecond times a second from this call site
+ #define EBIKE_LOG_LIMITED(level, perSecond)                                       \
+     if (!AsyncLog::enabled(level)) {                                              \
+     } else if (static LogSite ebikeLogSite(perSecond); !ebikeLogSite.allow()) {   \
+     } else                                                                        \
+         LogLine(level, ebikeLogSite)
+
+ #endif // ASYNC_LOG_H
@@ -0,0 +1,67 @@
+/**
+ * @file BufferPool.h
+ * @brief Fixed set of reusable, equally sized byte buffers
+ * @date October 2026
+ */
+
+ #ifndef BUFFER_POOL_H
+ #define BUFFER_POOL_H
+
+ #include <vector>
+ #include <cstddef>
+
+ /**
+  * @class BufferPool
+  * @brief Hands out buffers carved from one allocation made up front
+  *
+  * acquire() and release() only move pointers on a free stack, so a
+  * steady stream of receives never touches the heap. The pool is owned by
+  * one thread; buffers lent to other threads come back through a queue
+  * and are released by the owner.
+  */
+ class BufferPool {
+ public:
+     /**
+      * @brief Constructor for BufferPool
+      * @param count Number of buffers
+      * @param bufferSize Size of each buffer in bytes
+      */
+     BufferPool(std::size_t count, std::size_t bufferSize)
+         : _bufferSize(bufferSize), _storage(count * bufferSize) {
+         _free.reserve(count);
+         for (std::size_t i = count; i > 0; --i) {
+             _free.push_back(_storage.data() + (i - 1) * bufferSize);
+         }
+     }
+
+     /**
+      * @brief Take a buffer from the pool
+      * @return A buffer of bufferSize() bytes, or nullptr if all are in use
+      */
+     char* acquire() {
+         if (_free.empty()) {
+             return nullptr;
+         }
+         char* buffer = _free.back();
+         _free.pop_back();
+         return buffer;
+     }
+
+     /**
+      * @brief Return a buffer obtained from acquire()
+      * @param buffer The buffer
+      */
+     void release(char* buffer) {
+         _free.push_back(buffer);
+     }
+
+     std::size_t bufferSize() const { return _bufferSize; }
+     std::size_t available() const { return _free.size(); }
+
+ private:
+     std::size_t _bufferSize;     ///< Size of each buffer
+     std::vector<char> _storage;  ///< Memory of every buffer
+     std::vector<char*> _free;    ///< Buffers not in use; capacity covers them all
+ };
+
+ #endif // BUFFER_POOL_H
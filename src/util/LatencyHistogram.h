@@ -0,0 +1,266 @@
+/**
+ * @file LatencyHistogram.h
+ * @brief Log-bucketed latency histograms of the ingest pipeline stages, kept per thread
+ * @date October 2026
+ */
+
+ #ifndef LATENCY_HISTOGRAM_H
+ #define LATENCY_HISTOGRAM_H
+
+ #include <algorithm>
+ #include <atomic>
+ #include <chrono>
+ #include <cstddef>
+ #include <cstdint>
+ #include <cstdio>
+ #include <memory>
+ #include <string>
+ #include <string_view>
+ #include "util/ThreadBlocks.h"
+
+ /**
+  * @class LatencyHistogram
+  * @brief Counts of nanosecond latencies in buckets of bounded relative width
+  *
+  * Values below 32 ns get a bucket each; above that every power of two is
+  * split into 32 equal buckets, so a percentile read back is at most about
+  * 3% above the true value whatever its magnitude. Values from 2^40 ns
+  * (about 18 minutes) up share the last bucket.
+  */
+ class LatencyHistogram {
+ public:
+     static constexpr unsigned SubBucketBits = 5;                              ///< log2 of the buckets per power of two
+     static constexpr uint64_t SubBuckets = uint64_t{1} << SubBucketBits;      ///< Buckets per power of two
+     static constexpr unsigned MaxExponent = 40;                               ///< Values are kept below 2^40 ns
+     static constexpr std::size_t BucketCount = (MaxExponent - SubBucketBits + 1) * SubBuckets;
+
+     /**
+      * @brief Get the bucket of a value
+      * @param nanoseconds The value
+      * @return Index below BucketCount
+      */
+     static std::size_t bucketOf(uint64_t nanoseconds) {
+         nanoseconds = std::min(nanoseconds, (uint64_t{1} << MaxExponent) - 1);
+         if (nanoseconds < SubBuckets) {
+             return static_cast<std::size_t>(nanoseconds);
+         }
+         unsigned exponent = 63u - static_cast<unsigned>(__builtin_clzll(nanoseconds));
+         uint64_t subBucket = (nanoseconds >> (exponent - SubBucketBits)) - SubBuckets;
+         return static_cast<std::size_t>((exponent - SubBucketBits + 1) * SubBuckets + subBucket);
+     }
+
+     /**
+      * @brief Get the largest value counted in a bucket
+      * @param bucket Index below BucketCount
+      * @return The value in nanoseconds
+      */
+     static uint64_t highestOf(std::size_t bucket) {
+         if (bucket < SubBuckets) {
+             return bucket;
+         }
+         unsigned shift = static_cast<unsigned>(bucket / SubBuckets) - 1;
+         uint64_t lowest = (SubBuckets + bucket % SubBuckets) << shift;
+         return lowest + (uint64_t{1} << shift) - 1;
+     }
+
+     /**
+      * @brief Count a value
+      * @param nanoseconds The value
+      * @param count Times it was seen
+      */
+     void record(uint64_t nanoseconds, uint64_t count = 1) {
+         _counts[bucketOf(nanoseconds)] += count;
+         _total += count;
+     }
+
+     /**
+      * @brief Add the counts of a bucket, as read from another histogram
+      * @param bucket Index below BucketCount
+      * @param count Values in the bucket
+      */
+     void addBucket(std::size_t bucket, uint64_t count) {
+         _counts[bucket] += count;
+         _total += count;
+     }
+
+     uint64_t count() const { return _total; }
+
+     /**
+      * @brief Get the value below which a fraction of the counted values fall
+      * @param fraction Between 0 and 1
+      * @return Highest value of the bucket holding that rank; 0 if nothing was counted
+      */
+     uint64_t percentile(double fraction) const {
+         if (_total == 0) {
+             return 0;
+         }
+         uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * static_cast<double>(_total) + 0.5));
+         uint64_t seen = 0;
+         for (std::size_t bucket = 0; bucket < BucketCount; ++bucket) {
+             seen += _counts[bucket];
+             if (seen >= rank) {
+                 return highestOf(bucket);
+             }
+         }
+         return highestOf(BucketCount - 1);
+     }
+
+     /**
+      * @brief Get the largest value counted
+      * @return Highest value of the last non-empty bucket; 0 if nothing was counted
+      */
+     uint64_t max() const {
+         for (std::size_t bucket = BucketCount; bucket > 0; --bucket) {
+             if (_counts[bucket - 1] > 0) {
+                 return highestOf(bucket - 1);
+             }
+         }
+         return 0;
+     }
+
+ private:
+     uint64_t _counts[BucketCount] = {};  ///< Values per bucket
+     uint64_t _total = 0;                 ///< Values counted
+ };
+
+ /**
+  * @enum Stage
+  * @brief Steps of a datagram through the gateway, each with its own histogram
+  */
+ enum class Stage : uint8_t {
+     Queue,    ///< From recvmmsg returning to the ingest worker taking the datagram
+     Parse,    ///< Decoding the message
+     Store,    ///< Applying its readings to the fleet store
+     Ack,      ///< From recvmmsg returning to the response leaving through sendmmsg
+     Publish,  ///< From a shard's first unpublished update to the snapshot holding it being published
+     Count
+ };
+
+ /**
+  * @class StageLatencies
+  * @brief Process-wide latency histograms of every Stage
+  *
+  * Counts are kept in a ThreadBlocks block of histograms per recording
+  * thread and merged by readers.
+  */
+ class StageLatencies {
+ public:
+     static constexpr std::size_t StageCount = static_cast<std::size_t>(Stage::Count);
+
+     /**
+      * @brief Get the current time for latency measurements
+      * @return Nanoseconds of the steady clock
+      */
+     static uint64_t nowNs() {
+         return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count());
+     }
+
+     /**
+      * @brief Count a latency of a stage on the calling thread
+      * @param stage The stage
+      * @param nanoseconds The latency
+      */
+     static void record(Stage stage, uint64_t nanoseconds) {
+         std::atomic<uint64_t>& count = ThreadBlocks<Block>::local().counts[static_cast<std::size_t>(stage)][LatencyHistogram::bucketOf(nanoseconds)];
+         count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+     }
+
+     /**
+      * @brief Merge what every thread recorded for a stage
+      * @param stage The stage
+      * @param histogram Receives the counts, added to what it holds
+      */
+     static void merge(Stage stage, LatencyHistogram& histogram) {
+         ThreadBlocks<Block>::forEach([&histogram, stage](const Block& block) {
+             const auto& counts = block.counts[static_cast<std::size_t>(stage)];
+             for (std::size_t bucket = 0; bucket < LatencyHistogram::BucketCount; ++bucket) {
+                 if (uint64_t count = counts[bucket].load(std::memory_order_relaxed)) {
+                     histogram.addBucket(bucket, count);
+                 }
+             }
+         });
+     }
+
+     static std::string_view stageName(Stage stage) {
+         switch (stage) {
+             case Stage::Queue: return "queue";
+             case Stage::Parse: return "parse";
+             case Stage::Store: return "store";
+             case Stage::Ack: return "ack";
+             default: return "publish";
+         }
+     }
+
+     /**
+      * @brief Append a table of every stage's count and percentiles in microseconds
+      * @param out Receives the text
+      */
+     static void appendTable(std::string& out) {
+         char line[160];
+         std::snprintf(line, sizeof(line), "%-8s %12s %10s %10s %10s %10s %10s\n",
+                       "stage", "count", "p50 us", "p90 us", "p99 us", "p999 us", "max us");
+         out += line;
+         for (std::size_t i = 0; i < StageCount; ++i) {
+             Stage stage = static_cast<Stage>(i);
+             auto histogram = std::make_unique<LatencyHistogram>();
+             merge(stage, *histogram);
+             std::string_view name = stageName(stage);
+             std::snprintf(line, sizeof(line), "%-8.*s %12llu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                           static_cast<int>(name.size()), name.data(), static_cast<unsigned long long>(histogram->count()),
+                           histogram->percentile(0.50) / 1e3, histogram->percentile(0.90) / 1e3,
+                           histogram->percentile(0.99) / 1e3, histogram->percentile(0.999) / 1e3,
+                           histogram->max() / 1e3);
+             out += line;
+         }
+     }
+
+     /**
+      * @brief Append every stage as a Prometheus summary in seconds
+      * @param out Receives the text
+      */
+     static void appendPrometheus(std::string& out) {
+         static constexpr std::string_view Name = "ebike_stage_latency_seconds";
+         out.append("# HELP ").append(Name).append(" Latency of each ingest pipeline stage.\n");
+         out.append("# TYPE ").append(Name).append(" summary\n");
+         char line[160];
+         for (std::size_t i = 0; i < StageCount; ++i) {
+             Stage stage = static_cast<Stage>(i);
+             auto histogram = std::make_unique<LatencyHistogram>();
+             merge(stage, *histogram);
+             std::string_view name = stageName(stage);
+             for (double quantile : {0.5, 0.9, 0.99, 0.999}) {
+                 std::snprintf(line, sizeof(line), "%.*s{stage=\"%.*s\",quantile=\"%g\"} %.9f\n",
+                               static_cast<int>(Name.size()), Name.data(), static_cast<int>(name.size()), name.data(),
+                               quantile, histogram->percentile(quantile) / 1e9);
+                 out += line;
+             }
+             std::snprintf(line, sizeof(line), "%.*s_count{stage=\"%.*s\"} %llu\n",
+                           static_cast<int>(Name.size()), Name.data(), static_cast<int>(name.size()), name.data(),
+                           static_cast<unsigned long long>(histogram->count()));
+             out += line;
+         }
+     }
+
+ private:
+     /**
+      * @struct Block
+      * @brief Histogram counts written by one thread, on cache lines of their own
+      */
+     struct alignas(64) Block {
+         std::atomic<uint64_t> counts[StageCount][LatencyHistogram::BucketCount] = {};  ///< Counts by stage and bucket
+
+         void fold(const Block& exited) {
+             for (std::size_t stage = 0; stage < StageCount; ++stage) {
+                 for (std::size_t bucket = 0; bucket < LatencyHistogram::BucketCount; ++bucket) {
+                     if (uint64_t count = exited.counts[stage][bucket].load(std::memory_order_relaxed)) {
+                         std::atomic<uint64_t>& total = counts[stage][bucket];
+                         total.store(total.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+                     }
+                 }
+             }
+         }
+     };
+ };
+
+ #endif // LATENCY_HISTOGRAM_H
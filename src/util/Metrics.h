@@ -0,0 +1,228 @@
+/**
+ * @file Metrics.h
+ * @brief Process-wide counters and gauges kept per thread and summed when scraped
+ * @date October 2026
+ */
+
+ #ifndef METRICS_H
+ #define METRICS_H
+
+ #include <atomic>
+ #include <charconv>
+ #include <cstddef>
+ #include <cstdint>
+ #include <string>
+ #include <string_view>
+ #include "util/ThreadBlocks.h"
+
+ /**
+  * @enum Counter
+  * @brief Monotonic counts, exported with a _total suffix
+  */
+ enum class Counter : uint8_t {
+     DatagramsReceived,   ///< UDP datagrams taken off the socket
+     DatagramsDropped,    ///< Datagrams dropped because their worker's queue was full
+     ReadingsApplied,     ///< Telemetry readings written to the fleet
+     MalformedMessages,   ///< Messages rejected as invalid telemetry
+     AcksSent,            ///< Acknowledgments returned to e-bikes
+     HttpRequests,        ///< HTTP requests routed
+     HttpNotModified,     ///< HTTP requests answered 304 Not Modified
+     StreamRejected,      ///< Stream subscribers turned away over the subscriber limit
+     HttpResponseBytes,   ///< HTTP response body bytes sent, after compression
+     Count
+ };
+
+ /**
+  * @enum Gauge
+  * @brief Levels that go up and down; each thread keeps its own share of the total
+  */
+ enum class Gauge : uint8_t {
+     HttpActiveRequests,  ///< HTTP requests being handled
+     StreamSubscribers,   ///< Open /ebikes/stream and /ebikes/ws connections
+     Count
+ };
+
+ /**
+  * @class Metrics
+  * @brief Registry of the gateway's counters and gauges
+  *
+  * Values are kept in a ThreadBlocks block per recording thread and summed
+  * when scraped.
+  */
+ class Metrics {
+ public:
+     static constexpr std::size_t CounterCount = static_cast<std::size_t>(Counter::Count);
+     static constexpr std::size_t GaugeCount = static_cast<std::size_t>(Gauge::Count);
+
+     /**
+      * @brief Add to a counter
+      * @param counter The counter
+      * @param amount Amount added
+      */
+     static void add(Counter counter, uint64_t amount = 1) {
+         std::atomic<uint64_t>& value = ThreadBlocks<Block>::local().counters[static_cast<std::size_t>(counter)];
+         value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+     }
+
+     /**
+      * @brief Move a gauge up or down
+      * @param gauge The gauge
+      * @param delta Change, negative to decrease
+      */
+     static void adjust(Gauge gauge, int64_t delta) {
+         std::atomic<int64_t>& value = ThreadBlocks<Block>::local().gauges[static_cast<std::size_t>(gauge)];
+         value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+     }
+
+     /**
+      * @brief Sum a counter over every thread
+      * @param counter The counter
+      * @return The process-wide total
+      */
+     static uint64_t total(Counter counter) {
+         uint64_t sum = 0;
+         ThreadBlocks<Block>::forEach([&sum, counter](const Block& block) {
+             sum += block.counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+         });
+         return sum;
+     }
+
+     /**
+      * @brief Sum a gauge over every thread
+      * @param gauge The gauge
+      * @return The process-wide level
+      */
+     static int64_t total(Gauge gauge) {
+         int64_t sum = 0;
+         ThreadBlocks<Block>::forEach([&sum, gauge](const Block& block) {
+             sum += block.gauges[static_cast<std::size_t>(gauge)].load(std::memory_order_relaxed);
+         });
+         return sum;
+     }
+
+     /**
+      * @brief Count the threads whose values are kept apart from the total of exited ones
+      * @return The number of live threads that have recorded a metric
+      */
+     static std::size_t threads() {
+         return ThreadBlocks<Block>::size();
+     }
+
+     /**
+      * @brief Append every counter and gauge in the Prometheus text exposition format
+      * @param out Receives the text
+      */
+     static void appendPrometheus(std::string& out) {
+         for (std::size_t i = 0; i < CounterCount; ++i) {
+             Counter counter = static_cast<Counter>(i);
+             appendSample(out, counterName(counter), counterHelp(counter), "counter", total(counter));
+         }
+         for (std::size_t i = 0; i < GaugeCount; ++i) {
+             Gauge gauge = static_cast<Gauge>(i);
+             appendSample(out, gaugeName(gauge), gaugeHelp(gauge), "gauge", total(gauge));
+         }
+     }
+
+     /**
+      * @brief Append one metric with its HELP and TYPE lines
+      * @param out Receives the text
+      * @param name Metric name
+      * @param help Description
+      * @param type "counter" or "gauge"
+      * @param value The value
+      */
+     template <typename T>
+     static void appendSample(std::string& out, std::string_view name, std::string_view help, std::string_view type, T value) {
+         out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+         out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+         char digits[24];
+         std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+         out.append(name).append(" ").append(digits, static_cast<std::size_t>(result.ptr - digits)).append("\n");
+     }
+
+     static std::string_view counterName(Counter counter) {
+         switch (counter) {
+             case Counter::DatagramsReceived: return "ebike_datagrams_received_total";
+             case Counter::DatagramsDropped: return "ebike_datagrams_dropped_total";
+             case Counter::ReadingsApplied: return "ebike_readings_applied_total";
+             case Counter::MalformedMessages: return "ebike_malformed_messages_total";
+             case Counter::AcksSent: return "ebike_acks_sent_total";
+             case Counter::HttpRequests: return "ebike_http_requests_total";
+             case Counter::HttpNotModified: return "ebike_http_not_modified_total";
+             case Counter::StreamRejected: return "ebike_stream_rejected_total";
+             default: return "ebike_http_response_bytes_total";
+         }
+     }
+
+     static std::string_view gaugeName(Gauge gauge) {
+         switch (gauge) {
+             case Gauge::HttpActiveRequests: return "ebike_http_active_requests";
+             default: return "ebike_stream_subscribers";
+         }
+     }
+
+ private:
+     /**
+      * @struct Block
+      * @brief Values written by one thread, on cache lines of their own
+      */
+     struct alignas(64) Block {
+         std::atomic<uint64_t> counters[CounterCount] = {};  ///< Counts by Counter
+         std::atomic<int64_t> gauges[GaugeCount] = {};       ///< This thread's share by Gauge
+
+         void fold(const Block& exited) {
+             for (std::size_t i = 0; i < CounterCount; ++i) {
+                 counters[i].store(counters[i].load(std::memory_order_relaxed)
+                                   + exited.counters[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+             }
+             for (std::size_t i = 0; i < GaugeCount; ++i) {
+                 gauges[i].store(gauges[i].load(std::memory_order_relaxed)
+                                 + exited.gauges[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+             }
+         }
+     };
+
+     static std::string_view counterHelp(Counter counter) {
+         switch (counter) {
+             case Counter::DatagramsReceived: return "UDP datagrams received from e-bikes.";
+             case Counter::DatagramsDropped: return "Datagrams dropped because their ingest worker's queue was full.";
+             case Counter::ReadingsApplied: return "Telemetry readings applied to the fleet.";
+             case Counter::MalformedMessages: return "Messages rejected as invalid telemetry.";
+             case Counter::AcksSent: return "Acknowledgments returned to e-bikes.";
+             case Counter::HttpRequests: return "HTTP requests received.";
+             case Counter::HttpNotModified: return "HTTP requests answered with 304 Not Modified.";
+             case Counter::StreamRejected: return "Stream subscribers answered 503 over the subscriber limit.";
+             default: return "HTTP response body bytes sent, after compression.";
+         }
+     }
+
+     static std::string_view gaugeHelp(Gauge gauge) {
+         switch (gauge) {
+             case Gauge::HttpActiveRequests: return "HTTP requests being handled.";
+             default: return "Open /ebikes/stream and /ebikes/ws subscriptions.";
+         }
+     }
+ };
+
+ /**
+  * @class ScopedGauge
+  * @brief Raises a gauge by one for the lifetime of the object
+  */
+ class ScopedGauge {
+ public:
+     explicit ScopedGauge(Gauge gauge) : _gauge(gauge) {
+         Metrics::adjust(_gauge, 1);
+     }
+
+     ~ScopedGauge() {
+         Metrics::adjust(_gauge, -1);
+     }
+
+     ScopedGauge(const ScopedGauge&) = delete;
+     ScopedGauge& operator=(const ScopedGauge&) = delete;
+
+ private:
+     Gauge _gauge;  ///< The gauge raised
+ };
+
+ #endif // METRICS_H
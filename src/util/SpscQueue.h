@@ -0,0 +1,100 @@
+/**
+ * @file SpscQueue.h
+ * @brief Bounded lock-free queue between one producer and one consumer thread
+ * @date October 2026
+ */
+
+ #ifndef SPSC_QUEUE_H
+ #define SPSC_QUEUE_H
+
+ #include <atomic>
+ #include <vector>
+ #include <cstddef>
+
+ /**
+  * @class SpscQueue
+  * @brief Fixed-capacity ring buffer for exactly one producer and one consumer
+  *
+  * Slots are allocated once and reused. The producer fills a slot in place
+  * through claim()/commit() and the consumer reads it in place through
+  * front()/pop(), so elements holding large buffers are never copied or
+  * reallocated. Head and tail live on separate cache lines, and each side
+  * caches the other's index to avoid touching the shared line on every call.
+  *
+  * @tparam T Element type; must be default-constructible
+  */
+ template <typename T>
+ class SpscQueue {
+ public:
+     /**
+      * @brief Constructor for SpscQueue
+      * @param capacity Maximum number of queued elements
+      */
+     explicit SpscQueue(std::size_t capacity) : _slots(capacity + 1) {}
+
+     /**
+      * @brief Get the next free slot (producer only)
+      * @return The slot to fill, or nullptr if the queue is full
+      */
+     T* claim() {
+         std::size_t tail = _tail.load(std::memory_order_relaxed);
+         std::size_t next = advance(tail);
+         if (next == _cachedHead) {
+             _cachedHead = _head.load(std::memory_order_acquire);
+             if (next == _cachedHead) {
+                 return nullptr;
+             }
+         }
+         return &_slots[tail];
+     }
+
+     /**
+      * @brief Make the slot returned by claim() visible to the consumer (producer only)
+      */
+     void commit() {
+         _tail.store(advance(_tail.load(std::memory_order_relaxed)), std::memory_order_release);
+     }
+
+     /**
+      * @brief Get the oldest queued element (consumer only)
+      * @return The element, or nullptr if the queue is empty
+      */
+     T* front() {
+         std::size_t head = _head.load(std::memory_order_relaxed);
+         if (head == _cachedTail) {
+             _cachedTail = _tail.load(std::memory_order_acquire);
+             if (head == _cachedTail) {
+                 return nullptr;
+             }
+         }
+         return &_slots[head];
+     }
+
+     /**
+      * @brief Release the element returned by front() (consumer only)
+      */
+     void pop() {
+         _head.store(advance(_head.load(std::memory_order_relaxed)), std::memory_order_release);
+     }
+
+     /**
+      * @brief Check whether the queue looks empty; exact only on the consumer thread
+      * @return true if nothing is queued
+      */
+     bool empty() const {
+         return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+     }
+
+ private:
+     std::size_t advance(std::size_t index) const {
+         return index + 1 == _slots.size() ? 0 : index + 1;
+     }
+
+     std::vector<T> _slots;                         ///< Ring storage, one slot always left free
+     alignas(64) std::atomic<std::size_t> _head{0}; ///< Next slot to read (written by the consumer)
+     std::size_t _cachedTail = 0;                   ///< Consumer's copy of _tail
+     alignas(64) std::atomic<std::size_t> _tail{0}; ///< Next slot to write (written by the producer)
+     std::size_t _cachedHead = 0;                   ///< Producer's copy of _head
+ };
+
+ #endif // SPSC_QUEUE_H
@@ -0,0 +1,126 @@
+/**
+ * @file ThreadBlocks.h
+ * @brief Registry of per-thread blocks of statistics, summed by readers
+ * @date October 2026
+ */
+
+ #ifndef THREAD_BLOCKS_H
+ #define THREAD_BLOCKS_H
+
+ #include <algorithm>
+ #include <atomic>
+ #include <cstddef>
+ #include <memory>
+ #include <mutex>
+ #include <vector>
+
+ /**
+  * @class ThreadBlocks
+  * @brief Process-wide registry of one Block per thread that records into it
+  *
+  * Every thread gets its own Block, aligned to a cache line by the Block
+  * type, the first time it records. It writes its values with relaxed
+  * loads and stores: no lock, no read-modify-write and no sharing. Readers
+  * visit the blocks of the live threads plus one total of the threads that
+  * have exited, so sums never go backwards while the registry stays as
+  * large as the number of live threads; thread pools that retire and
+  * start threads do not grow it.
+  *
+  * Block must be default constructible and provide
+  * void fold(const Block& exited), adding an exited thread's values to its own.
+  *
+  * @tparam Block Values written by one thread
+  */
+ template <typename Block>
+ class ThreadBlocks {
+ public:
+     /**
+      * @brief Get the calling thread's block, registering it on first use
+      * @return The block; shared with the registry so it outlives the thread
+      */
+     static Block& local() {
+         thread_local Handle handle(instance());
+         return handle.entry->block;
+     }
+
+     /**
+      * @brief Visit the total of the exited threads, then the block of every live thread
+      * @param visit Called with each const Block&, under the registry lock
+      */
+     template <typename Visit>
+     static void forEach(Visit visit) {
+         ThreadBlocks& blocks = instance();
+         std::lock_guard<std::mutex> lock(blocks._entriesMutex);
+         blocks.retireExited();
+         visit(blocks._retired);
+         for (const std::shared_ptr<Entry>& entry : blocks._entries) {
+             visit(entry->block);
+         }
+     }
+
+     /**
+      * @brief Count the blocks held for live threads, after retiring those of exited ones
+      * @return The number of blocks besides the retired total
+      */
+     static std::size_t size() {
+         ThreadBlocks& blocks = instance();
+         std::lock_guard<std::mutex> lock(blocks._entriesMutex);
+         blocks.retireExited();
+         return blocks._entries.size();
+     }
+
+ private:
+     /**
+      * @struct Entry
+      * @brief A thread's block and whether that thread has exited
+      */
+     struct Entry {
+         Block block;                      ///< Values of the thread
+         std::atomic<bool> closed{false};  ///< The owning thread has exited
+     };
+
+     /**
+      * @struct Handle
+      * @brief Thread-local owner that registers its entry and closes it at thread exit
+      */
+     struct Handle {
+         explicit Handle(ThreadBlocks& blocks) : entry(std::make_shared<Entry>()) {
+             std::lock_guard<std::mutex> lock(blocks._entriesMutex);
+             blocks.retireExited();
+             blocks._entries.push_back(entry);
+         }
+         ~Handle() {
+             entry->closed.store(true, std::memory_order_release);
+         }
+
+         std::shared_ptr<Entry> entry;
+     };
+
+     static ThreadBlocks& instance() {
+         static ThreadBlocks blocks;
+         return blocks;
+     }
+
+     /**
+      * @brief Fold the blocks of exited threads into the retired total and forget them
+      *
+      * Called with _entriesMutex held.
+      */
+     void retireExited() {
+         _entries.erase(std::remove_if(_entries.begin(), _entries.end(),
+                                       [this](const std::shared_ptr<Entry>& entry) {
+                                           if (!entry->closed.load(std::memory_order_acquire)) {
+                                               return false;
+                                           }
+                                           _retired.fold(entry->block);
+                                           return true;
+                                       }),
+                        _entries.end());
+     }
+
+     std::mutex _entriesMutex;                      ///< Guards _entries and _retired
+     std::vector<std::shared_ptr<Entry>> _entries;  ///< Entries of live threads, and of exited ones not yet retired
+     Block _retired;                                ///< Sum of the blocks of retired threads
+ };
+
+ #endif // THREAD_BLOCKS_H
@@ -0,0 +1,206 @@
+/**
+ * @file TimeCodec.h
+ * @brief Conversion between epoch milliseconds and ISO 8601 UTC timestamps
+ * @date October 2026
+ */
+
+ #ifndef TIME_CODEC_H
+ #define TIME_CODEC_H
+
+ #include <chrono>
+ #include <limits>
+ #include <string_view>
+ #include <cstddef>
+ #include <cstdint>
+
+ /**
+  * @class TimeCodec
+  * @brief Hand-written ISO 8601 codec shared by ebikeClient and the gateway
+  *
+  * Timestamps are kept as int64 milliseconds since the Unix epoch and only
+  * turned into text at the edges. Calendar conversion uses Howard
+  * Hinnant's days_from_civil/civil_from_days, so neither direction calls
+  * gmtime, localtime or strftime, and nothing takes the libc timezone lock.
+  *
+  * formatNow() and formatCached() reuse a per-thread copy of the
+  * "YYYY-MM-DDTHH:MM:SS" prefix of the current second, so formatting a
+  * stream of nearby timestamps only rewrites the milliseconds.
+  */
+ class TimeCodec {
+ public:
+     static constexpr std::size_t SecondsSize = 20; ///< Length of YYYY-MM-DDTHH:MM:SSZ
+     static constexpr std::size_t MillisSize = 24;  ///< Length of YYYY-MM-DDTHH:MM:SS.mmmZ
+
+     /**
+      * @brief Get the current time
+      * @return Milliseconds since the Unix epoch
+      */
+     static int64_t nowMs() {
+         return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch()).count();
+     }
+
+     /**
+      * @brief Parse an ISO 8601 UTC timestamp
+      * @param text YYYY-MM-DDTHH:MM:SSZ, optionally with a fraction of a second
+      *        before the Z; digits beyond milliseconds are truncated
+      * @param timestampMs Receives milliseconds since the Unix epoch
+      * @return true if the timestamp was well formed
+      */
+     static bool parse(std::string_view text, int64_t& timestampMs) {
+         if (text.size() < SecondsSize || text[4] != '-' || text[7] != '-' || text[10] != 'T'
+             || text[13] != ':' || text[16] != ':' || text.back() != 'Z') {
+             return false;
+         }
+         int year, month, day, hour, minute, second;
+         if (!digits(text, 0, 4, year) || !digits(text, 5, 2, month) || !digits(text, 8, 2, day)
+             || !digits(text, 11, 2, hour) || !digits(text, 14, 2, minute) || !digits(text, 17, 2, second)) {
+             return false;
+         }
+         if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+             return false;
+         }
+
+         // Optional fraction: ".d", ".dd", ".ddd" or longer
+         int millis = 0;
+         std::size_t fraction = text.size() - SecondsSize;
+         if (fraction > 0) {
+             if (fraction < 2 || text[19] != '.') {
+                 return false;
+             }
+             int scale = 100;
+             for (std::size_t i = 20; i < text.size() - 1; ++i) {
+                 if (text[i] < '0' || text[i] > '9') {
+                     return false;
+                 }
+                 millis += (text[i] - '0') * scale;
+                 scale /= 10;
+             }
+         }
+
+         int64_t days = daysFromCivil(year, month, day);
+         timestampMs = ((days * 24 + hour) * 60 + minute) * 60000 + static_cast<int64_t>(second) * 1000 + millis;
+         return true;
+     }
+
+     /**
+      * @brief Format a timestamp to whole seconds
+      * @param timestampMs Milliseconds since the Unix epoch
+      * @param out Buffer of at least SecondsSize bytes
+      * @return Number of bytes written
+      */
+     static std::size_t formatSeconds(int64_t timestampMs, char* out) {
+         writePrefix(floorDiv(timestampMs, 1000), out);
+         out[19] = 'Z';
+         return SecondsSize;
+     }
+
+     /**
+      * @brief Format a timestamp with milliseconds
+      * @param timestampMs Milliseconds since the Unix epoch
+      * @param out Buffer of at least MillisSize bytes
+      * @return Number of bytes written
+      */
+     static std::size_t formatMillis(int64_t timestampMs, char* out) {
+         writePrefix(floorDiv(timestampMs, 1000), out);
+         writeMillis(timestampMs, out);
+         return MillisSize;
+     }
+
+     /**
+      * @brief Format a timestamp with milliseconds through the calling thread's cache
+      * @param timestampMs Milliseconds since the Unix epoch
+      * @return The timestamp; valid until the thread's next formatCached() or formatNow()
+      */
+     static std::string_view formatCached(int64_t timestampMs) {
+         thread_local int64_t cachedSecond = std::numeric_limits<int64_t>::min();
+         thread_local char buffer[MillisSize];
+
+         int64_t second = floorDiv(timestampMs, 1000);
+         if (second != cachedSecond) {
+             writePrefix(second, buffer);
+             cachedSecond = second;
+         }
+         writeMillis(timestampMs, buffer);
+         return std::string_view(buffer, MillisSize);
+     }
+
+     /**
+      * @brief Format the current time with milliseconds through the calling thread's cache
+      * @return The timestamp; valid until the thread's next formatCached() or formatNow()
+      */
+     static std::string_view formatNow() {
+         return formatCached(nowMs());
+     }
+
+ private:
+     static int64_t floorDiv(int64_t value, int64_t divisor) {
+         return value / divisor - (value % divisor < 0 ? 1 : 0);
+     }
+
+     /// Days since the epoch for a proleptic Gregorian date (days_from_civil)
+     static int64_t daysFromCivil(int year, int month, int day) {
+         int y = year - (month <= 2);
+         int era = (y >= 0 ? y : y - 399) / 400;
+         int yoe = y - era * 400;
+         int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+         int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+         return static_cast<int64_t>(era) * 146097 + doe - 719468;
+     }
+
+     /// Write "YYYY-MM-DDTHH:MM:SS" for a second since the epoch (civil_from_days)
+     static void writePrefix(int64_t second, char* out) {
+         int64_t days = floorDiv(second, 86400);
+         int64_t secondOfDay = second - days * 86400;
+
+         int64_t z = days + 719468;
+         int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+         int64_t doe = z - era * 146097;
+         int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+         int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+         int64_t mp = (5 * doy + 2) / 153;
+         int day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+         int month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+         int year = static_cast<int>(yoe + era * 400 + (month <= 2));
+
+         put(out, 4, year);
+         out[4] = '-';
+         put(out + 5, 2, month);
+         out[7] = '-';
+         put(out + 8, 2, day);
+         out[10] = 'T';
+         put(out + 11, 2, static_cast<int>(secondOfDay / 3600));
+         out[13] = ':';
+         put(out + 14, 2, static_cast<int>(secondOfDay / 60 % 60));
+         out[16] = ':';
+         put(out + 17, 2, static_cast<int>(secondOfDay % 60));
+     }
+
+     /// Write ".mmmZ" after the prefix
+     static void writeMillis(int64_t timestampMs, char* out) {
+         out[19] = '.';
+         put(out + 20, 3, static_cast<int>(timestampMs - floorDiv(timestampMs, 1000) * 1000));
+         out[23] = 'Z';
+     }
+
+     /// Write a non-negative value as exactly count digits
+     static void put(char* out, int count, int value) {
+         for (int i = count - 1; i >= 0; --i) {
+             out[i] = static_cast<char>('0' + value % 10);
+             value /= 10;
+         }
+     }
+
+     static bool digits(std::string_view text, std::size_t offset, std::size_t count, int& value) {
+         value = 0;
+         for (std::size_t i = offset; i < offset + count; ++i) {
+             if (text[i] < '0' || text[i] > '9') {
+                 return false;
+             }
+             value = value * 10 + (text[i] - '0');
+         }
+         return true;
+     }
+ };
+
+ #endif // TIME_CODEC_H
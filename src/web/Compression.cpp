@@ -0,0 +1,113 @@
+// src/web/Compression.cpp
+#include "Compression.h"
+#include <cctype>
+#include <cstdlib>
+#include <zlib.h>
+
+namespace {
+
+// Strip spaces and tabs from both ends
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+// Compare ASCII strings ignoring case
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Quality of a coding from its parameters, such as ";q=0.5"; 1 if not given
+double quality(std::string_view parameters) {
+    while (!parameters.empty()) {
+        std::size_t semicolon = parameters.find(';', 1);
+        std::string_view parameter = trim(parameters.substr(1, semicolon == std::string_view::npos ? std::string_view::npos : semicolon - 1));
+        parameters = semicolon == std::string_view::npos ? std::string_view() : parameters.substr(semicolon);
+        if (parameter.size() > 2 && (parameter[0] == 'q' || parameter[0] == 'Q') && parameter[1] == '=') {
+            std::string value(parameter.substr(2));
+            return std::strtod(value.c_str(), nullptr);
+        }
+    }
+    return 1.0;
+}
+
+}
+
+ContentEncoding negotiateEncoding(std::string_view acceptEncoding) {
+    double gzip = 0.0, deflate = 0.0, any = -1.0;
+    bool gzipNamed = false, deflateNamed = false;
+    while (!acceptEncoding.empty()) {
+        std::size_t comma = acceptEncoding.find(',');
+        std::string_view item = acceptEncoding.substr(0, comma);
+        acceptEncoding = comma == std::string_view::npos ? std::string_view() : acceptEncoding.substr(comma + 1);
+
+        std::size_t semicolon = item.find(';');
+        std::string_view name = trim(item.substr(0, semicolon));
+        double q = semicolon == std::string_view::npos ? 1.0 : quality(item.substr(semicolon));
+        if (equalsIgnoreCase(name, "gzip") || equalsIgnoreCase(name, "x-gzip")) {
+            gzip = q;
+            gzipNamed = true;
+        } else if (equalsIgnoreCase(name, "deflate")) {
+            deflate = q;
+            deflateNamed = true;
+        } else if (name == "*") {
+            any = q;
+        }
+    }
+    // "*" stands for the codings that were not named; a named q=0 still refuses its coding
+    if (any >= 0.0) {
+        gzip = gzipNamed ? gzip : any;
+        deflate = deflateNamed ? deflate : any;
+    }
+
+    if (gzip > 0.0 && gzip >= deflate) {
+        return ContentEncoding::Gzip;
+    }
+    return deflate > 0.0 ? ContentEncoding::Deflate : ContentEncoding::Identity;
+}
+
+const char* encodingName(ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::Gzip: return "gzip";
+        case ContentEncoding::Deflate: return "deflate";
+        default: return "";
+    }
+}
+
+bool compress(std::string_view data, ContentEncoding encoding, std::string& out) {
+    if (encoding == ContentEncoding::Identity) {
+        out.assign(data.data(), data.size());
+        return true;
+    }
+
+    // Window bits of 15 give the zlib wrapper; adding 16 gives the gzip wrapper instead
+    z_stream stream{};
+    int windowBits = encoding == ContentEncoding::Gzip ? 15 + 16 : 15;
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+
+    // Older zlib versions only allow for the zlib wrapper in deflateBound(); 18 bytes cover a gzip one
+    out.resize(deflateBound(&stream, static_cast<uLong>(data.size())) + 18);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    int result = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <string>
+#include <string_view>
+
+// HTTP content codings the gateway can produce
+enum class ContentEncoding {
+    Identity,
+    Gzip,
+    Deflate  // zlib-wrapped deflate, as HTTP's "deflate" means
+};
+
+// Pick the coding for a response from an Accept-Encoding header. gzip is preferred to deflate
+// when the client accepts both equally; codings with q=0 are never picked.
+ContentEncoding negotiateEncoding(std::string_view acceptEncoding);
+
+// Name of a coding for the Content-Encoding header; empty for identity
+const char* encodingName(ContentEncoding encoding);
+
+// Compress data with a coding in one pass into out, which is replaced. Identity copies the data.
+// Returns false if zlib fails.
+bool compress(std::string_view data, ContentEncoding encoding, std::string& out);
+
+#endif // COMPRESSION_H
@@ -0,0 +1,36 @@
+// src/web/ETag.cpp
+#include "ETag.h"
+
+namespace {
+
+// Strip spaces and tabs from both ends
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+}
+
+bool etagMatches(std::string_view ifNoneMatch, std::string_view etag) {
+    if (etag.substr(0, 2) == "W/") {
+        etag.remove_prefix(2);
+    }
+    while (!ifNoneMatch.empty()) {
+        std::size_t comma = ifNoneMatch.find(',');
+        std::string_view tag = trim(ifNoneMatch.substr(0, comma));
+        ifNoneMatch = comma == std::string_view::npos ? std::string_view() : ifNoneMatch.substr(comma + 1);
+
+        if (tag.substr(0, 2) == "W/") {
+            tag.remove_prefix(2);
+        }
+        if (tag == "*" || (!etag.empty() && tag == etag)) {
+            return true;
+        }
+    }
+    return false;
+}
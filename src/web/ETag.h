@@ -0,0 +1,12 @@
+#pragma once
+
+#ifndef ETAG_H
+#define ETAG_H
+
+#include <string_view>
+
+// Check whether an If-None-Match header value matches an entity tag. The header may list several
+// tags or "*"; If-None-Match uses weak comparison, so W/ prefixes are ignored.
+bool etagMatches(std::string_view ifNoneMatch, std::string_view etag);
+
+#endif // ETAG_H
@@ -1,84 +1,459 @@
 // src/web/EbikeHandler.cpp
 #include "EbikeHandler.h"
-#include <Poco/JSON/Object.h>
-#include <Poco/JSON/Parser.h>
-#include <Poco/Dynamic/Var.h>
-#include <Poco/StreamCopier.h>
-#include <fstream>
-#include <iostream>
+#include <Poco/Net/HTTPServerRequestImpl.h>
+#include <Poco/Net/WebSocket.h>
+#include <charconv>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include "GeoJson.h"
+#include "ETag.h"
+#include "util/AsyncLog.h"
+#include "util/Metrics.h"
+#include "util/LatencyHistogram.h"
+#include "util/TimeCodec.h"
 
-// EBikeHandler implementation
-EBikeHandler::EBikeHandler(Poco::JSON::Array::Ptr& ebikes) : _ebikes(ebikes) {
+namespace {
+
+// Parse a whole string as a decimal number
+template <typename T>
+bool parseNumber(std::string_view text, T& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// Parse a time bound given as epoch milliseconds or as an ISO 8601 timestamp
+bool parseTimeBound(std::string_view text, int64_t& timestampMs) {
+    return parseNumber(text, timestampMs) || TimeCodec::parse(text, timestampMs);
 }
 
-void EBikeHandler::handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response) {
-    // Set response type to JSON
-    response.setContentType("application/json");
+// Parse a coordinate in degrees into microdegrees, rejecting values outside the given range
+bool parseCoordinate(std::string_view text, double limit, int32_t& microdegrees) {
+    double degrees = 0.0;
+    if (!parseNumber(text, degrees) || degrees < -limit || degrees > limit) {
+        return false;
+    }
+    microdegrees = toMicrodegrees(degrees);
+    return true;
+}
+
+// Send the body with the status and content type
+void sendBody(Poco::Net::HTTPServerResponse& response, const char* contentType, const std::string& body) {
+    response.setContentType(contentType);
     response.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
+    response.setContentLength(static_cast<std::streamsize>(body.size()));
+    response.sendBuffer(body.data(), body.size());
+    Metrics::add(Counter::HttpResponseBytes, body.size());
+}
+
+// Answer 503 to a stream subscriber over the limit; the map then polls instead
+void sendTooManySubscribers(Poco::Net::HTTPServerResponse& response) {
+    response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_SERVICE_UNAVAILABLE, "Too many stream subscribers");
+    response.set("Retry-After", "30");
+    response.setContentLength(0);
+    response.send();
+    Metrics::add(Counter::StreamRejected);
+}
+
+// Answer 304 Not Modified with an empty body
+void sendNotModified(Poco::Net::HTTPServerResponse& response) {
+    response.setStatus(Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED);
+    response.setContentLength(0);
+    response.send();
+    Metrics::add(Counter::HttpNotModified);
+}
+
+// The object Poco gets for one request, forwarding it to the shared handler of its route with
+// what the router captured. Poco creates and deletes it on the server thread handling the
+// request, so each thread keeps a few freed ones to reuse instead of going to the heap.
+class RoutedRequest : public Poco::Net::HTTPRequestHandler {
+public:
+    RoutedRequest(RouteHandler& handler, const RouteMatch& match) : _handler(handler), _match(match) {
+    }
+
+    void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response) override {
+        Metrics::add(Counter::HttpRequests);
+        ScopedGauge active(Gauge::HttpActiveRequests);
+        _handler.handleRequest(request, response, _match);
+    }
+
+    static void* operator new(std::size_t size) {
+        FreeList& free = freeList();
+        if (size == sizeof(RoutedRequest) && free.count > 0) {
+            return free.blocks[--free.count];
+        }
+        return ::operator new(size);
+    }
+
+    static void operator delete(void* memory, std::size_t size) {
+        FreeList& free = freeList();
+        if (size == sizeof(RoutedRequest) && free.count < FreeList::Capacity) {
+            free.blocks[free.count++] = memory;
+            return;
+        }
+        ::operator delete(memory);
+    }
+
+private:
+    struct FreeList {
+        static constexpr std::size_t Capacity = 4;  // More than a thread has in flight at once
+
+        void* blocks[Capacity];
+        std::size_t count = 0;
+
+        ~FreeList() {
+            while (count > 0) {
+                ::operator delete(blocks[--count]);
+            }
+        }
+    };
+
+    static FreeList& freeList() {
+        thread_local FreeList list;
+        return list;
+    }
+
+    RouteHandler& _handler;
+    RouteMatch _match;  // Views into the request's URI, which outlives this object
+};
+
+}
+
+// EBikeHandler implementation
+EBikeHandler::EBikeHandler(FeatureCollectionCache& cache, FleetPublisher& fleet) : _cache(cache), _fleet(fleet) {
+}
+
+bool EBikeHandler::parseBoundingBox(std::string_view value, int32_t& minLatitudeE6, int32_t& minLongitudeE6,
+                                    int32_t& maxLatitudeE6, int32_t& maxLongitudeE6) {
+    std::string_view parts[4];
+    for (std::size_t i = 0; i < 4; ++i) {
+        std::size_t comma = value.find(',');
+        if ((comma == std::string_view::npos) != (i == 3)) {
+            return false;
+        }
+        parts[i] = value.substr(0, comma);
+        value = i < 3 ? value.substr(comma + 1) : std::string_view();
+    }
+    return parseCoordinate(parts[0], 180.0, minLongitudeE6) && parseCoordinate(parts[1], 90.0, minLatitudeE6)
+        && parseCoordinate(parts[2], 180.0, maxLongitudeE6) && parseCoordinate(parts[3], 90.0, maxLatitudeE6)
+        && minLongitudeE6 <= maxLongitudeE6 && minLatitudeE6 <= maxLatitudeE6;
+}
+
+void EBikeHandler::handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+                                 const RouteMatch& match) {
+    std::string_view bbox, since;
+    bool hasBox = match.queryParameter("bbox", bbox);
+    int32_t minLatitudeE6 = 0, minLongitudeE6 = 0, maxLatitudeE6 = 0, maxLongitudeE6 = 0;
+    if (hasBox && !parseBoundingBox(bbox, minLatitudeE6, minLongitudeE6, maxLatitudeE6, maxLongitudeE6)) {
+        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_BAD_REQUEST, "Bad bounding box");
+        response.send() << "Expected bbox=minLon,minLat,maxLon,maxLat in degrees";
+        return;
+    }
+    
+    // Both buffers keep their capacity between requests of this thread
+    thread_local std::vector<std::size_t> slots;
+    thread_local std::string body;
+    
+    if (match.queryParameter("since", since)) {
+        uint64_t sinceVersion = 0;
+        if (!parseNumber(since, sinceVersion)) {
+            response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_BAD_REQUEST, "Bad version");
+            response.send() << "Expected since= a version from an earlier response";
+            return;
+        }
+        // Changes anywhere are sent, so clients can drop e-bikes that left their viewport. A client
+        // more than half the fleet behind gets the full (viewport) collection below instead; so does
+        // one holding a version from before a restart, since every e-bike has changed after it.
+        std::shared_ptr<const FleetSnapshot> snapshot = _fleet.current();
+        if (snapshot->changedSince(sinceVersion, snapshot->size() / 2, slots)) {
+            body.clear();
+            appendDelta(body, *snapshot, sinceVersion, slots);
+            sendBody(response, "application/json", body);
+            return;
+        }
+    }
     
-    // Create a GeoJSON FeatureCollection
-    Poco::JSON::Object::Ptr featureCollection = new Poco::JSON::Object;
-    featureCollection->set("type", "FeatureCollection");
-    featureCollection->set("features", _ebikes);
+    if (!hasBox) {
+        sendCached(request, response);
+        return;
+    }
     
-    // Write the response
-    std::ostream& out = response.send();
-    featureCollection->stringify(out);
+    // Only the viewport is serialised
+    std::shared_ptr<const FleetSnapshot> snapshot = _fleet.current();
+    snapshot->queryBox(minLatitudeE6, minLongitudeE6, maxLatitudeE6, maxLongitudeE6, slots);
+    body.clear();
+    appendFeatureCollection(body, *snapshot, slots);
+    sendBody(response, "application/json", body);
 }
 
-// FileHandler implementation
-FileHandler::FileHandler(const std::string& filePath) : _filePath(filePath) {
+void EBikeHandler::sendCached(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response) {
+    // The FeatureCollection is only re-serialised when a newer snapshot was published, and only
+    // compressed by the first request for each coding
+    std::shared_ptr<const CachedFeatureCollection> cached = _cache.get();
+    ContentEncoding encoding = negotiateEncoding(request.get("Accept-Encoding", ""));
+    const std::string* body = cached->encoded(encoding);
+    if (!body) {
+        encoding = ContentEncoding::Identity;
+        body = &cached->body;
+    }
+    
+    // Clients revalidate every poll and get an empty 304 while nothing changed
+    response.set("Cache-Control", "no-cache");
+    response.set("Vary", "Accept-Encoding");
+    response.set("ETag", cached->etag(encoding));
+    if (request.has("If-None-Match") && cached->matches(request.get("If-None-Match"), encoding)) {
+        sendNotModified(response);
+        return;
+    }
+    if (encoding != ContentEncoding::Identity) {
+        response.set("Content-Encoding", encodingName(encoding));
+    }
+    sendBody(response, "application/json", *body);
+}
+
+// EBikeNearestHandler implementation
+EBikeNearestHandler::EBikeNearestHandler(FleetPublisher& fleet) : _fleet(fleet) {
+}
+
+void EBikeNearestHandler::handleRequest(Poco::Net::HTTPServerRequest&, Poco::Net::HTTPServerResponse& response,
+                                        const RouteMatch& match) {
+    std::string_view value;
+    int32_t latitudeE6 = 0, longitudeE6 = 0;
+    std::size_t count = DefaultCount;
+    std::optional<EBikeStatus> status;
+    bool valid = match.queryParameter("lat", value) && parseCoordinate(value, 90.0, latitudeE6)
+        && match.queryParameter("lon", value) && parseCoordinate(value, 180.0, longitudeE6);
+    if (valid && match.queryParameter("k", value)) {
+        valid = parseNumber(value, count) && count >= 1 && count <= MaxCount;
+    }
+    if (valid && match.queryParameter("status", value)) {
+        EBikeStatus parsed;
+        valid = parseStatus(value, parsed);
+        status = parsed;
+    }
+    if (!valid) {
+        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_BAD_REQUEST, "Bad nearest request");
+        response.send() << "Expected /ebikes/nearest?lat=&lon= in degrees, with optional k (1-" << MaxCount
+                        << ") and status (unlocked, locked or maintenance)";
+        return;
+    }
+    
+    thread_local std::vector<NearbyBike> nearby;
+    thread_local std::string body;
+    std::shared_ptr<const FleetSnapshot> snapshot = _fleet.current();
+    snapshot->nearest(latitudeE6, longitudeE6, count, status, nearby);
+    body.clear();
+    appendNearest(body, *snapshot, nearby);
+    sendBody(response, "application/json", body);
+}
+
+// EBikeStreamHandler implementation
+EBikeStreamHandler::EBikeStreamHandler(FeatureCollectionCache& cache, StreamPusher& pusher) : _cache(cache), _pusher(pusher) {
 }
 
-void FileHandler::handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response) {
-    std::string path = _filePath;
+void EBikeStreamHandler::handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+                                       const RouteMatch&) {
+    if (!_pusher.reserve()) {
+        sendTooManySubscribers(response);
+        return;
+    }
+    response.setContentType("text/event-stream");
+    response.set("Cache-Control", "no-cache");
+    response.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
     
     try {
-        // Open the file
-        std::ifstream file(path.c_str());
-        if (!file.good()) {
-            response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_FOUND, "File not found");
-            response.send() << "File not found: " << path;
+        // The full collection is shared with /ebikes; deltas then follow from its version
+        std::shared_ptr<const CachedFeatureCollection> cached = _cache.get();
+        std::ostream& out = response.send();
+        out << "event: snapshot\ndata: " << cached->body << "\n\n";
+        out.flush();
+        if (!out.good()) {
+            _pusher.release();
             return;
         }
-        
-        // Set content type based on file extension
-        std::string contentType = "text/html";
-        if (path.find(".css") != std::string::npos) {
-            contentType = "text/css";
-        } else if (path.find(".js") != std::string::npos) {
-            contentType = "application/javascript";
-        }
-        
-        response.setContentType(contentType);
-        response.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
-        
-        // Copy file content to response
-        std::ostream& out = response.send();
-        Poco::StreamCopier::copyStream(file, out);
-    } catch (std::exception& e) {
-        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_INTERNAL_SERVER_ERROR, e.what());
-        response.send() << "Internal server error: " << e.what();
+        // The connection leaves the server thread here
+        _pusher.addEventStream(static_cast<Poco::Net::HTTPServerRequestImpl&>(request).detachSocket(), cached->version);
+    } catch (const std::exception&) {
+        // The client went away
+        _pusher.release();
     }
 }
 
-// RequestHandlerFactory implementation
-RequestHandlerFactory::RequestHandlerFactory(Poco::JSON::Array::Ptr& ebikes) : _ebikes(ebikes) {
+// EBikeSocketHandler implementation
+EBikeSocketHandler::EBikeSocketHandler(FleetFrameStream& frames, StreamPusher& pusher) : _frames(frames), _pusher(pusher) {
 }
 
-Poco::Net::HTTPRequestHandler* RequestHandlerFactory::createRequestHandler(const Poco::Net::HTTPServerRequest& request) {
-    std::string uri = request.getURI();
+void EBikeSocketHandler::handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+                                       const RouteMatch&) {
+    if (!_pusher.reserve()) {
+        sendTooManySubscribers(response);
+        return;
+    }
+    std::unique_ptr<Poco::Net::WebSocket> socket;
+    try {
+        socket = std::make_unique<Poco::Net::WebSocket>(request, response);
+    } catch (const Poco::Net::WebSocketException&) {
+        _pusher.release();
+        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_BAD_REQUEST, "WebSocket upgrade required");
+        response.setContentLength(0);
+        response.send();
+        return;
+    }
     
-    // Handle the ebikes API endpoint
-    if (uri == "/ebikes") {
-        return new EBikeHandler(_ebikes);
+    try {
+        std::shared_ptr<const EncodedFleetFrame> frame = _frames.keyframe();
+        socket->sendFrame(frame->bytes.data(), static_cast<int>(frame->bytes.size()), Poco::Net::WebSocket::FRAME_BINARY);
+        // The upgraded connection is no longer the server's; the pusher takes it from here
+        _pusher.addWebSocket(*socket, frame->version);
+    } catch (const std::exception&) {
+        // The dashboard went away
+        _pusher.release();
+    }
+}
+
+// EBikeHistoryHandler implementation
+EBikeHistoryHandler::EBikeHistoryHandler(FleetPublisher& fleet) : _fleet(fleet) {
+}
+
+bool EBikeHistoryHandler::parseRequest(const RouteMatch& match, int& ebikeId, int64_t& fromMs, int64_t& toMs) {
+    if (!parseNumber(match.parameter("id"), ebikeId)) {
+        return false;
+    }
+
+    fromMs = std::numeric_limits<int64_t>::min();
+    toMs = std::numeric_limits<int64_t>::max();
+    std::string_view value;
+    if (match.queryParameter("from", value) && !parseTimeBound(value, fromMs)) {
+        return false;
+    }
+    if (match.queryParameter("to", value) && !parseTimeBound(value, toMs)) {
+        return false;
+    }
+    return true;
+}
+
+void EBikeHistoryHandler::handleRequest(Poco::Net::HTTPServerRequest&, Poco::Net::HTTPServerResponse& response,
+                                        const RouteMatch& match) {
+    int ebikeId = 0;
+    int64_t fromMs = 0;
+    int64_t toMs = 0;
+    if (!parseRequest(match, ebikeId, fromMs, toMs)) {
+        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_BAD_REQUEST, "Bad history request");
+        response.send() << "Expected /ebikes/{id}/history with optional from and to as ISO 8601 or epoch milliseconds";
+        return;
+    }
+
+    std::shared_ptr<const FleetSnapshot> snapshot = _fleet.current();
+    std::size_t slot = 0;
+    if (!snapshot->find(ebikeId, slot)) {
+        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_FOUND, "Unknown eBike");
+        response.send() << "Unknown eBike: " << ebikeId;
+        return;
+    }
+
+    // Both buffers keep their capacity between requests served by this thread
+    thread_local std::vector<TrackSample> samples;
+    thread_local std::string body;
+    snapshot->history(slot, fromMs, toMs, samples);
+    body.clear();
+    appendTrack(body, ebikeId, samples);
+
+    sendBody(response, "application/geo+json", body);
+}
+
+// FileHandler implementation
+FileHandler::FileHandler(const StaticAssets& assets) : _assets(assets) {
+}
+
+void FileHandler::handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+                                const RouteMatch&) {
+    const StaticAsset* asset = _assets.find(request.getURI());
+    if (!asset) {
+        // Probes for unknown paths end here without touching the disk
+        static constexpr std::string_view NotFound = "Not found";
+        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_FOUND, "Not found");
+        response.setContentType("text/plain");
+        response.setContentLength(static_cast<std::streamsize>(NotFound.size()));
+        response.sendBuffer(NotFound.data(), NotFound.size());
+        return;
     }
     
-    // Handle the main page (map.html)
-    if (uri == "/" || uri == "/index.html") {
-        return new FileHandler("src/html/map.html");
+    bool gzip = !asset->gzip.empty()
+        && negotiateEncoding(request.get("Accept-Encoding", "")) == ContentEncoding::Gzip;
+    const std::string& etag = gzip ? asset->gzipEtag : asset->etag;
+    response.set("ETag", etag);
+    response.set("Cache-Control", "no-cache");
+    if (!asset->gzip.empty()) {
+        response.set("Vary", "Accept-Encoding");
+    }
+    if (request.has("If-None-Match") && etagMatches(request.get("If-None-Match"), etag)) {
+        sendNotModified(response);
+        return;
+    }
+    if (gzip) {
+        response.set("Content-Encoding", "gzip");
+    }
+    sendBody(response, asset->contentType.c_str(), gzip ? asset->gzip : asset->body);
+}
+
+// MetricsHandler implementation
+MetricsHandler::MetricsHandler(FleetPublisher& fleet) : _fleet(fleet) {
+}
+
+void MetricsHandler::handleRequest(Poco::Net::HTTPServerRequest&, Poco::Net::HTTPServerResponse& response,
+                                   const RouteMatch&) {
+    thread_local std::string body;
+    body.clear();
+    Metrics::appendPrometheus(body);
+    std::shared_ptr<const FleetSnapshot> snapshot = _fleet.current();
+    Metrics::appendSample(body, "ebike_fleet_size", "E-bikes in the last published snapshot.", "gauge", snapshot->size());
+    Metrics::appendSample(body, "ebike_fleet_version", "Version of the last published snapshot.", "gauge", snapshot->version());
+    StageLatencies::appendPrometheus(body);
+    response.set("Cache-Control", "no-store");
+    sendBody(response, "text/plain; version=0.0.4; charset=utf-8", body);
+}
+
+// LatencyHandler implementation
+void LatencyHandler::handleRequest(Poco::Net::HTTPServerRequest&, Poco::Net::HTTPServerResponse& response,
+                                   const RouteMatch&) {
+    thread_local std::string body;
+    body.clear();
+    StageLatencies::appendTable(body);
+    response.set("Cache-Control", "no-store");
+    sendBody(response, "text/plain; charset=utf-8", body);
+}
+
+// RequestHandlerFactory implementation
+RequestHandlerFactory::RequestHandlerFactory(FleetPublisher& fleet, int streamRate, const std::string& assetDirectory,
+                                             std::size_t maxStreamSubscribers)
+    : _fleet(fleet), _featureCollectionCache(fleet), _stream(fleet, streamRate), _frames(fleet, streamRate),
+      _pusher(_featureCollectionCache, _stream, _frames, maxStreamSubscribers),
+      _ebikes(_featureCollectionCache, fleet), _ebikeStream(_featureCollectionCache, _pusher), _ebikeSocket(_frames, _pusher),
+      _ebikeNearest(fleet), _ebikeHistory(fleet), _metrics(fleet), _files(_assets) {
+    if (_assets.load(assetDirectory) == 0) {
+        EBIKE_LOG(LogLevel::Warn) << "No static files found in " << assetDirectory << "; only the API is served";
     }
     
-    // Default: Not found
-    return new FileHandler("src/html/map.html"); // Return map.html for all other paths
-}
\ No newline at end of file
+    addRoute("/ebikes", _ebikes);
+    addRoute("/ebikes/stream", _ebikeStream);
+    addRoute("/ebikes/ws", _ebikeSocket);
+    addRoute("/ebikes/nearest", _ebikeNearest);
+    addRoute("/ebikes/{id}/history", _ebikeHistory);
+    addRoute("/metrics", _metrics);
+    addRoute("/latency", _latency);
+}
+
+void RequestHandlerFactory::addRoute(std::string_view pattern, RouteHandler& handler) {
+    _router.add(pattern, _routes.size());
+    _routes.push_back(&handler);
+}
+
+Poco::Net::HTTPRequestHandler* RequestHandlerFactory::createRequestHandler(const Poco::Net::HTTPServerRequest& request) {
+    // Anything no route matches is a static file or a 404
+    RouteMatch match;
+    RouteHandler& handler = _router.match(request.getURI(), match) ? *_routes[match.route] : _files;
+    return new RoutedRequest(handler, match);
+}
@@ -6,39 +6,180 @@
 
 #include <Poco/Net/HTTPRequestHandlerFactory.h>
 #include <Poco/Net/HTTPRequestHandler.h>
-#include <Poco/JSON/Array.h>
 #include <Poco/Net/HTTPServerRequest.h>
 #include <Poco/Net/HTTPServerResponse.h>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "fleet/FleetPublisher.h"
+#include "FeatureCollectionCache.h"
+#include "FleetStream.h"
+#include "FleetFrameStream.h"
+#include "StreamPusher.h"
+#include "StaticAssets.h"
+#include "Router.h"
 
 
-// EBikeHandler: Handles requests to the /ebikes endpoint
-class EBikeHandler : public Poco::Net::HTTPRequestHandler {
+// RouteHandler: Answers the requests of one route. Each is made once by the factory and shared by
+// every server thread, so implementations keep no per-request state in members.
+class RouteHandler {
 public:
-    explicit EBikeHandler(Poco::JSON::Array::Ptr& ebikes);
-    void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response) override;
+    virtual ~RouteHandler() = default;
+    virtual void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+                               const RouteMatch& match) = 0;
+};
+
+// EBikeHandler: Handles requests to the /ebikes endpoint. With bbox=minLon,minLat,maxLon,maxLat
+// only the e-bikes inside the box are serialised, found through the snapshot's grid index.
+// With since=<version>, taken from the "version" of an earlier response, only the e-bikes changed
+// after that version are sent, falling back to the full collection when too much has changed.
+class EBikeHandler : public RouteHandler {
+public:
+    EBikeHandler(FeatureCollectionCache& cache, FleetPublisher& fleet);
+    void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+                       const RouteMatch& match) override;
+
+    // Parse a bbox value into microdegrees; false unless it has four numbers with min <= max
+    static bool parseBoundingBox(std::string_view value, int32_t& minLatitudeE6, int32_t& minLongitudeE6,
+                                 int32_t& maxLatitudeE6, int32_t& maxLongitudeE6);
+
+private:
+    // Send the cached FeatureCollection, compressed as the client accepts, or 304 if its ETag matches
+    void sendCached(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response);
+
+    FeatureCollectionCache& _cache;
+    FleetPublisher& _fleet;
+};
+
+// EBikeNearestHandler: Handles requests to /ebikes/nearest?lat=&lon=[&k=][&status=], answering with
+// the k e-bikes closest to the position (optionally only those with the status), closest first
+class EBikeNearestHandler : public RouteHandler {
+public:
+    static constexpr std::size_t DefaultCount = 5;   // k when not given
+    static constexpr std::size_t MaxCount = 100;     // Largest k accepted
+
+    explicit EBikeNearestHandler(FleetPublisher& fleet);
+    void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+                       const RouteMatch& match) override;
+
+private:
+    FleetPublisher& _fleet;
+};
+
+// EBikeStreamHandler: Handles /ebikes/stream, a Server-Sent Events stream that starts with a
+// "snapshot" event holding the whole FeatureCollection and continues with "delta" events shared
+// with every other subscriber. After the snapshot the connection is handed to the StreamPusher,
+// which frees the server thread; over the pusher's subscriber limit the answer is 503.
+class EBikeStreamHandler : public RouteHandler {
+public:
+    EBikeStreamHandler(FeatureCollectionCache& cache, StreamPusher& pusher);
+    void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+                       const RouteMatch& match) override;
+
+private:
+    FeatureCollectionCache& _cache;
+    StreamPusher& _pusher;
+};
+
+// EBikeSocketHandler: Handles /ebikes/ws, a WebSocket pushing binary FleetFrame messages: a
+// keyframe with every e-bike, then deltas shared with every other subscriber. A subscriber that
+// misses a delta is sent a fresh keyframe. Like the SSE stream, it is handed to the StreamPusher
+// after the first keyframe, and answered 503 over the subscriber limit.
+class EBikeSocketHandler : public RouteHandler {
+public:
+    EBikeSocketHandler(FleetFrameStream& frames, StreamPusher& pusher);
+    void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+                       const RouteMatch& match) override;
+
+private:
+    FleetFrameStream& _frames;
+    StreamPusher& _pusher;
+};
+
+// EBikeHistoryHandler: Handles requests to /ebikes/{id}/history[?from=...&to=...]
+class EBikeHistoryHandler : public RouteHandler {
+public:
+    explicit EBikeHistoryHandler(FleetPublisher& fleet);
+    void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+                       const RouteMatch& match) override;
+
+    // Read the id and the from and to bounds of a matched /ebikes/{id}/history; false if malformed.
+    // Bounds may be ISO 8601 timestamps or epoch milliseconds and default to the whole history.
+    static bool parseRequest(const RouteMatch& match, int& ebikeId, int64_t& fromMs, int64_t& toMs);
 
 private:
-    Poco::JSON::Array::Ptr& _ebikes;
+    FleetPublisher& _fleet;
 };
 
-// FileHandler: Handles requests for static files (e.g., map.html)
-class FileHandler : public Poco::Net::HTTPRequestHandler {
+// FileHandler: Handles requests for static files (e.g., map.html) from the assets loaded at startup,
+// with 304s for matching ETags and the precompressed form for clients accepting gzip. It answers
+// every path no route matched, with 404 for paths that are not a loaded file.
+class FileHandler : public RouteHandler {
 public:
-    explicit FileHandler(const std::string& filePath);
-    void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response) override;
+    explicit FileHandler(const StaticAssets& assets);
+    void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+                       const RouteMatch& match) override;
 
 private:
-    std::string _filePath;
+    const StaticAssets& _assets;
 };
 
-// RequestHandlerFactory: Maps incoming requests to the appropriate handler
+// MetricsHandler: Handles /metrics, the gateway's counters and gauges and the fleet's size in the
+// Prometheus text format. Values are summed over threads only here, when scraped.
+class MetricsHandler : public RouteHandler {
+public:
+    explicit MetricsHandler(FleetPublisher& fleet);
+    void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+                       const RouteMatch& match) override;
+
+private:
+    FleetPublisher& _fleet;
+};
+
+// LatencyHandler: Handles /latency, a table of each ingest stage's latency percentiles merged over
+// the ingest threads, the same table the gateway prints on SIGUSR1
+class LatencyHandler : public RouteHandler {
+public:
+    void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+                       const RouteMatch& match) override;
+};
+
+// RequestHandlerFactory: Maps incoming requests to the appropriate handler. The routes and their
+// handlers are built once, here; per request only a small forwarding object is made, recycled by
+// the server thread, as Poco deletes whatever createRequestHandler returns.
 class RequestHandlerFactory : public Poco::Net::HTTPRequestHandlerFactory {
 public:
-    explicit RequestHandlerFactory(Poco::JSON::Array::Ptr& ebikes);
+    // Static files are read from assetDirectory once, here. At most maxStreamSubscribers connect to
+    // /ebikes/stream and /ebikes/ws together.
+    RequestHandlerFactory(FleetPublisher& fleet, int streamRate = FleetStream::DefaultRate,
+                          const std::string& assetDirectory = StaticAssets::defaultDirectory(),
+                          std::size_t maxStreamSubscribers = StreamPusher::DefaultMaxSubscribers);
     Poco::Net::HTTPRequestHandler* createRequestHandler(const Poco::Net::HTTPServerRequest& request) override;
 
 private:
-    Poco::JSON::Array::Ptr& _ebikes;
+    // Route a pattern to a handler owned by the factory
+    void addRoute(std::string_view pattern, RouteHandler& handler);
+
+    FleetPublisher& _fleet;
+    FeatureCollectionCache _featureCollectionCache;
+    FleetStream _stream;
+    FleetFrameStream _frames;
+    StreamPusher _pusher;  // Before the handlers using it, after the streams it reads
+    StaticAssets _assets;
+
+    EBikeHandler _ebikes;
+    EBikeStreamHandler _ebikeStream;
+    EBikeSocketHandler _ebikeSocket;
+    EBikeNearestHandler _ebikeNearest;
+    EBikeHistoryHandler _ebikeHistory;
+    MetricsHandler _metrics;
+    LatencyHandler _latency;
+    FileHandler _files;
+
+    Router _router;
+    std::vector<RouteHandler*> _routes;  // Handlers by route number
 };
 
 #endif // EBIKEHANDLER_H
\ No newline at end of file
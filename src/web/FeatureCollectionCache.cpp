@@ -0,0 +1,55 @@
+// src/web/FeatureCollectionCache.cpp
+#include "FeatureCollectionCache.h"
+#include <chrono>
+#include "GeoJson.h"
+#include "ETag.h"
+
+const std::string* CachedFeatureCollection::encoded(ContentEncoding encoding) const {
+    if (encoding == ContentEncoding::Identity) {
+        return &body;
+    }
+    int index = static_cast<int>(encoding);
+    std::call_once(_compressOnce[index], [&] {
+        _compressedOk[index] = compress(body, encoding, _compressed[index]);
+    });
+    return _compressedOk[index] ? &_compressed[index] : nullptr;
+}
+
+bool CachedFeatureCollection::matches(std::string_view ifNoneMatch, ContentEncoding encoding) const {
+    return etagMatches(ifNoneMatch, etag(encoding));
+}
+
+FeatureCollectionCache::FeatureCollectionCache(FleetPublisher& fleet)
+    : _fleet(fleet),
+      _epoch(std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count())) {
+}
+
+std::shared_ptr<const CachedFeatureCollection> FeatureCollectionCache::get() {
+    std::shared_ptr<const FleetSnapshot> snapshot = _fleet.current();
+
+    // Fast path: the cached body already matches the published snapshot
+    std::shared_ptr<const CachedFeatureCollection> cached = std::atomic_load(&_cached);
+    if (cached && cached->version >= snapshot->version()) {
+        return cached;
+    }
+
+    // Only one thread rebuilds; the others wait and then reuse its result
+    std::lock_guard<std::mutex> lock(_rebuildMutex);
+    cached = std::atomic_load(&_cached);
+    if (cached && cached->version >= snapshot->version()) {
+        return cached;
+    }
+
+    auto rebuilt = std::make_shared<CachedFeatureCollection>();
+    rebuilt->version = snapshot->version();
+    appendFeatureCollection(rebuilt->body, *snapshot);
+    std::string tag = '"' + _epoch + '-' + std::to_string(rebuilt->version);
+    rebuilt->etags[static_cast<int>(ContentEncoding::Identity)] = tag + '"';
+    rebuilt->etags[static_cast<int>(ContentEncoding::Gzip)] = tag + "-gzip\"";
+    rebuilt->etags[static_cast<int>(ContentEncoding::Deflate)] = tag + "-deflate\"";
+
+    cached = rebuilt;
+    std::atomic_store(&_cached, cached);
+    return cached;
+}
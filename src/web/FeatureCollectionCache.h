@@ -0,0 +1,53 @@
+#pragma once
+
+#ifndef FEATURECOLLECTIONCACHE_H
+#define FEATURECOLLECTIONCACHE_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include "fleet/FleetPublisher.h"
+#include "Compression.h"
+
+// CachedFeatureCollection: Serialised /ebikes body for one store version. Compressed forms
+// are made by the first request asking for them and then shared like the body itself.
+struct CachedFeatureCollection {
+    uint64_t version;      // Store version the body was built from
+    std::string body;      // GeoJSON FeatureCollection
+    std::string etags[3];  // Strong ETag per ContentEncoding, indexed by its value
+
+    // Get the body in a coding, compressing it on first use; null if compression failed
+    const std::string* encoded(ContentEncoding encoding) const;
+
+    // Get the strong ETag of the body in a coding; unique to the version and this gateway run
+    const std::string& etag(ContentEncoding encoding) const { return etags[static_cast<int>(encoding)]; }
+
+    // Check an If-None-Match header against the ETag of the coding the response is sent in
+    bool matches(std::string_view ifNoneMatch, ContentEncoding encoding) const;
+
+private:
+    mutable std::once_flag _compressOnce[3];
+    mutable std::string _compressed[3];
+    mutable bool _compressedOk[3] = {};
+};
+
+// FeatureCollectionCache: Keeps the serialised FeatureCollection of the latest
+// published snapshot. The body is rebuilt only when a snapshot with a newer
+// version has been published; otherwise every request shares the same buffer.
+class FeatureCollectionCache {
+public:
+    explicit FeatureCollectionCache(FleetPublisher& fleet);
+
+    // Get the body for the current snapshot, rebuilding it if it is stale
+    std::shared_ptr<const CachedFeatureCollection> get();
+
+private:
+    FleetPublisher& _fleet;
+    std::string _epoch;                                       // Tells versions of different gateway runs apart
+    std::shared_ptr<const CachedFeatureCollection> _cached;  // Accessed atomically
+    std::mutex _rebuildMutex;                                 // Serialises rebuilds only
+};
+
+#endif // FEATURECOLLECTIONCACHE_H
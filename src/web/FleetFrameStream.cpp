@@ -0,0 +1,99 @@
+// src/web/FleetFrameStream.cpp
+#include "FleetFrameStream.h"
+#include <algorithm>
+
+FleetFrameStream::FleetFrameStream(FleetPublisher& fleet, int framesPerSecond, int32_t quantumE6)
+    : _fleet(fleet), _interval(std::chrono::milliseconds(1000 / std::max(1, framesPerSecond))), _encoder(quantumE6) {
+}
+
+std::shared_ptr<const EncodedFleetFrame> FleetFrameStream::keyframe() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _frameReady.wait(lock, [this] { return !_building; });
+
+    if (!_latest) {
+        // The first subscriber starts the chain from the current snapshot
+        auto frame = std::make_shared<EncodedFleetFrame>();
+        std::shared_ptr<const FleetSnapshot> snapshot = _fleet.current();
+        _encoder.encodeKeyframe(*snapshot, frame->bytes);
+        frame->keyframe = true;
+        frame->since = 0;
+        frame->version = snapshot->version();
+        _sinceKeyframe = 0;
+        _checkedAt = std::chrono::steady_clock::now();
+        _latest = std::move(frame);
+    }
+    if (_latest->keyframe) {
+        return _latest;
+    }
+
+    // Later subscribers share one keyframe of the chain's state per version
+    if (!_joinFrame || _joinFrame->version != _latest->version) {
+        auto frame = std::make_shared<EncodedFleetFrame>();
+        _encoder.encodeView(frame->bytes);
+        frame->keyframe = true;
+        frame->since = 0;
+        frame->version = _latest->version;
+        _joinFrame = std::move(frame);
+    }
+    return _joinFrame;
+}
+
+std::shared_ptr<const EncodedFleetFrame> FleetFrameStream::next(uint64_t after, std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;) {
+        if (_latest && _latest->version > after) {
+            return _latest;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return nullptr;
+        }
+        if (!_latest) {
+            // Nothing to follow until a subscriber has called keyframe()
+            _frameReady.wait_until(lock, deadline);
+            continue;
+        }
+        if (_building || now < _checkedAt + _interval) {
+            _frameReady.wait_until(lock, std::min(deadline, _checkedAt + _interval));
+            continue;
+        }
+
+        // This subscriber checks the fleet for everyone
+        _checkedAt = now;
+        std::shared_ptr<const FleetSnapshot> snapshot = _fleet.current();
+        if (snapshot->version() <= _latest->version) {
+            continue;
+        }
+
+        // Encode without holding the lock; the others keep waiting on _building
+        _building = true;
+        lock.unlock();
+        auto frame = std::make_shared<EncodedFleetFrame>();
+        bool encoded = false;
+        try {
+            frame->keyframe = _sinceKeyframe + 1 >= KeyframeInterval || !_encoder.canDelta(*snapshot);
+            frame->since = frame->keyframe ? 0 : _encoder.version();
+            if (frame->keyframe) {
+                _encoder.encodeKeyframe(*snapshot, frame->bytes);
+                _sinceKeyframe = 0;
+                encoded = true;
+            } else if (_encoder.encodeDelta(*snapshot, frame->bytes)) {
+                ++_sinceKeyframe;
+                encoded = true;
+            }
+            frame->version = _encoder.version();
+        } catch (...) {
+            lock.lock();
+            _building = false;
+            _frameReady.notify_all();
+            throw;
+        }
+        lock.lock();
+        _building = false;
+        if (encoded) {
+            // Empty deltas are dropped; moves too small to encode go out with a later frame
+            _latest = std::move(frame);
+        }
+        _frameReady.notify_all();
+    }
+}
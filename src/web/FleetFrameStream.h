@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef FLEETFRAMESTREAM_H
+#define FLEETFRAMESTREAM_H
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "fleet/FleetPublisher.h"
+#include "proto/FleetFrame.h"
+
+// EncodedFleetFrame: One binary keyframe or delta, shared by every WebSocket subscriber
+struct EncodedFleetFrame {
+    bool keyframe;               // Replaces the receiver's state rather than updating it
+    uint64_t since;              // Version a delta applies to; 0 for keyframes
+    uint64_t version;            // Version the frame brings the receiver to
+    std::vector<uint8_t> bytes;  // FleetFrame wire format
+};
+
+// FleetFrameStream: Chain of binary frames for /ebikes/ws subscribers, built the same way as
+// FleetStream: no thread of its own, at most one frame per interval, each frame encoded once by
+// whichever waiting subscriber gets there first. Every KeyframeInterval-th frame is a keyframe,
+// and so is any frame after e-bikes moved to other slots.
+// Subscribers start from keyframe(), which encodes the chain's current state once per version.
+class FleetFrameStream {
+public:
+    static constexpr std::size_t KeyframeInterval = 30;  // Frames from one keyframe to the next
+
+    FleetFrameStream(FleetPublisher& fleet, int framesPerSecond, int32_t quantumE6 = FleetFrame::DefaultQuantumE6);
+
+    // Get a keyframe at the chain's latest version, starting the chain if this is the first subscriber
+    std::shared_ptr<const EncodedFleetFrame> keyframe();
+
+    // Wait for a frame newer than a version. Returns null if none arrived by the deadline. A delta
+    // whose since is not the caller's version means the caller missed a frame and must rejoin.
+    std::shared_ptr<const EncodedFleetFrame> next(uint64_t after, std::chrono::steady_clock::time_point deadline);
+
+    // Time between two frames
+    std::chrono::milliseconds interval() const { return _interval; }
+
+private:
+    FleetPublisher& _fleet;
+    std::chrono::milliseconds _interval;
+    std::mutex _mutex;
+    std::condition_variable _frameReady;
+    FleetFrameEncoder _encoder;                           // Used by the frame builder only, or under _mutex when idle
+    std::size_t _sinceKeyframe = 0;                       // Frames since the last keyframe (builder only)
+    std::shared_ptr<const EncodedFleetFrame> _latest;     // Guarded by _mutex
+    std::shared_ptr<const EncodedFleetFrame> _joinFrame;  // Keyframe of the latest version (guarded by _mutex)
+    std::chrono::steady_clock::time_point _checkedAt;     // Last look at the fleet (guarded by _mutex)
+    bool _building = false;                               // A subscriber is encoding a frame (guarded by _mutex)
+};
+
+#endif // FLEETFRAMESTREAM_H
@@ -0,0 +1,56 @@
+// src/web/FleetStream.cpp
+#include "FleetStream.h"
+#include <algorithm>
+#include <vector>
+#include "GeoJson.h"
+
+FleetStream::FleetStream(FleetPublisher& fleet, int framesPerSecond)
+    : _fleet(fleet), _interval(std::chrono::milliseconds(1000 / std::max(1, framesPerSecond))) {
+}
+
+std::shared_ptr<const StreamFrame> FleetStream::next(uint64_t after, std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;) {
+        if (_latest && _latest->version > after) {
+            return _latest;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return nullptr;
+        }
+        if (_building || now < _checkedAt + _interval) {
+            _frameReady.wait_until(lock, std::min(deadline, _checkedAt + _interval));
+            continue;
+        }
+
+        // This subscriber checks the fleet for everyone
+        _checkedAt = now;
+        uint64_t since = _latest ? _latest->version : after;
+        std::shared_ptr<const FleetSnapshot> snapshot = _fleet.current();
+        if (snapshot->version() <= since) {
+            continue;
+        }
+
+        // Serialise without holding the lock; the others keep waiting on _building
+        _building = true;
+        lock.unlock();
+        auto frame = std::make_shared<StreamFrame>();
+        try {
+            std::vector<std::size_t> slots;
+            snapshot->changedSince(since, snapshot->size(), slots);
+            frame->since = since;
+            frame->version = snapshot->version();
+            frame->event = "event: delta\ndata: ";
+            appendDelta(frame->event, *snapshot, since, slots);
+            frame->event += "\n\n";
+        } catch (...) {
+            lock.lock();
+            _building = false;
+            throw;
+        }
+        lock.lock();
+        _building = false;
+        _latest = std::move(frame);
+        _frameReady.notify_all();
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef FLEETSTREAM_H
+#define FLEETSTREAM_H
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include "fleet/FleetPublisher.h"
+
+// StreamFrame: One serialised Server-Sent Event carrying the e-bikes changed between two versions
+struct StreamFrame {
+    uint64_t since;     // Version the changes are relative to
+    uint64_t version;   // Snapshot version after the changes
+    std::string event;  // Complete "event: delta" SSE message, ready to write
+};
+
+// FleetStream: Turns published snapshots into delta frames shared by every /ebikes/stream
+// subscriber. There is no thread of its own: subscribers wait in next(), and whichever wakes
+// first once the frame interval has passed checks the fleet and, if it changed, serialises
+// the frame the others then reuse. Changes are coalesced so at most one frame goes out per
+// interval, and nothing is serialised while nobody is subscribed.
+class FleetStream {
+public:
+    static constexpr int DefaultRate = 5;  // Frames per second when not configured
+
+    // framesPerSecond is the highest frame rate; values below 1 mean one frame a second
+    FleetStream(FleetPublisher& fleet, int framesPerSecond = DefaultRate);
+
+    // Wait for a frame newer than a version. Returns null if none arrived by the deadline.
+    // A frame whose since is newer than the caller's version means the caller fell behind
+    // and has to resynchronise from a full collection.
+    std::shared_ptr<const StreamFrame> next(uint64_t after, std::chrono::steady_clock::time_point deadline);
+
+    // Time between two frames
+    std::chrono::milliseconds interval() const { return _interval; }
+
+private:
+    FleetPublisher& _fleet;
+    std::chrono::milliseconds _interval;
+    std::mutex _mutex;
+    std::condition_variable _frameReady;
+    std::shared_ptr<const StreamFrame> _latest;        // Guarded by _mutex
+    std::chrono::steady_clock::time_point _checkedAt;  // Last look at the fleet (guarded by _mutex)
+    bool _building = false;                            // A subscriber is serialising a frame (guarded by _mutex)
+};
+
+#endif // FLEETSTREAM_H
@@ -0,0 +1,159 @@
+// src/web/GeoJson.cpp
+#include "GeoJson.h"
+#include <charconv>
+#include "util/TimeCodec.h"
+
+void appendMicrodegrees(std::string& out, int32_t microdegrees) {
+    int64_t value = microdegrees;
+    if (value < 0) {
+        out += '-';
+        value = -value;
+    }
+
+    // Integer part
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value / 1000000);
+    out.append(digits, result.ptr);
+
+    // Fractional part, always six digits
+    char fraction[7] = {'.', '0', '0', '0', '0', '0', '0'};
+    int64_t remainder = value % 1000000;
+    for (int i = 6; i > 0; --i) {
+        fraction[i] = static_cast<char>('0' + remainder % 10);
+        remainder /= 10;
+    }
+    out.append(fraction, sizeof(fraction));
+}
+
+void appendTimestamp(std::string& out, int64_t timestampMs) {
+    char buffer[TimeCodec::SecondsSize];
+    out.append(buffer, TimeCodec::formatSeconds(timestampMs, buffer));
+}
+
+namespace {
+
+// Append a Feature for one slot without closing its properties object
+void appendOpenFeature(std::string& out, const FleetSnapshot& snapshot, std::size_t slot) {
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), snapshot.ids()[slot]);
+
+    // GeoJSON uses [lon, lat] order
+    out += "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\",\"coordinates\":[";
+    appendMicrodegrees(out, snapshot.longitudes()[slot]);
+    out += ',';
+    appendMicrodegrees(out, snapshot.latitudes()[slot]);
+    out += "]},\"properties\":{\"id\":";
+    out.append(digits, result.ptr);
+    out += ",\"timestamp\":\"";
+    appendTimestamp(out, snapshot.timestamps()[slot]);
+    out += "\",\"status\":\"";
+    out += statusName(snapshot.statuses()[slot]);
+    out += '"';
+}
+
+// Open a FeatureCollection stamped with the snapshot version, up to its features array
+void appendCollectionStart(std::string& out, const FleetSnapshot& snapshot) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), snapshot.version());
+    out += "{\"type\":\"FeatureCollection\",\"version\":";
+    out.append(digits, result.ptr);
+    out += ",\"features\":[";
+}
+
+}
+
+void appendFeature(std::string& out, const FleetSnapshot& snapshot, std::size_t slot) {
+    appendOpenFeature(out, snapshot, slot);
+    out += "}}";
+}
+
+void appendFeatureCollection(std::string& out, const FleetSnapshot& snapshot) {
+    // Roughly 150 bytes per feature
+    out.reserve(out.size() + 64 + snapshot.size() * 160);
+
+    appendCollectionStart(out, snapshot);
+    for (std::size_t slot = 0; slot < snapshot.size(); ++slot) {
+        if (slot > 0) {
+            out += ',';
+        }
+        appendFeature(out, snapshot, slot);
+    }
+    out += "]}";
+}
+
+void appendFeatureCollection(std::string& out, const FleetSnapshot& snapshot, const std::vector<std::size_t>& slots) {
+    out.reserve(out.size() + 64 + slots.size() * 160);
+
+    appendCollectionStart(out, snapshot);
+    for (std::size_t i = 0; i < slots.size(); ++i) {
+        if (i > 0) {
+            out += ',';
+        }
+        appendFeature(out, snapshot, slots[i]);
+    }
+    out += "]}";
+}
+
+void appendDelta(std::string& out, const FleetSnapshot& snapshot, uint64_t since, const std::vector<std::size_t>& slots) {
+    appendFeatureCollection(out, snapshot, slots);
+
+    // "since" goes last so the delta shares the FeatureCollection layout
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), since);
+    out.pop_back();
+    out += ",\"since\":";
+    out.append(digits, result.ptr);
+    out += '}';
+}
+
+void appendNearest(std::string& out, const FleetSnapshot& snapshot, const std::vector<NearbyBike>& nearby) {
+    out.reserve(out.size() + 64 + nearby.size() * 180);
+
+    out += "{\"type\":\"FeatureCollection\",\"features\":[";
+    for (std::size_t i = 0; i < nearby.size(); ++i) {
+        if (i > 0) {
+            out += ',';
+        }
+        appendOpenFeature(out, snapshot, nearby[i].slot);
+
+        // Whole decimetres are plenty for walking distances
+        char digits[32];
+        auto result = std::to_chars(digits, digits + sizeof(digits), nearby[i].distanceMeters, std::chars_format::fixed, 1);
+        out += ",\"distance\":";
+        out.append(digits, result.ptr);
+        out += "}}";
+    }
+    out += "]}";
+}
+
+void appendTrack(std::string& out, int ebikeId, const std::vector<TrackSample>& samples) {
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), ebikeId);
+
+    // Roughly 25 bytes per coordinate pair and 23 per timestamp
+    out.reserve(out.size() + 128 + samples.size() * 48);
+
+    out += "{\"type\":\"Feature\",\"geometry\":";
+    if (samples.empty()) {
+        out += "null";
+    } else {
+        out += "{\"type\":\"LineString\",\"coordinates\":[";
+        for (std::size_t i = 0; i < samples.size(); ++i) {
+            out += i > 0 ? ",[" : "[";
+            appendMicrodegrees(out, samples[i].longitudeE6);
+            out += ',';
+            appendMicrodegrees(out, samples[i].latitudeE6);
+            out += ']';
+        }
+        out += "]}";
+    }
+    out += ",\"properties\":{\"id\":";
+    out.append(digits, result.ptr);
+    out += ",\"timestamps\":[";
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        out += i > 0 ? ",\"" : "\"";
+        appendTimestamp(out, samples[i].timestampMs);
+        out += '"';
+    }
+    out += "]}}";
+}
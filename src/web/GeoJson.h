@@ -0,0 +1,44 @@
+#pragma once
+
+#ifndef GEOJSON_H
+#define GEOJSON_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "fleet/FleetSnapshot.h"
+#include "fleet/TrackHistory.h"
+
+// GeoJSON serialisation of published fleet snapshots. Output is appended to a
+// caller-owned string so the buffer can be reused or cached.
+
+// Append a fixed-point microdegree value as a decimal number with six digits
+void appendMicrodegrees(std::string& out, int32_t microdegrees);
+
+// Append an epoch-millisecond timestamp as an ISO 8601 UTC string (without quotes)
+void appendTimestamp(std::string& out, int64_t timestampMs);
+
+// Append the Feature for one slot of the snapshot
+void appendFeature(std::string& out, const FleetSnapshot& snapshot, std::size_t slot);
+
+// Append a FeatureCollection containing every e-bike in the snapshot. Collections carry the
+// snapshot version in a "version" member, for clients to ask for changes since.
+void appendFeatureCollection(std::string& out, const FleetSnapshot& snapshot);
+
+// Append a FeatureCollection containing the e-bikes in the given slots of the snapshot
+void appendFeatureCollection(std::string& out, const FleetSnapshot& snapshot, const std::vector<std::size_t>& slots);
+
+// Append a FeatureCollection of the e-bikes changed since a version, marked with that version
+// in a "since" member to tell it apart from a full collection
+void appendDelta(std::string& out, const FleetSnapshot& snapshot, uint64_t since, const std::vector<std::size_t>& slots);
+
+// Append a FeatureCollection of nearest e-bikes, closest first, with each e-bike's distance from the
+// query position in meters in the "distance" property
+void appendNearest(std::string& out, const FleetSnapshot& snapshot, const std::vector<NearbyBike>& nearby);
+
+// Append a Feature whose LineString geometry is an e-bike's track, oldest position first,
+// with the time of every position in the "timestamps" property (null geometry if empty)
+void appendTrack(std::string& out, int ebikeId, const std::vector<TrackSample>& samples);
+
+#endif // GEOJSON_H
@@ -0,0 +1,132 @@
+// src/web/Router.cpp
+#include "Router.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Take the next segment off a path that starts with '/'
+std::string_view nextSegment(std::string_view& path) {
+    std::size_t slash = path.find('/', 1);
+    std::string_view segment = path.substr(1, slash == std::string_view::npos ? std::string_view::npos : slash - 1);
+    path = slash == std::string_view::npos ? std::string_view() : path.substr(slash);
+    return segment;
+}
+
+// Order of a node's literal children, and lookup of a segment among them
+bool segmentLess(const std::pair<std::string, std::size_t>& child, std::string_view segment) {
+    return std::string_view(child.first) < segment;
+}
+
+}
+
+std::string_view RouteMatch::parameter(std::string_view name) const {
+    for (std::size_t i = 0; i < parameterCount; ++i) {
+        if (names[i] == name) {
+            return values[i];
+        }
+    }
+    return std::string_view();
+}
+
+bool RouteMatch::queryParameter(std::string_view name, std::string_view& value) const {
+    std::string_view rest = query;
+    while (!rest.empty()) {
+        std::size_t ampersand = rest.find('&');
+        std::string_view parameter = rest.substr(0, ampersand);
+        rest = ampersand == std::string_view::npos ? std::string_view() : rest.substr(ampersand + 1);
+
+        std::size_t equals = parameter.find('=');
+        if (parameter.substr(0, equals) == name) {
+            value = equals == std::string_view::npos ? std::string_view() : parameter.substr(equals + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Router::add(std::string_view pattern, std::size_t route) {
+    if (pattern.empty() || pattern.front() != '/') {
+        throw std::invalid_argument("Route pattern must start with '/': " + std::string(pattern));
+    }
+
+    std::size_t node = 0;
+    std::size_t parameters = 0;
+    std::string_view path = pattern == "/" ? std::string_view() : pattern;
+    while (!path.empty()) {
+        std::string_view segment = nextSegment(path);
+        std::size_t child = None;
+        if (segment.size() > 2 && segment.front() == '{' && segment.back() == '}') {
+            std::string_view name = segment.substr(1, segment.size() - 2);
+            if (++parameters > RouteMatch::MaxParameters) {
+                throw std::invalid_argument("Too many parameters in route pattern: " + std::string(pattern));
+            }
+            if (_nodes[node].parameter == None) {
+                child = _nodes.size();
+                _nodes[node].parameter = child;
+                _nodes[node].parameterName = std::string(name);
+                _nodes.emplace_back();
+            } else if (_nodes[node].parameterName != name) {
+                throw std::invalid_argument("Route pattern renames a parameter: " + std::string(pattern));
+            } else {
+                child = _nodes[node].parameter;
+            }
+        } else {
+            auto& literals = _nodes[node].literals;
+            auto found = std::lower_bound(literals.begin(), literals.end(), segment, segmentLess);
+            if (found != literals.end() && found->first == segment) {
+                child = found->second;
+            } else {
+                child = _nodes.size();
+                literals.emplace(found, std::string(segment), child);
+                _nodes.emplace_back();
+            }
+        }
+        node = child;
+    }
+
+    if (_nodes[node].route != None) {
+        throw std::invalid_argument("Duplicate route pattern: " + std::string(pattern));
+    }
+    _nodes[node].route = route;
+}
+
+bool Router::match(std::string_view uri, RouteMatch& match) const {
+    std::size_t questionMark = uri.find('?');
+    std::string_view path = uri.substr(0, questionMark);
+    match.query = questionMark == std::string_view::npos ? std::string_view() : uri.substr(questionMark + 1);
+    match.parameterCount = 0;
+    if (path.empty() || path.front() != '/') {
+        return false;
+    }
+    return matchFrom(0, path == "/" ? std::string_view() : path, match);
+}
+
+bool Router::matchFrom(std::size_t node, std::string_view path, RouteMatch& match) const {
+    const Node& current = _nodes[node];
+    if (path.empty()) {
+        match.route = current.route;
+        return current.route != None;
+    }
+
+    std::string_view rest = path;
+    std::string_view segment = nextSegment(rest);
+    auto found = std::lower_bound(current.literals.begin(), current.literals.end(), segment, segmentLess);
+    if (found != current.literals.end() && found->first == segment && matchFrom(found->second, rest, match)) {
+        return true;
+    }
+
+    // Otherwise the segment may be a parameter's value; a failed attempt leaves nothing captured
+    if (current.parameter == None || segment.empty()) {
+        return false;
+    }
+    std::size_t captured = match.parameterCount;
+    match.names[captured] = current.parameterName;
+    match.values[captured] = segment;
+    match.parameterCount = captured + 1;
+    if (matchFrom(current.parameter, rest, match)) {
+        return true;
+    }
+    match.parameterCount = captured;
+    return false;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// RouteMatch: What the router found for a request URI: the route, the values of the pattern's
+// {name} segments and the query string. Values are views into the URI and are not percent-decoded,
+// so the URI must outlive the match.
+struct RouteMatch {
+    static constexpr std::size_t MaxParameters = 4;  // Most {name} segments in one pattern
+
+    std::size_t route = 0;                          // Route number given to Router::add
+    std::size_t parameterCount = 0;                 // Number of captured segments
+    std::string_view names[MaxParameters];          // Parameter names, in pattern order
+    std::string_view values[MaxParameters];         // Captured segments, in pattern order
+    std::string_view query;                         // Text after '?', empty if there is none
+
+    // Value of a {name} segment; empty if the route has no such parameter
+    std::string_view parameter(std::string_view name) const;
+
+    // Value of a query string parameter, empty for a bare "name"; false if it is not given
+    bool queryParameter(std::string_view name, std::string_view& value) const;
+};
+
+// Router: A trie of path segments built once at startup and only read afterwards, so any number of
+// threads can match at once. Matching walks one node per segment without allocating, whatever the
+// number of routes. Literal segments win over {name} segments, so "/ebikes/nearest" is preferred
+// to "/ebikes/{id}"; a {name} segment only captures non-empty text.
+class Router {
+public:
+    // Add a pattern such as "/ebikes/{id}/history" for a route number. Throws std::invalid_argument
+    // if the pattern does not start with '/', has more than MaxParameters parameters, names a
+    // parameter differently from an overlapping pattern or repeats a pattern.
+    void add(std::string_view pattern, std::size_t route);
+
+    // Match a request URI, whose query string is ignored for routing; false if no pattern matches
+    bool match(std::string_view uri, RouteMatch& match) const;
+
+private:
+    static constexpr std::size_t None = static_cast<std::size_t>(-1);
+
+    struct Node {
+        std::vector<std::pair<std::string, std::size_t>> literals;  // Children by segment text, sorted
+        std::size_t parameter = None;                               // Child for a {name} segment
+        std::string parameterName;                                  // Name of that segment
+        std::size_t route = None;                                   // Route ending here
+    };
+
+    // Match the remaining path, which is empty or starts with '/', from a node
+    bool matchFrom(std::size_t node, std::string_view path, RouteMatch& match) const;
+
+    std::vector<Node> _nodes{1};  // _nodes[0] is the root, for "/"
+};
+
+#endif // ROUTER_H
@@ -0,0 +1,112 @@
+// src/web/StaticAssets.cpp
+#include "StaticAssets.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "Compression.h"
+
+namespace {
+
+// Strong ETag from the FNV-1a hash of the contents
+std::string hashTag(const std::string& contents) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : contents) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    char tag[24];
+    std::snprintf(tag, sizeof(tag), "\"%016llx", static_cast<unsigned long long>(hash));
+    return tag;
+}
+
+// Whether a content type is worth compressing
+bool isText(std::string_view contentType) {
+    return contentType.compare(0, 5, "text/") == 0 || contentType == "application/javascript"
+        || contentType == "application/json" || contentType == "image/svg+xml";
+}
+
+}
+
+std::size_t StaticAssets::load(const std::string& directory) {
+    _assets.clear();
+    _indexPath.clear();
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (!entry.is_regular_file(error)) {
+            continue;
+        }
+        std::ifstream file(entry.path(), std::ios::binary);
+        if (!file.is_open()) {
+            continue;
+        }
+        std::stringstream contents;
+        contents << file.rdbuf();
+
+        std::string name = entry.path().filename().string();
+        StaticAsset asset;
+        asset.contentType = contentTypeOf(name);
+        asset.body = contents.str();
+        std::string tag = hashTag(asset.body);
+        asset.etag = tag + '"';
+        if (isText(asset.contentType) && compress(asset.body, ContentEncoding::Gzip, asset.gzip)
+            && asset.gzip.size() < asset.body.size()) {
+            asset.gzipEtag = tag + "-gzip\"";
+        } else {
+            asset.gzip.clear();
+        }
+        _assets.emplace_back("/" + name, std::move(asset));
+    }
+    std::sort(_assets.begin(), _assets.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    if (find("/index.html")) {
+        _indexPath = "/index.html";
+    } else if (find("/map.html")) {
+        _indexPath = "/map.html";
+    }
+    return _assets.size();
+}
+
+const StaticAsset* StaticAssets::find(std::string_view uri) const {
+    std::string_view path = uri.substr(0, uri.find('?'));
+    if ((path == "/" || path == "/index.html") && !_indexPath.empty()) {
+        path = _indexPath;
+    }
+    auto it = std::lower_bound(_assets.begin(), _assets.end(), path,
+                               [](const auto& asset, std::string_view key) { return asset.first < key; });
+    return it != _assets.end() && it->first == path ? &it->second : nullptr;
+}
+
+std::string StaticAssets::defaultDirectory() {
+    std::error_code error;
+    std::filesystem::path executable = std::filesystem::read_symlink("/proc/self/exe", error);
+    if (error || !executable.has_parent_path()) {
+        return "src/html";
+    }
+    return (executable.parent_path() / "src" / "html").string();
+}
+
+const char* StaticAssets::contentTypeOf(std::string_view fileName) {
+    static const std::pair<std::string_view, const char*> types[] = {
+        {".html", "text/html; charset=utf-8"},
+        {".htm", "text/html; charset=utf-8"},
+        {".css", "text/css; charset=utf-8"},
+        {".js", "application/javascript"},
+        {".json", "application/json"},
+        {".svg", "image/svg+xml"},
+        {".png", "image/png"},
+        {".ico", "image/x-icon"},
+        {".txt", "text/plain; charset=utf-8"},
+    };
+    std::size_t dot = fileName.rfind('.');
+    std::string_view extension = dot == std::string_view::npos ? std::string_view() : fileName.substr(dot);
+    for (const auto& type : types) {
+        if (extension == type.first) {
+            return type.second;
+        }
+    }
+    return "application/octet-stream";
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#ifndef STATICASSETS_H
+#define STATICASSETS_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// StaticAsset: A file served from memory, with everything about the response worked out at load
+struct StaticAsset {
+    std::string contentType;  // Content-Type header value
+    std::string body;         // File contents
+    std::string etag;         // Strong ETag from a hash of the contents
+    std::string gzip;         // gzip-compressed contents; empty unless that is smaller
+    std::string gzipEtag;     // ETag of the compressed form
+};
+
+// StaticAssets: The files of the web front end, read once at startup. Requests are answered from
+// memory without touching the disk, so unknown paths cost a binary search. "/" and "/index.html"
+// serve index.html, or map.html if there is no index.html.
+class StaticAssets {
+public:
+    // Load every regular file directly inside a directory, replacing what was loaded before.
+    // Returns the number of files loaded; 0 if the directory cannot be read.
+    std::size_t load(const std::string& directory);
+
+    // Find the asset for a request path, ignoring any query string; null if there is none
+    const StaticAsset* find(std::string_view uri) const;
+
+    // Number of loaded files
+    std::size_t size() const { return _assets.size(); }
+
+    // Content type for a file name, from its extension
+    static const char* contentTypeOf(std::string_view fileName);
+
+    // src/html beside the running executable, so the front end is found whatever the working
+    // directory; src/html relative to the working directory if the executable cannot be located
+    static std::string defaultDirectory();
+
+private:
+    std::vector<std::pair<std::string, StaticAsset>> _assets;  // Sorted by request path, such as "/map.html"
+    std::string _indexPath;                                    // Asset served for "/"
+};
+
+#endif // STATICASSETS_H
@@ -0,0 +1,296 @@
+// src/web/StreamPusher.cpp
+#include "StreamPusher.h"
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <string>
+#include "util/Metrics.h"
+
+namespace {
+
+// Longest wait for a frame, so closed connections and stops are noticed while nothing changes
+constexpr std::chrono::seconds WaitLimit(1);
+
+// Write all of a buffer; false if the connection failed, or if the client takes it so slowly
+// that it is still not written by the deadline
+bool sendAll(Poco::Net::StreamSocket& socket, const char* data, std::size_t size,
+             std::chrono::steady_clock::time_point deadline) {
+    while (size > 0) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        int sent = socket.sendBytes(data, static_cast<int>(size));
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+bool sendAll(Poco::Net::StreamSocket& socket, const std::string& text, std::chrono::steady_clock::time_point deadline) {
+    return sendAll(socket, text.data(), text.size(), deadline);
+}
+
+// Whether an event stream client closed its end; such clients send nothing else
+bool eventStreamClosed(Poco::Net::StreamSocket& socket) {
+    char buffer[256];
+    while (socket.poll(Poco::Timespan(0), Poco::Net::Socket::SELECT_READ)) {
+        if (socket.receiveBytes(buffer, sizeof(buffer)) <= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whether a dashboard closed its WebSocket; dashboards only send pongs and the close handshake
+bool webSocketClosed(Poco::Net::WebSocket& socket) {
+    char buffer[256];
+    while (socket.poll(Poco::Timespan(0), Poco::Net::Socket::SELECT_READ)) {
+        int flags = 0;
+        int size = socket.receiveFrame(buffer, sizeof(buffer), flags);
+        // An empty pong also reads as 0 bytes, but comes with its flags set
+        if ((size <= 0 && flags == 0)
+            || (flags & Poco::Net::WebSocket::FRAME_OP_BITMASK) == Poco::Net::WebSocket::FRAME_OP_CLOSE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whether a subscriber's socket takes data now, noting when it stopped doing so
+template <typename Subscriber>
+bool writable(Subscriber& subscriber, std::chrono::steady_clock::time_point now) {
+    if (subscriber.socket.poll(Poco::Timespan(0), Poco::Net::Socket::SELECT_WRITE)) {
+        subscriber.blockedSince = {};
+        return true;
+    }
+    if (subscriber.blockedSince == std::chrono::steady_clock::time_point()) {
+        subscriber.blockedSince = now;
+    }
+    return false;
+}
+
+// Version to wait for frames after: the oldest a subscriber able to take data is at. When none
+// is, the newest frame already pushed, so blocked subscribers do not keep the wait from blocking.
+template <typename Subscriber>
+uint64_t waitVersion(const std::vector<Subscriber>& subscribers, uint64_t head) {
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (const Subscriber& subscriber : subscribers) {
+        head = std::max(head, subscriber.version);
+        if (subscriber.blockedSince == std::chrono::steady_clock::time_point()) {
+            oldest = std::min(oldest, subscriber.version);
+        }
+    }
+    return oldest == std::numeric_limits<uint64_t>::max() ? head : oldest;
+}
+
+}
+
+StreamPusher::StreamPusher(FeatureCollectionCache& cache, FleetStream& stream, FleetFrameStream& frames,
+                           std::size_t maxSubscribers)
+    : _cache(cache), _stream(stream), _frames(frames), _maxSubscribers(maxSubscribers) {
+    _eventThread = std::thread(&StreamPusher::pushEvents, this);
+    _frameThread = std::thread(&StreamPusher::pushFrames, this);
+}
+
+StreamPusher::~StreamPusher() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _changed.notify_all();
+    _eventThread.join();
+    _frameThread.join();
+    for (EventSubscriber& subscriber : _addedEventStreams) {
+        drop(subscriber);
+    }
+    for (SocketSubscriber& subscriber : _addedWebSockets) {
+        drop(subscriber);
+    }
+}
+
+bool StreamPusher::reserve() {
+    std::size_t count = _subscribers.load(std::memory_order_relaxed);
+    do {
+        if (count >= _maxSubscribers) {
+            return false;
+        }
+    } while (!_subscribers.compare_exchange_weak(count, count + 1, std::memory_order_relaxed));
+    return true;
+}
+
+void StreamPusher::release() {
+    _subscribers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void StreamPusher::addEventStream(const Poco::Net::StreamSocket& socket, uint64_t version) {
+    EventSubscriber subscriber{socket, version, Clock::now()};
+    subscriber.socket.setSendTimeout(Poco::Timespan(SendTimeoutSeconds, 0));
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _addedEventStreams.push_back(std::move(subscriber));
+    }
+    Metrics::adjust(Gauge::StreamSubscribers, 1);
+    _changed.notify_all();
+}
+
+void StreamPusher::addWebSocket(const Poco::Net::WebSocket& socket, uint64_t version) {
+    SocketSubscriber subscriber{socket, version, Clock::now()};
+    subscriber.socket.setSendTimeout(Poco::Timespan(SendTimeoutSeconds, 0));
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _addedWebSockets.push_back(std::move(subscriber));
+    }
+    Metrics::adjust(Gauge::StreamSubscribers, 1);
+    _changed.notify_all();
+}
+
+template <typename Socket>
+bool StreamPusher::adopt(std::vector<Subscriber<Socket>>& added, std::vector<Subscriber<Socket>>& subscribers) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _changed.wait(lock, [&] { return _stopping || !added.empty() || !subscribers.empty(); });
+    std::move(added.begin(), added.end(), std::back_inserter(subscribers));
+    added.clear();
+    return !_stopping;
+}
+
+template <typename Socket>
+void StreamPusher::drop(Subscriber<Socket>& subscriber) {
+    try {
+        subscriber.socket.close();
+    } catch (const std::exception&) {
+        // Already gone
+    }
+    Metrics::adjust(Gauge::StreamSubscribers, -1);
+    release();
+}
+
+void StreamPusher::pushEvents() {
+    std::vector<EventSubscriber> subscribers;
+    uint64_t head = 0;
+    while (adopt(_addedEventStreams, subscribers)) {
+        std::shared_ptr<const StreamFrame> frame =
+            _stream.next(waitVersion(subscribers, head), Clock::now() + WaitLimit);
+        if (frame) {
+            head = std::max(head, frame->version);
+        }
+
+        // Subscribers that fell behind resynchronise from the collection shared with /ebikes,
+        // fetched once for all of them
+        std::shared_ptr<const CachedFeatureCollection> cached;
+        auto now = Clock::now();
+        auto push = [&](EventSubscriber& subscriber) {
+            if (eventStreamClosed(subscriber.socket)) {
+                return false;
+            }
+            bool due = frame && frame->version > subscriber.version;
+            if (!due && now - subscriber.sentAt < std::chrono::seconds(KeepAliveSeconds)) {
+                return true;
+            }
+            if (!writable(subscriber, now)) {
+                return now - subscriber.blockedSince < std::chrono::seconds(SendTimeoutSeconds);
+            }
+            bool sent;
+            auto deadline = Clock::now() + std::chrono::seconds(SendTimeoutSeconds);
+            if (!due) {
+                // Lets the client and any proxy know the stream is alive
+                sent = sendAll(subscriber.socket, ": keep-alive\n\n", deadline);
+            } else if (frame->since <= subscriber.version) {
+                sent = sendAll(subscriber.socket, frame->event, deadline);
+                subscriber.version = frame->version;
+            } else {
+                if (!cached) {
+                    cached = _cache.get();
+                }
+                sent = sendAll(subscriber.socket, "event: snapshot\ndata: ", deadline)
+                    && sendAll(subscriber.socket, cached->body, deadline) && sendAll(subscriber.socket, "\n\n", deadline);
+                subscriber.version = cached->version;
+            }
+            subscriber.sentAt = now;
+            return sent;
+        };
+
+        for (auto it = subscribers.begin(); it != subscribers.end();) {
+            bool open = false;
+            try {
+                open = push(*it);
+            } catch (const std::exception&) {
+                // The client went away, or a send timed out
+            }
+            if (open) {
+                ++it;
+            } else {
+                drop(*it);
+                it = subscribers.erase(it);
+            }
+        }
+    }
+    for (EventSubscriber& subscriber : subscribers) {
+        drop(subscriber);
+    }
+}
+
+void StreamPusher::pushFrames() {
+    std::vector<SocketSubscriber> subscribers;
+    uint64_t head = 0;
+    while (adopt(_addedWebSockets, subscribers)) {
+        std::shared_ptr<const EncodedFleetFrame> frame =
+            _frames.next(waitVersion(subscribers, head), Clock::now() + WaitLimit);
+        if (frame) {
+            head = std::max(head, frame->version);
+        }
+
+        // Subscribers that missed a delta rejoin from a keyframe, fetched once for all of them
+        std::shared_ptr<const EncodedFleetFrame> rejoin;
+        auto now = Clock::now();
+        auto push = [&](SocketSubscriber& subscriber) {
+            if (webSocketClosed(subscriber.socket)) {
+                return false;
+            }
+            bool due = frame && frame->version > subscriber.version;
+            if (!due && now - subscriber.sentAt < std::chrono::seconds(KeepAliveSeconds)) {
+                return true;
+            }
+            if (!writable(subscriber, now)) {
+                return now - subscriber.blockedSince < std::chrono::seconds(SendTimeoutSeconds);
+            }
+            if (!due) {
+                subscriber.socket.sendFrame(nullptr, 0, Poco::Net::WebSocket::FRAME_FLAG_FIN | Poco::Net::WebSocket::FRAME_OP_PING);
+            } else {
+                const EncodedFleetFrame* out = frame.get();
+                if (!frame->keyframe && frame->since != subscriber.version) {
+                    if (!rejoin) {
+                        rejoin = _frames.keyframe();
+                    }
+                    out = rejoin.get();
+                }
+                subscriber.socket.sendFrame(out->bytes.data(), static_cast<int>(out->bytes.size()),
+                                            Poco::Net::WebSocket::FRAME_BINARY);
+                subscriber.version = out->version;
+            }
+            subscriber.sentAt = now;
+            return true;
+        };
+
+        for (auto it = subscribers.begin(); it != subscribers.end();) {
+            bool open = false;
+            try {
+                open = push(*it);
+            } catch (const std::exception&) {
+                // The dashboard went away, or a send timed out
+            }
+            if (open) {
+                ++it;
+            } else {
+                drop(*it);
+                it = subscribers.erase(it);
+            }
+        }
+    }
+    for (SocketSubscriber& subscriber : subscribers) {
+        drop(subscriber);
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#ifndef STREAMPUSHER_H
+#define STREAMPUSHER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <Poco/Net/StreamSocket.h>
+#include <Poco/Net/WebSocket.h>
+#include "FeatureCollectionCache.h"
+#include "FleetStream.h"
+#include "FleetFrameStream.h"
+
+// StreamPusher: Writes the shared frames of /ebikes/stream and /ebikes/ws to every subscriber
+// from two threads of its own, one per stream, so a subscriber holds a socket rather than a
+// server thread. The handlers answer the request, send the opening snapshot or keyframe and hand
+// the connection over. A subscriber whose socket takes no more data is skipped and catches up
+// with a fresh snapshot or keyframe once it drains; it is dropped when that lasts longer than
+// SendTimeoutSeconds, or when a send takes longer.
+class StreamPusher {
+public:
+    static constexpr int KeepAliveSeconds = 15;                 // Keep-alive comment or ping sent when nothing changed for this long
+    static constexpr int SendTimeoutSeconds = 2;                // Longest one subscriber may hold back the others
+    static constexpr std::size_t DefaultMaxSubscribers = 256;   // Subscribers of both streams together, when not configured
+
+    StreamPusher(FeatureCollectionCache& cache, FleetStream& stream, FleetFrameStream& frames,
+                 std::size_t maxSubscribers = DefaultMaxSubscribers);
+
+    // Stops both threads and closes every subscriber
+    ~StreamPusher();
+
+    StreamPusher(const StreamPusher&) = delete;
+    StreamPusher& operator=(const StreamPusher&) = delete;
+
+    // Claim room for a subscriber; false once maxSubscribers are connected. The claim is passed on
+    // with the connection to addEventStream or addWebSocket, or given back with release().
+    bool reserve();
+    void release();
+
+    // Take over an event stream that was sent its headers and a snapshot at a version
+    void addEventStream(const Poco::Net::StreamSocket& socket, uint64_t version);
+
+    // Take over a WebSocket that was sent a keyframe at a version
+    void addWebSocket(const Poco::Net::WebSocket& socket, uint64_t version);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Subscriber: A connection handed over, with where it is in the stream
+    template <typename Socket>
+    struct Subscriber {
+        Socket socket;
+        uint64_t version;                  // Version the subscriber was last brought to
+        Clock::time_point sentAt;          // Last write
+        Clock::time_point blockedSince{};  // Since when its socket takes no data; the epoch while it does
+    };
+    using EventSubscriber = Subscriber<Poco::Net::StreamSocket>;
+    using SocketSubscriber = Subscriber<Poco::Net::WebSocket>;
+
+    // Thread bodies, one per stream
+    void pushEvents();
+    void pushFrames();
+
+    // Wait for subscribers and move the newly added ones over; false once stopping
+    template <typename Socket>
+    bool adopt(std::vector<Subscriber<Socket>>& added, std::vector<Subscriber<Socket>>& subscribers);
+
+    // Close a subscriber and give back its claim
+    template <typename Socket>
+    void drop(Subscriber<Socket>& subscriber);
+
+    FeatureCollectionCache& _cache;
+    FleetStream& _stream;
+    FleetFrameStream& _frames;
+    std::size_t _maxSubscribers;
+    std::atomic<std::size_t> _subscribers{0};           // Claims held, connected or about to be
+
+    std::mutex _mutex;
+    std::condition_variable _changed;                   // Signalled when subscribers are added or on stop
+    std::vector<EventSubscriber> _addedEventStreams;    // Handed over, not yet adopted (guarded by _mutex)
+    std::vector<SocketSubscriber> _addedWebSockets;     // Handed over, not yet adopted (guarded by _mutex)
+    bool _stopping = false;                             // Guarded by _mutex
+
+    std::thread _eventThread;
+    std::thread _frameThread;
+};
+
+#endif // STREAMPUSHER_H
@@ -3,26 +3,40 @@
 #include <Poco/Net/HTTPServer.h>
 #include <Poco/Net/ServerSocket.h>
 #include <Poco/Net/HTTPServerParams.h>
+#include <Poco/ThreadPool.h>
 #include "EbikeHandler.h"
+#include <algorithm>
 #include <memory>
 #include <iostream>
 
-WebServer::WebServer(Poco::JSON::Array::Ptr& ebikes) : _ebikes(ebikes) {
+WebServer::WebServer(FleetPublisher& fleet, const WebServerConfig& config) : _fleet(fleet), _config(config) {
 }
 
 void WebServer::start(int port) {
     // Create HTTP server parameters
     Poco::Net::HTTPServerParams::Ptr params = new Poco::Net::HTTPServerParams;
-    params->setMaxQueued(100);
-    params->setMaxThreads(16);
+    params->setMaxQueued(_config.maxQueued);
+    params->setMaxThreads(_config.maxThreads);
+    params->setKeepAlive(_config.keepAliveTimeoutSeconds > 0);
+    if (_config.keepAliveTimeoutSeconds > 0) {
+        params->setKeepAliveTimeout(Poco::Timespan(_config.keepAliveTimeoutSeconds, 0));
+        params->setMaxKeepAliveRequests(_config.maxKeepAliveRequests);
+    }
+    params->setTimeout(Poco::Timespan(_config.timeoutSeconds, 0));
     
-    // Create the socket and bind it to the specified port
-    Poco::Net::ServerSocket socket(port);
+    // Create the socket and bind it to the specified port, with a listen backlog as deep as the queue
+    Poco::Net::ServerSocket socket(static_cast<Poco::UInt16>(port), _config.maxQueued);
     
+    // Poco's default thread pool stops at 16 threads whatever maxThreads says, so the
+    // server gets a pool of its own, as large as maxThreads
+    _threads = std::make_unique<Poco::ThreadPool>(std::min(2, _config.maxThreads), _config.maxThreads);
+
     // Create the HTTP server with our request handler factory
     _server = std::make_unique<Poco::Net::HTTPServer>(
-        new RequestHandlerFactory(_ebikes), socket, params);
+        new RequestHandlerFactory(_fleet, _config.streamRate, _config.assetDirectory,
+                                  static_cast<std::size_t>(_config.maxStreamSubscribers)),
+        *_threads, socket, params);
     
     // Start the server
     _server->start();
-}
\ No newline at end of file
+}
@@ -4,18 +4,35 @@
 #define WEBSERVER_H
 
 #include <memory>
+#include <string>
 #include <Poco/Net/HTTPServer.h>
-#include <Poco/JSON/Array.h>
+#include <Poco/ThreadPool.h>
+#include "fleet/FleetPublisher.h"
 #include "EbikeHandler.h"
 
+// WebServerConfig: What the web server serves and how its connections are handled. Stream
+// subscribers only hold a server thread until their first frame is sent.
+struct WebServerConfig {
+    int streamRate = FleetStream::DefaultRate;                       // Frames per second pushed to stream subscribers
+    std::string assetDirectory = StaticAssets::defaultDirectory();   // Static files, read when the server starts
+    int maxStreamSubscribers = StreamPusher::DefaultMaxSubscribers;  // /ebikes/stream and /ebikes/ws connections; more get 503
+    int maxThreads = 16;                                             // Connections served at once
+    int maxQueued = 100;                                             // Accepted connections waiting for a thread
+    int keepAliveTimeoutSeconds = 15;                                // Idle time before a kept-alive connection closes; 0 disables keep-alive
+    int maxKeepAliveRequests = 0;                                    // Requests per connection before it closes; 0 for no limit
+    int timeoutSeconds = 60;                                         // Time allowed for a request to arrive or a response to be taken
+};
+
 class WebServer {
 public:
-    WebServer(Poco::JSON::Array::Ptr& ebikes);
+    explicit WebServer(FleetPublisher& fleet, const WebServerConfig& config = WebServerConfig());
     void start(int port);
 
 private:
-    Poco::JSON::Array::Ptr& _ebikes;
+    FleetPublisher& _fleet;
+    WebServerConfig _config;
+    std::unique_ptr<Poco::ThreadPool> _threads;  // Serves the connections; outlives _server
     std::unique_ptr<Poco::Net::HTTPServer> _server;
 };
 
-#endif // WEBSERVER_H
\ No newline at end of file
+#endif // WEBSERVER_H
@@ -0,0 +1,127 @@
+/**
+ * @file test_AsyncLog.cpp
+ * @brief Unit tests for the asynchronous logger
+ * @date October 2026
+ */
+ #define CATCH_CONFIG_MAIN
+
+ #include <catch2/catch.hpp>
+ #include <cstdio>
+ #include <fstream>
+ #include <sstream>
+ #include <string>
+ #include <thread>
+ #include <unistd.h>
+ #include "util/AsyncLog.h"
+
+ /// Sends stdout to a temporary file for the lifetime of the object
+ struct CapturedStdout {
+     CapturedStdout() : path("/tmp/test_AsyncLog." + std::to_string(::getpid())) {
+         std::fflush(stdout);
+         saved = ::dup(STDOUT_FILENO);
+         std::FILE* file = std::fopen(path.c_str(), "w");
+         ::dup2(::fileno(file), STDOUT_FILENO);
+         std::fclose(file);
+     }
+
+     ~CapturedStdout() {
+         std::fflush(stdout);
+         ::dup2(saved, STDOUT_FILENO);
+         ::close(saved);
+         std::remove(path.c_str());
+     }
+
+     std::string text() {
+         AsyncLog::instance().flush();
+         std::ifstream file(path);
+         std::stringstream content;
+         content << file.rdbuf();
+         return content.str();
+     }
+
+     std::string path;
+     int saved;
+ };
+
+ static std::size_t countOf(const std::string& text, const std::string& needle) {
+     std::size_t count = 0;
+     for (std::size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) {
+         ++count;
+     }
+     return count;
+ }
+
+ TEST_CASE("AsyncLog parses level names", "[AsyncLog]") {
+     LogLevel level = LogLevel::Info;
+     REQUIRE(AsyncLog::parseLevel("debug", level));
+     REQUIRE(level == LogLevel::Debug);
+     REQUIRE(AsyncLog::parseLevel("error", level));
+     REQUIRE(level == LogLevel::Error);
+     REQUIRE_FALSE(AsyncLog::parseLevel("verbose", level));
+ }
+
+ TEST_CASE("LogSite allows a fixed number of lines per second", "[AsyncLog]") {
+     LogSite site(3);
+     int allowed = 0;
+     for (int i = 0; i < 10; ++i) {
+         allowed += site.allow() ? 1 : 0;
+     }
+     // The ten calls may straddle a second boundary
+     REQUIRE(allowed >= 3);
+     REQUIRE(allowed <= 6);
+     REQUIRE(site.takeSuppressed() == static_cast<uint64_t>(10 - allowed));
+     REQUIRE(site.takeSuppressed() == 0);
+
+     LogSite unlimited(0);
+     for (int i = 0; i < 100; ++i) {
+         REQUIRE(unlimited.allow());
+     }
+ }
+
+ TEST_CASE("AsyncLog writes lines from several threads", "[AsyncLog]") {
+     CapturedStdout captured;
+
+     std::thread other([] {
+         EBIKE_LOG(LogLevel::Info) << "from another thread " << 42;
+     });
+     other.join();
+     EBIKE_LOG(LogLevel::Info) << "eBike " << 7 << " at " << 51.5 << ", " << -2.25 << ' ' << true;
+     EBIKE_LOG(LogLevel::Debug) << "below the minimum level";
+
+     std::string text = captured.text();
+     REQUIRE(countOf(text, "info  from another thread 42\n") == 1);
+     REQUIRE(countOf(text, "info  eBike 7 at 51.500000, -2.250000 true\n") == 1);
+     REQUIRE(countOf(text, "below the minimum level") == 0);
+ }
+
+ TEST_CASE("AsyncLog rate-limits a call site and reports what it skipped", "[AsyncLog]") {
+     CapturedStdout captured;
+     auto logLimited = [] {
+         EBIKE_LOG_LIMITED(LogLevel::Info, 5) << "limited line";
+     };
+
+     for (int i = 0; i < 50; ++i) {
+         logLimited();
+     }
+     std::string text = captured.text();
+     std::size_t written = countOf(text, "limited line");
+     REQUIRE(written >= 5);
+     REQUIRE(written <= 10);
+
+     // In the next second the site lets a line through and reports the skipped ones
+     std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+     logLimited();
+     text = captured.text();
+     REQUIRE(countOf(text, "limited line") == written + 1);
+     REQUIRE(countOf(text, "similar line(s) suppressed) limited line\n") == 1);
+ }
+
+ TEST_CASE("AsyncLog cuts off lines longer than a record", "[AsyncLog]") {
+     CapturedStdout captured;
+
+     std::string longText(LogRecord::Capacity + 100, 'x');
+     EBIKE_LOG(LogLevel::Info) << longText;
+
+     std::string text = captured.text();
+     REQUIRE(countOf(text, std::string(LogRecord::Capacity, 'x') + "\n") == 1);
+ }
@@ -0,0 +1,274 @@
+/**
+ * @file test_FleetFrame.cpp
+ * @brief Unit tests for the binary dashboard frames and the stream that shares them
+ * @date October 2026
+ */
+ #define CATCH_CONFIG_MAIN
+
+ #include <catch2/catch.hpp>
+ #include <chrono>
+ #include <cstdlib>
+ #include <memory>
+ #include <vector>
+ #include "fleet/FleetStore.h"
+ #include "fleet/FleetPublisher.h"
+ #include "proto/FleetFrame.h"
+ #include "web/FleetFrameStream.h"
+
+ static TelemetryReading makeReading(int id, int32_t lat, int32_t lon, int64_t ts) {
+     TelemetryReading reading;
+     reading.ebikeId = id;
+     reading.latitudeE6 = lat;
+     reading.longitudeE6 = lon;
+     reading.timestampMs = ts;
+     return reading;
+ }
+
+ static uint32_t countAt(const std::vector<uint8_t>& frame, std::size_t offset) {
+     return frame[offset] | (frame[offset + 1] << 8) | (frame[offset + 2] << 16) | (static_cast<uint32_t>(frame[offset + 3]) << 24);
+ }
+
+ TEST_CASE("FleetFrame keyframes carry every e-bike exactly", "[FleetFrame]") {
+     FleetStore store;
+     store.update(makeReading(7, 51459079, -2544360, 1000));
+     store.update(makeReading(9, -33868820, 151209296, 1000));
+     store.setStatus(9, EBikeStatus::Maintenance);
+
+     FleetFrameEncoder encoder;
+     std::vector<uint8_t> frame;
+     encoder.encodeKeyframe(*store.snapshot(), frame);
+     REQUIRE(frame.size() == FleetFrame::HeaderSize + 2 * FleetFrame::AbsoluteEntrySize);
+     REQUIRE(frame[3] == FleetFrame::TypeKeyframe);
+     REQUIRE(encoder.version() == store.version());
+
+     FleetFrame::View view;
+     REQUIRE(FleetFrame::apply(frame.data(), frame.size(), view));
+     REQUIRE(view.version == store.version());
+     REQUIRE(view.ids == std::vector<int32_t>{7, 9});
+     REQUIRE(view.latitudes == std::vector<int32_t>{51459079, -33868820});
+     REQUIRE(view.longitudes == std::vector<int32_t>{-2544360, 151209296});
+     REQUIRE(view.statuses == std::vector<uint8_t>{0, 2});
+
+     // Truncated frames are rejected without touching the view
+     REQUIRE_FALSE(FleetFrame::apply(frame.data(), frame.size() - 1, view));
+     REQUIRE(view.ids.size() == 2);
+ }
+
+ static void putAt(std::vector<uint8_t>& frame, std::size_t offset, uint32_t value) {
+     for (int i = 0; i < 4; ++i) {
+         frame[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+     }
+ }
+
+ TEST_CASE("FleetFrame rejects bad slots without touching the view", "[FleetFrame]") {
+     FleetStore store;
+     for (int id = 0; id < 3; ++id) {
+         store.update(makeReading(id, 51000000 + id * 1000, -2500000, 1000));
+     }
+     FleetFrameEncoder encoder;
+     std::vector<uint8_t> keyframe;
+     encoder.encodeKeyframe(*store.snapshot(), keyframe);
+     FleetFrame::View view;
+     REQUIRE(FleetFrame::apply(keyframe.data(), keyframe.size(), view));
+     FleetFrame::View before = view;
+
+     // A keyframe slot past its own entries would need a huge view
+     std::vector<uint8_t> huge = keyframe;
+     putAt(huge, FleetFrame::HeaderSize + FleetFrame::AbsoluteEntrySize, 0xFFFFFFFF);
+     REQUIRE_FALSE(FleetFrame::apply(huge.data(), huge.size(), view));
+     REQUIRE(view.version == before.version);
+     REQUIRE(view.ids == before.ids);
+
+     // A delta whose last entry is out of range applies none of its entries
+     store.update(makeReading(0, 51000500, -2500000, 2000));
+     store.update(makeReading(2, 51002500, -2500000, 2000));
+     store.update(makeReading(3, 52000000, -1000000, 2000));
+     std::vector<uint8_t> delta;
+     REQUIRE(encoder.encodeDelta(*store.snapshot(), delta));
+     REQUIRE(countAt(delta, 24) == 1);
+     REQUIRE(countAt(delta, 28) == 2);
+     std::vector<uint8_t> bad = delta;
+     putAt(bad, FleetFrame::HeaderSize + FleetFrame::AbsoluteEntrySize + FleetFrame::DeltaEntrySize, 4);
+     REQUIRE_FALSE(FleetFrame::apply(bad.data(), bad.size(), view));
+     bad = delta;
+     putAt(bad, FleetFrame::HeaderSize, 5);
+     REQUIRE_FALSE(FleetFrame::apply(bad.data(), bad.size(), view));
+     REQUIRE(view.version == before.version);
+     REQUIRE(view.ids == before.ids);
+     REQUIRE(view.latitudes == before.latitudes);
+     REQUIRE(view.statuses == before.statuses);
+
+     // The intact delta still applies afterwards
+     REQUIRE(FleetFrame::apply(delta.data(), delta.size(), view));
+     REQUIRE(view.ids.size() == 4);
+     REQUIRE(view.latitudes[3] == 52000000);
+ }
+
+ TEST_CASE("FleetFrame deltas only carry e-bikes that moved", "[FleetFrame]") {
+     FleetStore store;
+     for (int id = 0; id < 100; ++id) {
+         store.update(makeReading(id, 51000000 + id * 1000, -2500000 - id * 1000, 1000));
+     }
+     FleetFrameEncoder encoder;
+     FleetFrame::View view;
+     std::vector<uint8_t> frame;
+     encoder.encodeKeyframe(*store.snapshot(), frame);
+     REQUIRE(FleetFrame::apply(frame.data(), frame.size(), view));
+
+     // Nothing changed, or a move too small to encode, gives no frame
+     REQUIRE_FALSE(encoder.encodeDelta(*store.snapshot(), frame));
+     store.update(makeReading(5, 51005003, -2505000, 2000));
+     REQUIRE_FALSE(encoder.encodeDelta(*store.snapshot(), frame));
+
+     // Three moves, a status change and a new e-bike; the small move above goes out now too
+     store.update(makeReading(5, 51005040, -2505000, 3000));
+     store.update(makeReading(10, 51010123, -2510456, 3000));
+     store.update(makeReading(20, 51020000, -2519990, 3000));
+     store.setStatus(30, EBikeStatus::Locked);
+     store.update(makeReading(500, 52000000, -1000000, 3000));
+     REQUIRE(encoder.encodeDelta(*store.snapshot(), frame));
+     REQUIRE(frame[3] == FleetFrame::TypeDelta);
+     REQUIRE(countAt(frame, 24) == 1);
+     REQUIRE(countAt(frame, 28) == 4);
+     REQUIRE(frame.size() == FleetFrame::HeaderSize + FleetFrame::AbsoluteEntrySize + 4 * FleetFrame::DeltaEntrySize);
+
+     REQUIRE(FleetFrame::apply(frame.data(), frame.size(), view));
+     REQUIRE(view.version == store.version());
+     REQUIRE(view.ids.size() == 101);
+     REQUIRE(view.ids[100] == 500);
+     REQUIRE(view.latitudes[100] == 52000000);
+     REQUIRE(view.statuses[30] == 1);
+     for (std::size_t slot = 0; slot < 100; ++slot) {
+         REQUIRE(std::abs(view.latitudes[slot] - store.latitudes()[slot]) <= FleetFrame::DefaultQuantumE6 / 2);
+         REQUIRE(std::abs(view.longitudes[slot] - store.longitudes()[slot]) <= FleetFrame::DefaultQuantumE6 / 2);
+     }
+
+     // A delta for another base version is refused
+     REQUIRE_FALSE(FleetFrame::apply(frame.data(), frame.size(), view));
+ }
+
+ TEST_CASE("FleetFrame rounding errors do not add up", "[FleetFrame]") {
+     FleetStore store;
+     store.update(makeReading(1, 0, 0, 0));
+     FleetFrameEncoder encoder;
+     FleetFrame::View view;
+     std::vector<uint8_t> frame;
+     encoder.encodeKeyframe(*store.snapshot(), frame);
+     REQUIRE(FleetFrame::apply(frame.data(), frame.size(), view));
+
+     // 7 microdegrees a step rounds to one quantum of 10 every time
+     for (int step = 1; step <= 200; ++step) {
+         store.update(makeReading(1, step * 7, -step * 7, step));
+         if (encoder.encodeDelta(*store.snapshot(), frame)) {
+             REQUIRE(FleetFrame::apply(frame.data(), frame.size(), view));
+         }
+         REQUIRE(std::abs(view.latitudes[0] - step * 7) <= FleetFrame::DefaultQuantumE6 / 2);
+         REQUIRE(std::abs(view.longitudes[0] + step * 7) <= FleetFrame::DefaultQuantumE6 / 2);
+     }
+
+     // Jumps too far for a delta entry are sent as absolute positions
+     store.update(makeReading(1, 45000000, 7000000, 1000));
+     REQUIRE(encoder.encodeDelta(*store.snapshot(), frame));
+     REQUIRE(countAt(frame, 24) == 1);
+     REQUIRE(FleetFrame::apply(frame.data(), frame.size(), view));
+     REQUIRE(view.latitudes[0] == 45000000);
+     REQUIRE(view.longitudes[0] == 7000000);
+ }
+
+ TEST_CASE("FleetFrameStream shares one chain of frames between subscribers", "[FleetFrame]") {
+     FleetStore store;
+     FleetPublisher publisher(std::chrono::milliseconds(0));
+     FleetFrameStream stream(publisher, 20);
+     auto soon = [] { return std::chrono::steady_clock::now() + std::chrono::seconds(2); };
+
+     store.update(makeReading(1, 51000000, -2500000, 1000));
+     publisher.publish(store);
+
+     // The first subscriber starts the chain with a keyframe
+     std::shared_ptr<const EncodedFleetFrame> start = stream.keyframe();
+     REQUIRE(start->keyframe);
+     REQUIRE(stream.keyframe() == start);
+     FleetFrame::View view;
+     REQUIRE(FleetFrame::apply(start->bytes.data(), start->bytes.size(), view));
+
+     store.update(makeReading(1, 51000500, -2500000, 2000));
+     publisher.publish(store);
+     std::shared_ptr<const EncodedFleetFrame> delta = stream.next(start->version, soon());
+     REQUIRE(delta);
+     REQUIRE_FALSE(delta->keyframe);
+     REQUIRE(delta->since == start->version);
+     REQUIRE(stream.next(start->version, soon()) == delta);
+     REQUIRE(FleetFrame::apply(delta->bytes.data(), delta->bytes.size(), view));
+     REQUIRE(view.latitudes[0] == 51000500);
+
+     // A subscriber joining now gets a keyframe of the chain's state, shared with the next joiner
+     std::shared_ptr<const EncodedFleetFrame> join = stream.keyframe();
+     REQUIRE(join->keyframe);
+     REQUIRE(join->version == delta->version);
+     REQUIRE(stream.keyframe() == join);
+     FleetFrame::View joined;
+     REQUIRE(FleetFrame::apply(join->bytes.data(), join->bytes.size(), joined));
+     REQUIRE(joined.latitudes == view.latitudes);
+
+     // Without changes there is nothing to wait for
+     REQUIRE(stream.next(delta->version, std::chrono::steady_clock::now() + std::chrono::milliseconds(120)) == nullptr);
+ }
+
+ TEST_CASE("FleetFrame deltas never span slots moved by a join in an earlier shard", "[FleetFrame]") {
+     FleetStore first;
+     FleetStore second;
+     FleetPublisher publisher(std::chrono::milliseconds(0), 2);
+     first.update(makeReading(1, 51000000, -2500000, 1000));
+     second.update(makeReading(2, 52000000, -1500000, 1000));
+     publisher.publish(0, first);
+     publisher.publish(1, second);
+
+     FleetFrameEncoder encoder;
+     FleetFrame::View view;
+     std::vector<uint8_t> frame;
+     REQUIRE_FALSE(encoder.canDelta(*publisher.current()));
+     encoder.encodeKeyframe(*publisher.current(), frame);
+     REQUIRE(FleetFrame::apply(frame.data(), frame.size(), view));
+     REQUIRE(view.ids == std::vector<int32_t>{1, 2});
+
+     // Joining the last shard keeps every slot, so a delta will do
+     second.update(makeReading(3, 53000000, -500000, 2000));
+     publisher.publish(1, second);
+     REQUIRE(encoder.canDelta(*publisher.current()));
+     REQUIRE(encoder.encodeDelta(*publisher.current(), frame));
+     REQUIRE(FleetFrame::apply(frame.data(), frame.size(), view));
+     REQUIRE(view.ids == std::vector<int32_t>{1, 2, 3});
+
+     // Joining the first shard moves e-bikes 2 and 3 up a slot
+     first.update(makeReading(4, 50000000, -3500000, 3000));
+     second.update(makeReading(2, 52000500, -1500000, 3000));
+     publisher.publish(0, first);
+     publisher.publish(1, second);
+     std::shared_ptr<const FleetSnapshot> moved = publisher.current();
+     REQUIRE(moved->ids() == std::vector<int32_t>{1, 4, 2, 3});
+     REQUIRE_FALSE(encoder.canDelta(*moved));
+     encoder.encodeKeyframe(*moved, frame);
+     REQUIRE(FleetFrame::apply(frame.data(), frame.size(), view));
+     REQUIRE(view.ids == moved->ids());
+     REQUIRE(view.latitudes == moved->latitudes());
+
+     // Deltas resume on the new layout
+     second.update(makeReading(3, 53000500, -500000, 4000));
+     publisher.publish(1, second);
+     REQUIRE(encoder.canDelta(*publisher.current()));
+     REQUIRE(encoder.encodeDelta(*publisher.current(), frame));
+     REQUIRE(FleetFrame::apply(frame.data(), frame.size(), view));
+     REQUIRE(view.latitudes == publisher.current()->latitudes());
+
+     // The stream sends a keyframe on its own after such a move
+     FleetFrameStream stream(publisher, 50);
+     std::shared_ptr<const EncodedFleetFrame> start = stream.keyframe();
+     first.update(makeReading(5, 49000000, -4500000, 5000));
+     publisher.publish(0, first);
+     std::shared_ptr<const EncodedFleetFrame> next = stream.next(start->version, std::chrono::steady_clock::now() + std::chrono::seconds(2));
+     REQUIRE(next);
+     REQUIRE(next->keyframe);
+     FleetFrame::View streamed;
+     REQUIRE(FleetFrame::apply(next->bytes.data(), next->bytes.size(), streamed));
+     REQUIRE(streamed.ids == std::vector<int32_t>{1, 4, 5, 2, 3});
+ }
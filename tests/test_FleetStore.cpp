@@ -0,0 +1,619 @@
+/**
+ * @file test_FleetStore.cpp
+ * @brief Unit tests for the columnar fleet store, its snapshots and their GeoJSON output
+ * @date October 2026
+ */
+ #define CATCH_CONFIG_MAIN
+
+ #include <catch2/catch.hpp>
+ #include <algorithm>
+ #include <atomic>
+ #include <cstdint>
+ #include <string>
+ #include <optional>
+ #include <thread>
+ #include <vector>
+ #include <zlib.h>
+ #include "fleet/FleetStore.h"
+ #include "fleet/FleetPublisher.h"
+ #include "web/GeoJson.h"
+ #include "web/FeatureCollectionCache.h"
+ #include "web/FleetStream.h"
+ #include "web/Compression.h"
+
+ static TelemetryReading makeReading(int id, int32_t lat, int32_t lon, int64_t ts) {
+     TelemetryReading reading;
+     reading.ebikeId = id;
+     reading.latitudeE6 = lat;
+     reading.longitudeE6 = lon;
+     reading.timestampMs = ts;
+     return reading;
+ }
+
+ TEST_CASE("FleetStore assigns one slot per e-bike", "[FleetStore]") {
+     FleetStore store;
+
+     REQUIRE(store.update(makeReading(7, 51459079, -2544360, 1000)) == 0);
+     REQUIRE(store.update(makeReading(3, 51458902, -2586929, 2000)) == 1);
+     REQUIRE(store.size() == 2);
+
+     // A second report from a known e-bike updates its slot in place
+     REQUIRE(store.update(makeReading(7, 51460000, -2545000, 3000)) == 0);
+     REQUIRE(store.size() == 2);
+     REQUIRE(store.latitudes()[0] == 51460000);
+     REQUIRE(store.longitudes()[0] == -2545000);
+     REQUIRE(store.timestamps()[0] == 3000);
+
+     std::size_t slot = 0;
+     REQUIRE(store.find(3, slot));
+     REQUIRE(slot == 1);
+     REQUIRE_FALSE(store.find(42, slot));
+ }
+
+ TEST_CASE("FleetStore keeps status across position updates", "[FleetStore]") {
+     FleetStore store;
+
+     REQUIRE_FALSE(store.setStatus(1, EBikeStatus::Locked));
+     store.update(makeReading(1, 0, 0, 0));
+     REQUIRE(store.statuses()[0] == EBikeStatus::Unlocked);
+
+     REQUIRE(store.setStatus(1, EBikeStatus::Locked));
+     store.update(makeReading(1, 10, 10, 10));
+     REQUIRE(store.statuses()[0] == EBikeStatus::Locked);
+ }
+
+ TEST_CASE("GeoJSON is produced from the columns", "[FleetStore]") {
+     std::string out;
+     appendMicrodegrees(out, -2544360);
+     REQUIRE(out == "-2.544360");
+
+     out.clear();
+     appendMicrodegrees(out, 51000001);
+     REQUIRE(out == "51.000001");
+
+     out.clear();
+     appendMicrodegrees(out, -5);
+     REQUIRE(out == "-0.000005");
+
+     FleetStore store;
+     store.update(makeReading(1, 51459079, -2544360, 1739359594000));
+
+     out.clear();
+     appendFeatureCollection(out, *store.snapshot());
+     REQUIRE(out == "{\"type\":\"FeatureCollection\",\"version\":1,\"features\":["
+                    "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\",\"coordinates\":[-2.544360,51.459079]},"
+                    "\"properties\":{\"id\":1,\"timestamp\":\"2025-02-12T11:26:34Z\",\"status\":\"unlocked\"}}]}");
+ }
+
+ TEST_CASE("Snapshots are unaffected by later updates", "[FleetStore]") {
+     FleetStore store;
+     store.update(makeReading(1, 100, 200, 1000));
+
+     std::shared_ptr<const FleetSnapshot> snapshot = store.snapshot();
+     store.update(makeReading(1, 300, 400, 2000));
+     store.update(makeReading(2, 500, 600, 3000));
+
+     REQUIRE(snapshot->version() == 1);
+     REQUIRE(snapshot->size() == 1);
+     REQUIRE(snapshot->latitudes()[0] == 100);
+
+     std::size_t slot = 0;
+     REQUIRE_FALSE(snapshot->find(2, slot));
+     REQUIRE(store.snapshot()->find(2, slot));
+     REQUIRE(slot == 1);
+ }
+
+ TEST_CASE("FleetPublisher only publishes changed state", "[FleetStore]") {
+     FleetStore store;
+     FleetPublisher publisher(std::chrono::milliseconds(0));
+
+     REQUIRE(publisher.current()->size() == 0);
+     REQUIRE_FALSE(publisher.publishIfDue(store));
+
+     store.update(makeReading(1, 100, 200, 1000));
+     REQUIRE(publisher.publishIfDue(store));
+     REQUIRE(publisher.current()->size() == 1);
+     REQUIRE(publisher.current()->version() == store.version());
+     REQUIRE_FALSE(publisher.publishIfDue(store));
+ }
+
+ TEST_CASE("FleetPublisher combines the snapshots of every shard", "[FleetStore]") {
+     FleetStore even, odd;
+     FleetPublisher publisher(std::chrono::milliseconds(0), 2);
+     REQUIRE(publisher.shards() == 2);
+
+     even.update(makeReading(2, 20, 21, 1000));
+     odd.update(makeReading(1, 10, 11, 1000));
+     odd.update(makeReading(3, 30, 31, 1000));
+     REQUIRE(publisher.publishIfDue(1, odd));
+     REQUIRE(publisher.current()->size() == 2);
+
+     REQUIRE(publisher.publishIfDue(0, even));
+     std::shared_ptr<const FleetSnapshot> combined = publisher.current();
+     REQUIRE(combined->size() == 3);
+     REQUIRE(combined->version() == even.version() + odd.version());
+
+     for (int id = 1; id <= 3; ++id) {
+         std::size_t slot = 0;
+         REQUIRE(combined->find(id, slot));
+         REQUIRE(combined->ids()[slot] == id);
+         REQUIRE(combined->latitudes()[slot] == id * 10);
+     }
+
+     // A shard publishing again keeps the other shard's latest state
+     even.update(makeReading(2, 22, 23, 2000));
+     REQUIRE(publisher.publishIfDue(0, even));
+     std::size_t slot = 0;
+     REQUIRE(publisher.current()->find(3, slot));
+     REQUIRE(publisher.current()->latitudes()[slot] == 30);
+     REQUIRE(publisher.current()->find(2, slot));
+     REQUIRE(publisher.current()->latitudes()[slot] == 22);
+ }
+
+ TEST_CASE("FleetPublisher rebuilds the combined snapshot at most once per interval", "[FleetStore]") {
+     FleetStore even, odd;
+     FleetPublisher publisher(std::chrono::milliseconds(50), 2);
+     even.update(makeReading(2, 20, 21, 1000));
+     odd.update(makeReading(1, 10, 11, 1000));
+
+     // The first publication is combined at once; the second waits for the interval
+     REQUIRE(publisher.publishIfDue(0, even));
+     std::shared_ptr<const FleetSnapshot> first = publisher.current();
+     REQUIRE(first->size() == 1);
+     REQUIRE(publisher.publishIfDue(1, odd));
+     REQUIRE(publisher.current() == first);
+
+     // Any writer finding the rebuild due makes it, even with nothing new of its own
+     std::this_thread::sleep_for(std::chrono::milliseconds(60));
+     REQUIRE_FALSE(publisher.publishIfDue(0, even));
+     std::shared_ptr<const FleetSnapshot> second = publisher.current();
+     REQUIRE(second->size() == 2);
+     REQUIRE(second->version() == even.version() + odd.version());
+
+     // Without publications nothing is rebuilt
+     std::this_thread::sleep_for(std::chrono::milliseconds(60));
+     REQUIRE_FALSE(publisher.publishIfDue(1, odd));
+     REQUIRE(publisher.current() == second);
+ }
+
+ static std::vector<int> changedIds(const FleetSnapshot& snapshot, uint64_t since) {
+     std::vector<std::size_t> slots;
+     REQUIRE(snapshot.changedSince(since, snapshot.size(), slots));
+     std::vector<int> ids;
+     for (std::size_t slot : slots) {
+         ids.push_back(snapshot.ids()[slot]);
+     }
+     std::sort(ids.begin(), ids.end());
+     return ids;
+ }
+
+ TEST_CASE("Combined snapshots list the e-bikes changed since a version", "[FleetStore]") {
+     FleetStore even, odd;
+     FleetPublisher publisher(std::chrono::milliseconds(0), 2);
+     for (int id = 1; id <= 5; ++id) {
+         (id % 2 == 0 ? even : odd).update(makeReading(id, id, id, 1000));
+     }
+     publisher.publish(0, even);
+     publisher.publish(1, odd);
+     uint64_t first = publisher.current()->version();
+     REQUIRE(changedIds(*publisher.current(), 0) == std::vector<int>{1, 2, 3, 4, 5});
+     REQUIRE(changedIds(*publisher.current(), first).empty());
+
+     odd.update(makeReading(3, 30, 30, 2000));
+     publisher.publish(1, odd);
+     uint64_t second = publisher.current()->version();
+     REQUIRE(changedIds(*publisher.current(), first) == std::vector<int>{3});
+
+     // A change in the other shard, and a status change, are both stamped after the second version
+     even.update(makeReading(4, 40, 40, 3000));
+     publisher.publish(0, even);
+     REQUIRE(odd.setStatus(1, EBikeStatus::Locked));
+     publisher.publish(1, odd);
+     std::shared_ptr<const FleetSnapshot> snapshot = publisher.current();
+     REQUIRE(changedIds(*snapshot, first) == std::vector<int>{1, 3, 4});
+     REQUIRE(changedIds(*snapshot, second) == std::vector<int>{1, 4});
+
+     // Too many changes, or a version the snapshot has not reached, ask for a full copy
+     std::vector<std::size_t> slots;
+     REQUIRE_FALSE(snapshot->changedSince(0, 4, slots));
+     REQUIRE(slots.empty());
+     REQUIRE_FALSE(snapshot->changedSince(snapshot->version() + 1, 5, slots));
+
+     std::string out;
+     REQUIRE(snapshot->changedSince(second, 5, slots));
+     appendDelta(out, *snapshot, second, slots);
+     std::string start = "{\"type\":\"FeatureCollection\",\"version\":" + std::to_string(snapshot->version()) + ",";
+     std::string end = "],\"since\":" + std::to_string(second) + "}";
+     REQUIRE(out.compare(0, start.size(), start) == 0);
+     REQUIRE(out.compare(out.size() - end.size(), end.size(), end) == 0);
+     REQUIRE(out.find("\"id\":4") != std::string::npos);
+     REQUIRE(out.find("\"id\":3") == std::string::npos);
+ }
+
+ TEST_CASE("Versions from before a restart get the full collection", "[FleetStore]") {
+     // The earlier run applied more updates than the new one has so far
+     FleetStore before;
+     for (int update = 0; update < 100; ++update) {
+         before.update(makeReading(1 + update % 4, update, update, 1000 + update));
+     }
+     uint64_t stale = before.version();
+
+     uint64_t firstVersion = FleetPublisher::epochVersion();
+     REQUIRE(firstVersion > stale);
+     FleetPublisher publisher(std::chrono::milliseconds(0), 2, firstVersion);
+     REQUIRE(publisher.current()->version() == firstVersion);
+     FleetStore even(TrackHistory::DefaultPoints, publisher.firstVersion());
+     FleetStore odd(TrackHistory::DefaultPoints, publisher.firstVersion());
+     for (int id = 1; id <= 4; ++id) {
+         (id % 2 == 0 ? even : odd).update(makeReading(id, id, id, 1000));
+     }
+     publisher.publish(0, even);
+     publisher.publish(1, odd);
+     std::shared_ptr<const FleetSnapshot> snapshot = publisher.current();
+     REQUIRE(snapshot->version() == firstVersion + 4);
+
+     std::vector<std::size_t> slots;
+     REQUIRE_FALSE(snapshot->changedSince(stale, snapshot->size() / 2, slots));
+     REQUIRE(changedIds(*snapshot, firstVersion) == std::vector<int>{1, 2, 3, 4});
+
+     // Versions of the new run still work as usual
+     odd.update(makeReading(3, 30, 30, 2000));
+     publisher.publish(1, odd);
+     REQUIRE(publisher.current()->version() == firstVersion + 5);
+     REQUIRE(changedIds(*publisher.current(), firstVersion + 4) == std::vector<int>{3});
+ }
+
+ TEST_CASE("TrackHistory keeps the most recent positions of each e-bike", "[FleetStore]") {
+     FleetStore store(3);
+     for (int64_t i = 1; i <= 5; ++i) {
+         store.update(makeReading(7, static_cast<int32_t>(i), -static_cast<int32_t>(i), i * 1000));
+     }
+     store.update(makeReading(8, 80, 81, 1000));
+
+     // A late retransmission does not enter the history
+     store.update(makeReading(7, 99, 99, 500));
+
+     std::vector<TrackSample> samples;
+     std::size_t slot = 0;
+     REQUIRE(store.find(7, slot));
+     REQUIRE(store.history().read(slot, INT64_MIN, INT64_MAX, samples) == 3);
+     REQUIRE(samples[0].timestampMs == 3000);
+     REQUIRE(samples[2].latitudeE6 == 5);
+     REQUIRE(samples[2].longitudeE6 == -5);
+
+     // Time-range filter, bounds inclusive
+     REQUIRE(store.history().read(slot, 4000, 4500, samples) == 1);
+     REQUIRE(samples[0].latitudeE6 == 4);
+
+     std::string out;
+     std::shared_ptr<const FleetSnapshot> snapshot = store.snapshot();
+     REQUIRE(snapshot->history(slot, 4000, INT64_MAX, samples) == 2);
+     appendTrack(out, 7, samples);
+     REQUIRE(out == "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\",\"coordinates\":"
+                    "[[-0.000004,0.000004],[-0.000005,0.000005]]},\"properties\":{\"id\":7,"
+                    "\"timestamps\":[\"1970-01-01T00:00:04Z\",\"1970-01-01T00:00:05Z\"]}}");
+
+     out.clear();
+     samples.clear();
+     appendTrack(out, 7, samples);
+     REQUIRE(out == "{\"type\":\"Feature\",\"geometry\":null,\"properties\":{\"id\":7,\"timestamps\":[]}}");
+ }
+
+ TEST_CASE("Combined snapshots find the history of every shard", "[FleetStore]") {
+     FleetStore empty, even, odd;
+     FleetPublisher publisher(std::chrono::milliseconds(0), 3);
+     even.update(makeReading(2, 20, 21, 1000));
+     even.update(makeReading(4, 40, 41, 1000));
+     odd.update(makeReading(1, 10, 11, 1000));
+     odd.update(makeReading(1, 12, 13, 2000));
+     publisher.publish(0, empty);
+     publisher.publish(1, even);
+     publisher.publish(2, odd);
+
+     std::shared_ptr<const FleetSnapshot> combined = publisher.current();
+     std::vector<TrackSample> samples;
+     std::size_t slot = 0;
+     REQUIRE(combined->find(4, slot));
+     REQUIRE(combined->history(slot, INT64_MIN, INT64_MAX, samples) == 1);
+     REQUIRE(samples[0].latitudeE6 == 40);
+     REQUIRE(combined->find(1, slot));
+     REQUIRE(combined->history(slot, INT64_MIN, INT64_MAX, samples) == 2);
+     REQUIRE(samples[1].latitudeE6 == 12);
+
+     // Histories are live: positions recorded after publication are visible
+     odd.update(makeReading(1, 14, 15, 3000));
+     REQUIRE(combined->history(slot, INT64_MIN, INT64_MAX, samples) == 3);
+ }
+
+ TEST_CASE("TrackHistory readers never see a torn ring", "[FleetStore]") {
+     TrackHistory history(16, 1);
+     std::atomic<bool> done{false};
+
+     // Every recorded position has latitude == longitude == timestamp
+     std::thread writer([&history, &done] {
+         for (int32_t i = 1; i <= 200000; ++i) {
+             TelemetryReading reading;
+             reading.timestampMs = i;
+             reading.latitudeE6 = i;
+             reading.longitudeE6 = i;
+             history.append(0, reading);
+         }
+         done = true;
+     });
+
+     std::vector<TrackSample> samples;
+     bool consistent = true;
+     while (!done) {
+         history.read(0, INT64_MIN, INT64_MAX, samples);
+         for (std::size_t i = 0; i < samples.size(); ++i) {
+             consistent = consistent && samples[i].latitudeE6 == samples[i].timestampMs
+                 && samples[i].longitudeE6 == samples[i].timestampMs
+                 && (i == 0 || samples[i].timestampMs == samples[i - 1].timestampMs + 1);
+         }
+     }
+     writer.join();
+     REQUIRE(consistent);
+     REQUIRE(history.read(0, INT64_MIN, INT64_MAX, samples) == 16);
+     REQUIRE(samples.back().timestampMs == 200000);
+
+     // Slots beyond the configured maximum have no history
+     TelemetryReading reading;
+     history.append(TrackHistory::BlockBikes, reading);
+     REQUIRE(history.read(TrackHistory::BlockBikes, INT64_MIN, INT64_MAX, samples) == 0);
+ }
+
+ TEST_CASE("SpatialGrid moves e-bikes between cells in place", "[FleetStore]") {
+     SpatialGrid grid(1000);
+     REQUIRE(grid.rowOf(999) == 0);
+     REQUIRE(grid.rowOf(-1) == -1);
+     REQUIRE(GridCells::key(-1, 5) < GridCells::key(0, -5));
+     REQUIRE(GridCells::rowOfKey(GridCells::key(-7, 3)) == -7);
+
+     grid.place(0, 500, 500);
+     grid.place(1, 600, 600);
+     grid.place(2, 1500, 500);
+     std::shared_ptr<const GridIndex> frozen = grid.freeze();
+     REQUIRE(frozen->cellCount() == 2);
+
+     // Moving within a cell keeps the frozen grid
+     grid.place(1, 700, 700);
+     REQUIRE(grid.freeze() == frozen);
+
+     // Moving slot 0 out of its cell leaves slot 1 behind in it
+     grid.place(0, -500, 500);
+     std::shared_ptr<const GridIndex> moved = grid.freeze();
+     REQUIRE(moved != frozen);
+     std::vector<std::size_t> visited;
+     moved->forEachInCells(0, 0, 0, 0, [&visited](std::size_t slot) { visited.push_back(slot); });
+     REQUIRE(visited == std::vector<std::size_t>{1});
+     visited.clear();
+     moved->forEachInCells(-1, 1, 0, 0, [&visited](std::size_t slot) { visited.push_back(slot); });
+     REQUIRE(visited == std::vector<std::size_t>{0, 1, 2});
+ }
+
+ TEST_CASE("Snapshots find the e-bikes inside a bounding box", "[FleetStore]") {
+     FleetStore even, odd;
+     FleetPublisher publisher(std::chrono::milliseconds(0), 2);
+     // Bristol, one just outside the box, and one far away
+     odd.update(makeReading(1, 51455000, -2585000, 1000));
+     even.update(makeReading(2, 51460000, -2590000, 1000));
+     odd.update(makeReading(3, 51470001, -2585000, 1000));
+     even.update(makeReading(4, 48856000, 2352000, 1000));
+     publisher.publish(0, even);
+     publisher.publish(1, odd);
+
+     std::shared_ptr<const FleetSnapshot> snapshot = publisher.current();
+     std::vector<std::size_t> slots;
+     REQUIRE(snapshot->queryBox(51450000, -2600000, 51470000, -2580000, slots) == 2);
+     std::vector<int> ids;
+     for (std::size_t slot : slots) {
+         ids.push_back(snapshot->ids()[slot]);
+     }
+     std::sort(ids.begin(), ids.end());
+     REQUIRE(ids == std::vector<int>{1, 2});
+
+     // Edges are included
+     REQUIRE(snapshot->queryBox(51455000, -2585000, 51455000, -2585000, slots) == 1);
+     REQUIRE(snapshot->queryBox(-90000000, -180000000, 90000000, 180000000, slots) == 4);
+     REQUIRE(snapshot->queryBox(0, 0, 1000, 1000, slots) == 0);
+
+     std::string out;
+     snapshot->queryBox(48000000, 2000000, 49000000, 3000000, slots);
+     appendFeatureCollection(out, *snapshot, slots);
+     REQUIRE(out.find("\"id\":4") != std::string::npos);
+     REQUIRE(out.find("\"id\":1") == std::string::npos);
+ }
+
+ TEST_CASE("Nearest e-bikes match a linear scan by haversine distance", "[FleetStore]") {
+     FleetStore shards[3];
+     FleetPublisher publisher(std::chrono::milliseconds(0), 3);
+
+     // A city of e-bikes plus a few far away, some of them locked
+     uint32_t seed = 12345;
+     auto next = [&seed](uint32_t range) {
+         seed = seed * 1103515245u + 12345u;
+         return static_cast<int32_t>((seed >> 8) % range);
+     };
+     for (int id = 1; id <= 3000; ++id) {
+         bool far = id % 500 == 0;
+         int32_t latitude = far ? 10000000 + next(1000000) : 51400000 + next(120000);
+         int32_t longitude = far ? 100000000 + next(1000000) : -2650000 + next(180000);
+         shards[id % 3].update(makeReading(id, latitude, longitude, 1000));
+         if (id % 4 == 0) {
+             shards[id % 3].setStatus(id, EBikeStatus::Locked);
+         }
+     }
+     for (std::size_t shard = 0; shard < 3; ++shard) {
+         publisher.publish(shard, shards[shard]);
+     }
+     std::shared_ptr<const FleetSnapshot> snapshot = publisher.current();
+
+     auto linearScan = [&snapshot](int32_t latitude, int32_t longitude, std::size_t k, std::optional<EBikeStatus> status) {
+         std::vector<double> distances;
+         for (std::size_t slot = 0; slot < snapshot->size(); ++slot) {
+             if (!status || snapshot->statuses()[slot] == *status) {
+                 distances.push_back(geodesy::distanceMeters(latitude, longitude,
+                                                             snapshot->latitudes()[slot], snapshot->longitudes()[slot]));
+             }
+         }
+         std::sort(distances.begin(), distances.end());
+         distances.resize(std::min(k, distances.size()));
+         return distances;
+     };
+
+     std::vector<NearbyBike> nearby;
+     const int32_t queries[][2] = {{51455000, -2585000}, {51400000, -2650000}, {51600000, -2400000},
+                                   {10500000, 100500000}, {0, 0}};
+     for (const auto& query : queries) {
+         for (std::size_t k : {1, 5, 40}) {
+             for (std::optional<EBikeStatus> status : {std::optional<EBikeStatus>(), std::optional<EBikeStatus>(EBikeStatus::Unlocked)}) {
+                 std::vector<double> expected = linearScan(query[0], query[1], k, status);
+                 REQUIRE(snapshot->nearest(query[0], query[1], k, status, nearby) == expected.size());
+                 for (std::size_t i = 0; i < nearby.size(); ++i) {
+                     REQUIRE(nearby[i].distanceMeters == Approx(expected[i]));
+                     REQUIRE((!status || snapshot->statuses()[nearby[i].slot] == *status));
+                 }
+             }
+         }
+     }
+
+     // Asking for more than the fleet returns every matching e-bike
+     REQUIRE(snapshot->nearest(51455000, -2585000, 5000, EBikeStatus::Locked, nearby) == 750);
+ }
+
+ TEST_CASE("Haversine distances", "[FleetStore]") {
+     // Bristol Temple Meads to Clifton Suspension Bridge, about 3.3 km
+     REQUIRE(geodesy::distanceMeters(51449100, -2581300, 51454900, -2627800) == Approx(3287).epsilon(0.01));
+     REQUIRE(geodesy::distanceMeters(0, 0, 0, 180000000) == Approx(geodesy::Pi * geodesy::EarthRadiusMeters));
+     REQUIRE(geodesy::distanceMeters(51449100, -2581300, 51449100, -2581300) == 0.0);
+ }
+
+ TEST_CASE("FeatureCollectionCache rebuilds only for new versions", "[FleetStore]") {
+     FleetStore store;
+     FleetPublisher publisher(std::chrono::milliseconds(0));
+     FeatureCollectionCache cache(publisher);
+
+     store.update(makeReading(1, 100, 200, 1000));
+     publisher.publish(store);
+
+     std::shared_ptr<const CachedFeatureCollection> first = cache.get();
+     REQUIRE(first->version == 1);
+     REQUIRE(cache.get() == first);
+
+     // Updates become visible only once they are published
+     store.update(makeReading(2, 300, 400, 2000));
+     REQUIRE(cache.get() == first);
+
+     publisher.publish(store);
+     std::shared_ptr<const CachedFeatureCollection> second = cache.get();
+     REQUIRE(second != first);
+     REQUIRE(second->version == 2);
+     REQUIRE(second->body.find("\"id\":2") != std::string::npos);
+ }
+
+ TEST_CASE("FleetStream coalesces changes into frames shared by every subscriber", "[FleetStore]") {
+     FleetStore store;
+     FleetPublisher publisher(std::chrono::milliseconds(0));
+     FleetStream stream(publisher, 20);
+     REQUIRE(stream.interval() == std::chrono::milliseconds(50));
+     auto soon = [] { return std::chrono::steady_clock::now() + std::chrono::seconds(2); };
+
+     store.update(makeReading(1, 100, 200, 1000));
+     store.update(makeReading(2, 300, 400, 1000));
+     publisher.publish(store);
+     uint64_t start = publisher.current()->version();
+
+     // Nothing changed, so the wait times out
+     REQUIRE(stream.next(start, std::chrono::steady_clock::now() + std::chrono::milliseconds(120)) == nullptr);
+
+     // Two publications before the next check make one frame
+     store.update(makeReading(1, 110, 210, 2000));
+     publisher.publish(store);
+     store.update(makeReading(3, 500, 600, 2000));
+     publisher.publish(store);
+
+     std::shared_ptr<const StreamFrame> other;
+     std::thread subscriber([&] { other = stream.next(start, soon()); });
+     std::shared_ptr<const StreamFrame> frame = stream.next(start, soon());
+     subscriber.join();
+     REQUIRE(frame);
+     REQUIRE(frame == other);
+     REQUIRE(frame->since == start);
+     REQUIRE(frame->version == publisher.current()->version());
+     REQUIRE(frame->event.compare(0, 19, "event: delta\ndata: ") == 0);
+     REQUIRE(frame->event.compare(frame->event.size() - 2, 2, "\n\n") == 0);
+     REQUIRE(frame->event.find("\"id\":1") != std::string::npos);
+     REQUIRE(frame->event.find("\"id\":2") == std::string::npos);
+     REQUIRE(frame->event.find("\"id\":3") != std::string::npos);
+
+     // A subscriber older than the frame's base has to resynchronise
+     REQUIRE(stream.next(0, soon())->since > 0);
+ }
+
+ TEST_CASE("Accept-Encoding picks gzip, deflate or identity", "[FleetStore]") {
+     REQUIRE(negotiateEncoding("") == ContentEncoding::Identity);
+     REQUIRE(negotiateEncoding("gzip, deflate, br") == ContentEncoding::Gzip);
+     REQUIRE(negotiateEncoding("deflate") == ContentEncoding::Deflate);
+     REQUIRE(negotiateEncoding("gzip;q=0.5, deflate") == ContentEncoding::Deflate);
+     REQUIRE(negotiateEncoding("GZIP ; q=1.0") == ContentEncoding::Gzip);
+     REQUIRE(negotiateEncoding("gzip;q=0, deflate;q=0") == ContentEncoding::Identity);
+     REQUIRE(negotiateEncoding("*") == ContentEncoding::Gzip);
+     REQUIRE(negotiateEncoding("br, identity") == ContentEncoding::Identity);
+
+     // "*" only covers the codings not named, so an explicit q=0 still refuses one
+     REQUIRE(negotiateEncoding("gzip;q=0, *") == ContentEncoding::Deflate);
+     REQUIRE(negotiateEncoding("*, deflate;q=0") == ContentEncoding::Gzip);
+     REQUIRE(negotiateEncoding("gzip;q=0, deflate;q=0, *") == ContentEncoding::Identity);
+     REQUIRE(negotiateEncoding("deflate;q=0.5, *;q=0.8") == ContentEncoding::Gzip);
+     REQUIRE(negotiateEncoding("*;q=0") == ContentEncoding::Identity);
+ }
+
+ TEST_CASE("Cached FeatureCollections are compressed once and validated by ETag", "[FleetStore]") {
+     FleetStore store;
+     FleetPublisher publisher(std::chrono::milliseconds(0));
+     FeatureCollectionCache cache(publisher);
+     for (int id = 0; id < 200; ++id) {
+         store.update(makeReading(id, 51000000 + id, -2500000 - id, 1000));
+     }
+     publisher.publish(store);
+     std::shared_ptr<const CachedFeatureCollection> cached = cache.get();
+
+     for (ContentEncoding encoding : {ContentEncoding::Gzip, ContentEncoding::Deflate}) {
+         const std::string* compressed = cached->encoded(encoding);
+         REQUIRE(compressed);
+         REQUIRE(cached->encoded(encoding) == compressed);
+         REQUIRE(compressed->size() < cached->body.size() / 4);
+
+         // Inflate with automatic gzip/zlib header detection
+         z_stream stream{};
+         REQUIRE(inflateInit2(&stream, 15 + 32) == Z_OK);
+         std::string inflated(cached->body.size(), '\0');
+         stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed->data()));
+         stream.avail_in = static_cast<uInt>(compressed->size());
+         stream.next_out = reinterpret_cast<Bytef*>(&inflated[0]);
+         stream.avail_out = static_cast<uInt>(inflated.size());
+         REQUIRE(inflate(&stream, Z_FINISH) == Z_STREAM_END);
+         inflateEnd(&stream);
+         REQUIRE(inflated == cached->body);
+         REQUIRE(static_cast<uint8_t>((*compressed)[0]) == (encoding == ContentEncoding::Gzip ? 0x1f : 0x78));
+     }
+     REQUIRE(cached->encoded(ContentEncoding::Identity) == &cached->body);
+
+     // ETags differ per coding; If-None-Match must hold the tag of the coding being sent, weak or strong, in a list
+     const std::string& etag = cached->etag(ContentEncoding::Identity);
+     REQUIRE(etag.front() == '"');
+     REQUIRE(etag.back() == '"');
+     REQUIRE(cached->etag(ContentEncoding::Gzip) != etag);
+     REQUIRE(cached->matches(etag, ContentEncoding::Identity));
+     REQUIRE(cached->matches("\"other\", W/" + cached->etag(ContentEncoding::Gzip), ContentEncoding::Gzip));
+     REQUIRE_FALSE(cached->matches(cached->etag(ContentEncoding::Gzip), ContentEncoding::Identity));
+     REQUIRE_FALSE(cached->matches(etag, ContentEncoding::Deflate));
+     REQUIRE(cached->matches("*", ContentEncoding::Deflate));
+     REQUIRE_FALSE(cached->matches("\"other\"", ContentEncoding::Identity));
+     REQUIRE_FALSE(cached->matches("", ContentEncoding::Identity));
+
+     // A new version gets new tags
+     store.update(makeReading(1, 0, 0, 2000));
+     publisher.publish(store);
+     REQUIRE_FALSE(cache.get()->matches(etag, ContentEncoding::Identity));
+ }
@@ -0,0 +1,173 @@
+/**
+ * @file test_IngestAllocations.cpp
+ * @brief Checks that the steady-state ingest path never allocates
+ * @date October 2026
+ */
+ #define CATCH_CONFIG_MAIN
+
+ #include <catch2/catch.hpp>
+ #include <atomic>
+ #include <cstdlib>
+ #include <cstring>
+ #include <new>
+ #include <array>
+ #include <chrono>
+ #include <string>
+ #include <string_view>
+ #include <vector>
+ #include "MessageHandler.h"
+ #include "fleet/FleetPublisher.h"
+ #include "proto/TelemetryFrame.h"
+ #include "sim/socket.h"
+ #include "util/BufferPool.h"
+ #include "util/SpscQueue.h"
+
+ // Every heap allocation in the program goes through these
+ static std::atomic<std::size_t> g_allocations{0};
+
+ void* operator new(std::size_t size) {
+     g_allocations.fetch_add(1, std::memory_order_relaxed);
+     if (void* memory = std::malloc(size > 0 ? size : 1)) {
+         return memory;
+     }
+     throw std::bad_alloc();
+ }
+
+ void operator delete(void* memory) noexcept {
+     std::free(memory);
+ }
+
+ void operator delete(void* memory, std::size_t) noexcept {
+     std::free(memory);
+ }
+
+ static TelemetryReading makeReading(int id, uint32_t sequence) {
+     TelemetryReading reading;
+     reading.ebikeId = id;
+     reading.sequence = sequence;
+     reading.timestampMs = 1739359594000 + sequence;
+     reading.latitudeE6 = 51459079 + static_cast<int32_t>(sequence);
+     reading.longitudeE6 = -2544360;
+     return reading;
+ }
+
+ TEST_CASE("Handling known e-bikes does not allocate", "[Allocations]") {
+     // Log lines go to the calling thread's AsyncLog ring; the writer thread's passes are counted too.
+     // Publication is periodic work outside the per-datagram path
+     FleetPublisher publisher(std::chrono::hours(1));
+     MessageHandler handler(publisher);
+     BufferPool pool(8, TelemetryFrame::MaxDatagramSize);
+     SpscQueue<char*> queue(8);
+     std::array<uint8_t, TelemetryFrame::AckSize> ackBuffer;
+
+     const int bikes = 100;
+     std::vector<std::vector<uint8_t>> messages;
+     for (int id = 1; id <= bikes; ++id) {
+         std::vector<uint8_t> frame(TelemetryFrame::ReadingSize);
+         TelemetryFrame::encodeReading(makeReading(id, 1), frame.data());
+         messages.push_back(frame);
+
+         TelemetryReading batch[3] = {makeReading(id, 2), makeReading(id, 3), makeReading(id, 4)};
+         frame.resize(TelemetryFrame::BatchHeaderSize + 3 * TelemetryFrame::BatchEntrySize);
+         TelemetryFrame::encodeBatch(id, batch, 3, frame.data());
+         messages.push_back(frame);
+
+         std::string json = "{\"ebike_id\":" + std::to_string(id)
+             + ",\"timestamp\":\"2025-02-12T11:26:34Z\",\"gps\":{\"latitude\":51.45,\"longitude\":-2.58}}";
+         messages.push_back(std::vector<uint8_t>(json.begin(), json.end()));
+     }
+
+     // Receive each message into a pooled buffer, queue it, handle it and give the buffer back
+     auto ingestAll = [&]() {
+         std::size_t acknowledged = 0;
+         for (const std::vector<uint8_t>& message : messages) {
+             char* buffer = pool.acquire();
+             std::copy(message.begin(), message.end(), buffer);
+             *queue.claim() = buffer;
+             queue.commit();
+
+             char* received = *queue.front();
+             std::string_view response = handler.handleMessage(
+                 std::string_view(received, message.size()), "192.168.1.2", 8081, ackBuffer.data());
+             acknowledged += response.empty() ? 0 : 1;
+             queue.pop();
+             pool.release(received);
+         }
+         return acknowledged;
+     };
+
+     // The first round adds every e-bike to the store
+     ingestAll();
+
+     std::size_t before = g_allocations.load();
+     std::size_t acknowledged = ingestAll();
+     std::size_t allocations = g_allocations.load() - before;
+
+     REQUIRE(acknowledged == messages.size());
+     REQUIRE(allocations == 0);
+ }
+
+ TEST_CASE("Batched socket calls do not allocate for known peers", "[Allocations]") {
+     // The gateway's side of the exchange is counted; the client's sendto and recvfrom build paths as strings
+     auto address = [](const char* ip, int port) {
+         sockaddr_in addr;
+         std::memset(&addr, 0, sizeof(addr));
+         addr.sin_family = AF_INET;
+         addr.sin_port = htons(static_cast<uint16_t>(port));
+         inet_pton(AF_INET, ip, &addr.sin_addr);
+         return addr;
+     };
+     sockaddr_in gatewayAddr = address("127.0.0.1", 47301);
+     sockaddr_in clientAddr = address("127.0.0.2", 47302);
+     sim::socket gateway(AF_INET, SOCK_DGRAM, 0);
+     sim::socket client(AF_INET, SOCK_DGRAM, 0);
+     gateway.bind(gatewayAddr);
+     client.bind(clientAddr);
+     client.setReceiveTimeout(1000);
+
+     // Fewer datagrams than a UNIX socket queues, so sending never blocks
+     const unsigned int count = 8;
+     std::array<std::array<char, TelemetryFrame::ReadingSize>, count> buffers;
+     std::array<sim::datagram, count> datagrams;
+     std::array<uint8_t, TelemetryFrame::ReadingSize> frame;
+     TelemetryFrame::encodeReading(makeReading(1, 1), frame.data());
+
+     auto exchange = [&]() {
+         for (unsigned int i = 0; i < count; ++i) {
+             client.sendto(frame.data(), frame.size(), 0, gatewayAddr);
+         }
+         std::size_t before = g_allocations.load();
+         unsigned int received = 0;
+         unsigned int fromClient = 0;
+         while (received < count) {
+             for (unsigned int i = 0; i < count - received; ++i) {
+                 datagrams[i] = sim::datagram{buffers[i].data(), buffers[i].size(), 0, {}};
+             }
+             int batch = gateway.recvmmsg(datagrams.data(), count - received, 0);
+             if (batch <= 0) {
+                 break;
+             }
+             for (int i = 0; i < batch; ++i) {
+                 fromClient += datagrams[i].addr.sin_port == clientAddr.sin_port
+                     && datagrams[i].addr.sin_addr.s_addr == clientAddr.sin_addr.s_addr;
+                 datagrams[i].size = datagrams[i].length;
+             }
+             gateway.sendmmsg(datagrams.data(), static_cast<unsigned int>(batch), 0);
+             received += static_cast<unsigned int>(batch);
+         }
+         std::size_t allocations = g_allocations.load() - before;
+         REQUIRE(fromClient == count);
+
+         // The replies found their way back to the client
+         char reply[TelemetryFrame::ReadingSize];
+         sockaddr_in from;
+         for (unsigned int i = 0; i < count; ++i) {
+             REQUIRE(client.recvfrom(reply, sizeof(reply), 0, from) == static_cast<ssize_t>(sizeof(reply)));
+         }
+         return allocations;
+     };
+
+     // The first exchange fills the address caches and scratch space
+     exchange();
+     REQUIRE(exchange() == 0);
+ }
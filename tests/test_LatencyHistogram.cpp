@@ -0,0 +1,92 @@
+/**
+ * @file test_LatencyHistogram.cpp
+ * @brief Unit tests for the log-bucketed stage latency histograms
+ * @date October 2026
+ */
+ #define CATCH_CONFIG_MAIN
+
+ #include <catch2/catch.hpp>
+ #include <memory>
+ #include <string>
+ #include <thread>
+ #include <vector>
+ #include "util/LatencyHistogram.h"
+
+ TEST_CASE("LatencyHistogram buckets keep values within about 3%", "[LatencyHistogram]") {
+     for (uint64_t value = 0; value < 64; ++value) {
+         REQUIRE(LatencyHistogram::highestOf(LatencyHistogram::bucketOf(value)) == value);
+     }
+     std::size_t previous = 0;
+     for (uint64_t value = 64; value < (uint64_t{1} << 40); value = value * 9 / 8 + 1) {
+         std::size_t bucket = LatencyHistogram::bucketOf(value);
+         uint64_t highest = LatencyHistogram::highestOf(bucket);
+         REQUIRE(bucket >= previous);
+         REQUIRE(bucket < LatencyHistogram::BucketCount);
+         REQUIRE(highest >= value);
+         REQUIRE(highest - value <= value / LatencyHistogram::SubBuckets);
+         REQUIRE(LatencyHistogram::bucketOf(highest) == bucket);
+         REQUIRE(LatencyHistogram::bucketOf(highest + 1) == bucket + 1);
+         previous = bucket;
+     }
+
+     // Values too large for the histogram share its last bucket
+     REQUIRE(LatencyHistogram::bucketOf(~uint64_t{0}) == LatencyHistogram::BucketCount - 1);
+ }
+
+ TEST_CASE("LatencyHistogram reads back percentiles", "[LatencyHistogram]") {
+     auto histogram = std::make_unique<LatencyHistogram>();
+     REQUIRE(histogram->percentile(0.5) == 0);
+     REQUIRE(histogram->max() == 0);
+
+     // 1 to 100000 ns, once each
+     for (uint64_t value = 1; value <= 100000; ++value) {
+         histogram->record(value);
+     }
+     REQUIRE(histogram->count() == 100000);
+     REQUIRE(histogram->percentile(0.5) == Approx(50000).epsilon(0.035));
+     REQUIRE(histogram->percentile(0.99) == Approx(99000).epsilon(0.035));
+     REQUIRE(histogram->percentile(0.999) == Approx(99900).epsilon(0.035));
+     REQUIRE(histogram->percentile(0.5) >= 50000);
+     REQUIRE(histogram->max() >= 100000);
+     REQUIRE(histogram->max() <= 100000 + 100000 / LatencyHistogram::SubBuckets);
+
+     // One slow outlier shows at the top only
+     histogram->record(5000000000, 10);
+     REQUIRE(histogram->percentile(0.99) < 200000);
+     REQUIRE(histogram->percentile(1.0) >= 5000000000);
+ }
+
+ TEST_CASE("StageLatencies merges what every thread recorded", "[LatencyHistogram]") {
+     std::vector<std::thread> threads;
+     for (int t = 0; t < 4; ++t) {
+         threads.emplace_back([t] {
+             for (int i = 0; i < 1000; ++i) {
+                 StageLatencies::record(Stage::Parse, 1000 * static_cast<uint64_t>(t + 1));
+             }
+         });
+     }
+     for (auto& thread : threads) {
+         thread.join();
+     }
+     StageLatencies::record(Stage::Store, 250);
+
+     auto parse = std::make_unique<LatencyHistogram>();
+     StageLatencies::merge(Stage::Parse, *parse);
+     REQUIRE(parse->count() == 4000);
+     REQUIRE(parse->percentile(0.2) == Approx(1000).epsilon(0.035));
+     REQUIRE(parse->percentile(0.7) == Approx(3000).epsilon(0.035));
+     REQUIRE(parse->max() == Approx(4000).epsilon(0.035));
+
+     std::string table;
+     StageLatencies::appendTable(table);
+     REQUIRE(table.find("p999 us") != std::string::npos);
+     REQUIRE(table.find("\nparse            4000 ") != std::string::npos);
+     REQUIRE(table.find("\nstore               1 ") != std::string::npos);
+     REQUIRE(table.find("\npublish             0 ") != std::string::npos);
+
+     std::string text;
+     StageLatencies::appendPrometheus(text);
+     REQUIRE(text.find("# TYPE ebike_stage_latency_seconds summary\n") != std::string::npos);
+     REQUIRE(text.find("ebike_stage_latency_seconds_count{stage=\"parse\"} 4000\n") != std::string::npos);
+     REQUIRE(text.find("ebike_stage_latency_seconds{stage=\"ack\",quantile=\"0.99\"} 0.000000000\n") != std::string::npos);
+ }
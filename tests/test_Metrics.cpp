@@ -0,0 +1,84 @@
+/**
+ * @file test_Metrics.cpp
+ * @brief Unit tests for the per-thread counters and gauges
+ * @date October 2026
+ */
+ #define CATCH_CONFIG_MAIN
+
+ #include <catch2/catch.hpp>
+ #include <string>
+ #include <thread>
+ #include <vector>
+ #include "util/Metrics.h"
+
+ TEST_CASE("Metrics sums counters over threads, including exited ones", "[Metrics]") {
+     uint64_t before = Metrics::total(Counter::ReadingsApplied);
+
+     std::vector<std::thread> threads;
+     for (int t = 0; t < 4; ++t) {
+         threads.emplace_back([] {
+             for (int i = 0; i < 10000; ++i) {
+                 Metrics::add(Counter::ReadingsApplied);
+             }
+             Metrics::add(Counter::ReadingsApplied, 5);
+         });
+     }
+     for (auto& thread : threads) {
+         thread.join();
+     }
+
+     REQUIRE(Metrics::total(Counter::ReadingsApplied) - before == 4 * 10005);
+     Metrics::add(Counter::ReadingsApplied, 3);
+     REQUIRE(Metrics::total(Counter::ReadingsApplied) - before == 4 * 10005 + 3);
+ }
+
+ TEST_CASE("Metrics gauges follow their scopes", "[Metrics]") {
+     REQUIRE(Metrics::total(Gauge::StreamSubscribers) == 0);
+     {
+         ScopedGauge first(Gauge::StreamSubscribers);
+         ScopedGauge second(Gauge::StreamSubscribers);
+         REQUIRE(Metrics::total(Gauge::StreamSubscribers) == 2);
+
+         // A share raised on one thread and lowered on another still sums to the level
+         std::thread([] { Metrics::adjust(Gauge::StreamSubscribers, -1); }).join();
+         REQUIRE(Metrics::total(Gauge::StreamSubscribers) == 1);
+         Metrics::adjust(Gauge::StreamSubscribers, 1);
+     }
+     REQUIRE(Metrics::total(Gauge::StreamSubscribers) == 0);
+ }
+
+ TEST_CASE("Metrics are exported in the Prometheus text format", "[Metrics]") {
+     Metrics::add(Counter::AcksSent, 42);
+     std::string text;
+     Metrics::appendPrometheus(text);
+
+     REQUIRE(text.find("# HELP ebike_acks_sent_total Acknowledgments returned to e-bikes.\n"
+                       "# TYPE ebike_acks_sent_total counter\n"
+                       "ebike_acks_sent_total " + std::to_string(Metrics::total(Counter::AcksSent)) + "\n") != std::string::npos);
+     REQUIRE(text.find("# TYPE ebike_stream_subscribers gauge\nebike_stream_subscribers 0\n") != std::string::npos);
+     for (std::size_t i = 0; i < Metrics::CounterCount; ++i) {
+         REQUIRE(text.find(std::string(Metrics::counterName(static_cast<Counter>(i))) + " ") != std::string::npos);
+     }
+
+     Metrics::appendSample(text, "ebike_fleet_size", "E-bikes.", "gauge", std::size_t{7});
+     REQUIRE(text.substr(text.size() - 20) == "\nebike_fleet_size 7\n");
+ }
+
+ TEST_CASE("Metrics fold the blocks of exited threads into one total", "[Metrics]") {
+     uint64_t before = Metrics::total(Counter::HttpRequests);
+
+     // One short-lived thread after another, as a thread pool retires and starts them
+     for (int t = 0; t < 100; ++t) {
+         std::thread([] {
+             Metrics::add(Counter::HttpRequests, 2);
+             Metrics::adjust(Gauge::HttpActiveRequests, 1);
+         }).join();
+     }
+     REQUIRE(Metrics::total(Counter::HttpRequests) - before == 200);
+     REQUIRE(Metrics::total(Gauge::HttpActiveRequests) == 100);
+     Metrics::adjust(Gauge::HttpActiveRequests, -100);
+     REQUIRE(Metrics::total(Gauge::HttpActiveRequests) == 0);
+
+     // Only the main thread is still registered
+     REQUIRE(Metrics::threads() == 1);
+ }
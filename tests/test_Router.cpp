@@ -0,0 +1,124 @@
+/**
+ * @file test_Router.cpp
+ * @brief Unit tests for the path trie that routes web requests
+ * @date October 2026
+ */
+ #define CATCH_CONFIG_MAIN
+
+ #include <catch2/catch.hpp>
+ #include <atomic>
+ #include <cstdlib>
+ #include <new>
+ #include <stdexcept>
+ #include <string_view>
+ #include "web/Router.h"
+
+ // Every heap allocation in the program goes through these
+ static std::atomic<std::size_t> g_allocations{0};
+
+ void* operator new(std::size_t size) {
+     g_allocations.fetch_add(1, std::memory_order_relaxed);
+     if (void* memory = std::malloc(size > 0 ? size : 1)) {
+         return memory;
+     }
+     throw std::bad_alloc();
+ }
+
+ void operator delete(void* memory) noexcept {
+     std::free(memory);
+ }
+
+ void operator delete(void* memory, std::size_t) noexcept {
+     std::free(memory);
+ }
+
+ enum Route { Ebikes, Stream, Nearest, History, Track, Root };
+
+ static Router makeRouter() {
+     Router router;
+     router.add("/ebikes", Ebikes);
+     router.add("/ebikes/stream", Stream);
+     router.add("/ebikes/nearest", Nearest);
+     router.add("/ebikes/{id}/history", History);
+     router.add("/ebikes/{id}/track/{day}", Track);
+     router.add("/", Root);
+     return router;
+ }
+
+ TEST_CASE("Router picks the route of a path", "[Router]") {
+     Router router = makeRouter();
+     RouteMatch match;
+
+     REQUIRE(router.match("/ebikes", match));
+     REQUIRE(match.route == Ebikes);
+     REQUIRE(match.parameterCount == 0);
+     REQUIRE(router.match("/", match));
+     REQUIRE(match.route == Root);
+
+     // Literal segments are preferred to parameters
+     REQUIRE(router.match("/ebikes/nearest?lat=51.4&lon=-2.5", match));
+     REQUIRE(match.route == Nearest);
+     REQUIRE(router.match("/ebikes/stream", match));
+     REQUIRE(match.route == Stream);
+
+     // Paths that are not a whole pattern do not match
+     REQUIRE_FALSE(router.match("/ebikes/", match));
+     REQUIRE_FALSE(router.match("/ebikes/7", match));
+     REQUIRE_FALSE(router.match("/ebikes//history", match));
+     REQUIRE_FALSE(router.match("/ebikes/7/history/more", match));
+     REQUIRE_FALSE(router.match("/map.html", match));
+     REQUIRE_FALSE(router.match("ebikes", match));
+     REQUIRE_FALSE(router.match("", match));
+ }
+
+ TEST_CASE("Router captures parameters and the query string", "[Router]") {
+     Router router = makeRouter();
+     RouteMatch match;
+
+     REQUIRE(router.match("/ebikes/42/history?from=2025-02-12T11:26:34Z&to", match));
+     REQUIRE(match.route == History);
+     REQUIRE(match.parameter("id") == "42");
+     REQUIRE(match.parameter("day").empty());
+     std::string_view value;
+     REQUIRE(match.queryParameter("from", value));
+     REQUIRE(value == "2025-02-12T11:26:34Z");
+     REQUIRE(match.queryParameter("to", value));
+     REQUIRE(value.empty());
+     REQUIRE_FALSE(match.queryParameter("fro", value));
+
+     // A literal that leads nowhere falls back to the parameter
+     REQUIRE(router.match("/ebikes/nearest/history", match));
+     REQUIRE(match.route == History);
+     REQUIRE(match.parameter("id") == "nearest");
+
+     REQUIRE(router.match("/ebikes/7/track/2025-02-12", match));
+     REQUIRE(match.route == Track);
+     REQUIRE(match.parameterCount == 2);
+     REQUIRE(match.parameter("id") == "7");
+     REQUIRE(match.parameter("day") == "2025-02-12");
+     REQUIRE(match.query.empty());
+ }
+
+ TEST_CASE("Router rejects malformed patterns", "[Router]") {
+     Router router = makeRouter();
+     REQUIRE_THROWS_AS(router.add("ebikes", 9), std::invalid_argument);
+     REQUIRE_THROWS_AS(router.add("/ebikes/stream", 9), std::invalid_argument);
+     REQUIRE_THROWS_AS(router.add("/ebikes/{bike}/status", 9), std::invalid_argument);
+     REQUIRE_THROWS_AS(router.add("/{a}/{b}/{c}/{d}/{e}", 9), std::invalid_argument);
+ }
+
+ TEST_CASE("Routing does not allocate", "[Router]") {
+     Router router = makeRouter();
+     RouteMatch match;
+     std::string_view value;
+
+     std::size_t before = g_allocations.load();
+     for (int i = 0; i < 1000; ++i) {
+         REQUIRE(router.match("/ebikes/42/history?from=0&to=1", match));
+         REQUIRE(match.queryParameter("to", value));
+         REQUIRE(router.match("/ebikes?since=7", match));
+         REQUIRE_FALSE(router.match("/wp-login.php", match));
+     }
+     std::size_t allocations = g_allocations.load() - before;
+     REQUIRE(allocations == 0);
+ }
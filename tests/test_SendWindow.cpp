@@ -0,0 +1,150 @@
+/**
+ * @file test_SendWindow.cpp
+ * @brief Unit tests for acknowledgment tracking and the client send window
+ * @date October 2026
+ */
+ #define CATCH_CONFIG_MAIN
+
+ #include <catch2/catch.hpp>
+ #include <chrono>
+ #include <vector>
+ #include "proto/AckTracker.h"
+ #include "proto/SendWindow.h"
+ #include "proto/TelemetryFrame.h"
+
+ TEST_CASE("AckTracker advances the cumulative ACK over contiguous readings", "[AckTracker]") {
+     AckTracker acks;
+     REQUIRE(acks.receive(7, 1).cumulative == 1);
+     REQUIRE(acks.receive(7, 2).cumulative == 2);
+
+     // A gap is reported through the selective bitmap
+     AckTracker::State state = acks.receive(7, 4);
+     REQUIRE(state.cumulative == 2);
+     REQUIRE(state.selective == 0x2);
+
+     // Filling the gap folds the bitmap into the cumulative ACK
+     state = acks.receive(7, 3);
+     REQUIRE(state.cumulative == 4);
+     REQUIRE(state.selective == 0);
+
+     // Duplicates and other e-bikes leave the state alone
+     REQUIRE(acks.receive(7, 2).cumulative == 4);
+     REQUIRE(acks.state(8).cumulative == 0);
+ }
+
+ TEST_CASE("AckTracker never acknowledges readings that did not arrive", "[AckTracker]") {
+     AckTracker acks;
+     acks.receive(1, 1);
+     // Beyond the window: recording it would mean moving the cumulative ACK over 2 to 136
+     AckTracker::State state = acks.receive(1, 200);
+     REQUIRE(state.cumulative == 1);
+     REQUIRE(state.selective == 0);
+
+     // A lost batch of 70 readings leaves the whole next batch beyond the window, so it is not acknowledged either
+     for (uint32_t sequence = 71; sequence <= 139; ++sequence) {
+         state = acks.receive(2, sequence);
+     }
+     REQUIRE(state.cumulative == 0);
+     REQUIRE(state.selective == 0);
+     for (uint32_t sequence = 1; sequence <= 70; ++sequence) {
+         state = acks.receive(2, sequence);
+     }
+     REQUIRE(state.cumulative == 70);
+     for (uint32_t sequence = 71; sequence <= 139; ++sequence) {
+         state = acks.receive(2, sequence);
+     }
+     REQUIRE(state.cumulative == 139);
+
+     // The last bit of the window is still reachable
+     state = acks.receive(2, 139 + AckTracker::WindowSize);
+     REQUIRE(state.cumulative == 139);
+     REQUIRE(state.selective == uint64_t(1) << 63);
+
+     // A restarted client begins again at sequence 1
+     REQUIRE(acks.receive(2, 1).cumulative == 1);
+ }
+
+ TEST_CASE("SendWindow removes datagrams covered by an ACK", "[SendWindow]") {
+     SendWindow window(3, std::chrono::milliseconds(100));
+     SendWindow::Clock::time_point now = SendWindow::Clock::now();
+     uint8_t bytes[4] = {1, 2, 3, 4};
+     window.push(1, 1, bytes, sizeof(bytes), now);
+     window.push(2, 4, bytes, sizeof(bytes), now);
+     window.push(5, 5, bytes, sizeof(bytes), now);
+     REQUIRE(window.full());
+
+     // Sequence 5 arrived, the batch 2-4 only partly
+     REQUIRE(window.acknowledge(1, 0x9) == 2);
+     REQUIRE(window.size() == 1);
+
+     REQUIRE(window.acknowledge(4, 0) == 1);
+     REQUIRE(window.empty());
+ }
+
+ TEST_CASE("SendWindow retransmits expired datagrams and gives up eventually", "[SendWindow]") {
+     SendWindow window(2, std::chrono::milliseconds(100), 2);
+     SendWindow::Clock::time_point start = SendWindow::Clock::now();
+     uint8_t bytes[TelemetryFrame::AckSize] = {};
+     window.push(1, 1, bytes, sizeof(bytes), start);
+     REQUIRE(window.nextDeadline(start + std::chrono::seconds(1)) == start + std::chrono::milliseconds(100));
+
+     std::vector<std::size_t> sent;
+     auto send = [&](const uint8_t*, std::size_t size) { sent.push_back(size); };
+
+     REQUIRE(window.retransmitExpired(start + std::chrono::milliseconds(50), send) == 0);
+     REQUIRE(sent.empty());
+
+     REQUIRE(window.retransmitExpired(start + std::chrono::milliseconds(100), send) == 0);
+     REQUIRE(sent.size() == 1);
+     REQUIRE(sent[0] == sizeof(bytes));
+
+     // The second attempt was the last one
+     REQUIRE(window.retransmitExpired(start + std::chrono::milliseconds(200), send) == 1);
+     REQUIRE(window.empty());
+ }
+
+ TEST_CASE("TelemetryFrame round-trips an acknowledgment", "[TelemetryFrame]") {
+     uint8_t frame[TelemetryFrame::AckSize];
+     REQUIRE(TelemetryFrame::encodeAck(12, 99, 0x8000000000000001ULL, frame) == TelemetryFrame::AckSize);
+
+     int ebikeId = 0;
+     uint32_t cumulative = 0;
+     uint64_t selective = 0;
+     std::string_view message(reinterpret_cast<const char*>(frame), sizeof(frame));
+     REQUIRE(TelemetryFrame::decodeAck(message, ebikeId, cumulative, selective));
+     REQUIRE(ebikeId == 12);
+     REQUIRE(cumulative == 99);
+     REQUIRE(selective == 0x8000000000000001ULL);
+
+     REQUIRE_FALSE(TelemetryFrame::decodeAck(message.substr(0, 19), ebikeId, cumulative, selective));
+ }
+
+ TEST_CASE("SendWindow keeps new sequence numbers within the gateway's window", "[SendWindow]") {
+     SendWindow window(8, std::chrono::milliseconds(100), 10, AckTracker::WindowSize);
+     SendWindow::Clock::time_point now = SendWindow::Clock::now();
+     uint8_t bytes[4] = {};
+     REQUIRE(window.admits(AckTracker::WindowSize));
+     REQUIRE_FALSE(window.admits(AckTracker::WindowSize + 1));
+
+     window.push(1, 40, bytes, sizeof(bytes), now);
+     window.push(41, 64, bytes, sizeof(bytes), now);
+     REQUIRE_FALSE(window.admits(65));
+
+     // Only the cumulative ACK moves the limit; selective ACKs beyond a gap do not
+     window.acknowledge(0, ~uint64_t(0) << 40);
+     REQUIRE(window.size() == 1);
+     REQUIRE_FALSE(window.admits(65));
+     window.acknowledge(64, 0);
+     REQUIRE(window.empty());
+     REQUIRE(window.admits(64 + AckTracker::WindowSize));
+     REQUIRE_FALSE(window.admits(65 + AckTracker::WindowSize));
+
+     // Older acknowledgments arriving late do not pull it back; a new session does
+     window.acknowledge(10, 0);
+     REQUIRE(window.admits(128));
+     window.restartSequence();
+     REQUIRE_FALSE(window.admits(65));
+
+     // Without a limit everything is admitted
+     REQUIRE(SendWindow(1, std::chrono::milliseconds(100)).admits(1000000));
+ }
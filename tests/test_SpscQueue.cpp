@@ -0,0 +1,61 @@
+/**
+ * @file test_SpscQueue.cpp
+ * @brief Unit tests for the single-producer single-consumer queue
+ * @date October 2026
+ */
+ #define CATCH_CONFIG_MAIN
+
+ #include <catch2/catch.hpp>
+ #include <thread>
+ #include "util/SpscQueue.h"
+
+ TEST_CASE("SpscQueue is bounded and first-in first-out", "[SpscQueue]") {
+     SpscQueue<int> queue(2);
+     REQUIRE(queue.empty());
+     REQUIRE(queue.front() == nullptr);
+
+     *queue.claim() = 1;
+     queue.commit();
+     *queue.claim() = 2;
+     queue.commit();
+     REQUIRE(queue.claim() == nullptr);
+
+     REQUIRE(*queue.front() == 1);
+     queue.pop();
+     REQUIRE(*queue.front() == 2);
+     queue.pop();
+     REQUIRE(queue.empty());
+ }
+
+ TEST_CASE("SpscQueue hands every element across threads in order", "[SpscQueue]") {
+     const int count = 100000;
+     SpscQueue<int> queue(64);
+
+     std::thread producer([&queue, count] {
+         for (int i = 0; i < count; ++i) {
+             int* slot;
+             while (!(slot = queue.claim())) {
+                 std::this_thread::yield();
+             }
+             *slot = i;
+             queue.commit();
+         }
+     });
+
+     int expected = 0;
+     bool ordered = true;
+     while (expected < count) {
+         int* value = queue.front();
+         if (!value) {
+             std::this_thread::yield();
+             continue;
+         }
+         ordered = ordered && *value == expected;
+         queue.pop();
+         ++expected;
+     }
+     producer.join();
+
+     REQUIRE(ordered);
+     REQUIRE(queue.empty());
+ }
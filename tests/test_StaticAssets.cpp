@@ -0,0 +1,100 @@
+/**
+ * @file test_StaticAssets.cpp
+ * @brief Unit tests for the in-memory static file cache and entity tag matching
+ * @date October 2026
+ */
+ #define CATCH_CONFIG_MAIN
+
+ #include <catch2/catch.hpp>
+ #include <filesystem>
+ #include <fstream>
+ #include <string>
+ #include <unistd.h>
+ #include "web/StaticAssets.h"
+ #include "web/ETag.h"
+
+ /// Directory of files removed with the object
+ struct TemporaryDirectory {
+     TemporaryDirectory() : path(std::filesystem::temp_directory_path() / ("test_StaticAssets." + std::to_string(::getpid()))) {
+         std::filesystem::create_directories(path);
+     }
+
+     ~TemporaryDirectory() {
+         std::filesystem::remove_all(path);
+     }
+
+     void write(const std::string& name, const std::string& contents) {
+         std::ofstream(path / name, std::ios::binary) << contents;
+     }
+
+     std::filesystem::path path;
+ };
+
+ TEST_CASE("StaticAssets serves the files of a directory from memory", "[StaticAssets]") {
+     TemporaryDirectory directory;
+     std::string page = "<html>";
+     for (int i = 0; i < 200; ++i) {
+         page += "<p>e-bike</p>";
+     }
+     page += "</html>";
+     directory.write("map.html", page);
+     directory.write("style.css", "p{}");
+     directory.write("logo.png", std::string("\x89PNG", 4));
+     std::filesystem::create_directories(directory.path / "nested");
+
+     StaticAssets assets;
+     REQUIRE(assets.load(directory.path.string()) == 3);
+
+     // map.html stands in for the index when there is none
+     const StaticAsset* map = assets.find("/map.html");
+     REQUIRE(map);
+     REQUIRE(assets.find("/") == map);
+     REQUIRE(assets.find("/index.html?refresh=1") == map);
+     REQUIRE(map->body == page);
+     REQUIRE(map->contentType == "text/html; charset=utf-8");
+
+     // Text compresses, so a gzip form is kept, with its own ETag
+     REQUIRE_FALSE(map->gzip.empty());
+     REQUIRE(map->gzip.size() < map->body.size());
+     REQUIRE(static_cast<uint8_t>(map->gzip[0]) == 0x1f);
+     REQUIRE(map->gzipEtag != map->etag);
+
+     // Tiny or binary files are kept as they are
+     REQUIRE(assets.find("/style.css")->gzip.empty());
+     REQUIRE(assets.find("/logo.png")->contentType == "image/png");
+     REQUIRE(assets.find("/logo.png")->gzip.empty());
+
+     // Anything else is unknown, including what is not directly in the directory
+     REQUIRE(assets.find("/wp-login.php") == nullptr);
+     REQUIRE(assets.find("/nested") == nullptr);
+     REQUIRE(assets.find("/../map.html") == nullptr);
+
+     // The ETag follows the contents
+     std::string etag = map->etag;
+     directory.write("map.html", page + " ");
+     REQUIRE(assets.load(directory.path.string()) == 3);
+     REQUIRE(assets.find("/")->etag != etag);
+ }
+
+ TEST_CASE("StaticAssets tolerates a missing directory", "[StaticAssets]") {
+     StaticAssets assets;
+     REQUIRE(assets.load("/nonexistent/assets") == 0);
+     REQUIRE(assets.find("/") == nullptr);
+ }
+
+ TEST_CASE("StaticAssets finds the front end beside the executable", "[StaticAssets]") {
+     std::filesystem::path directory = StaticAssets::defaultDirectory();
+     REQUIRE(directory.is_absolute());
+     REQUIRE(directory.filename() == "html");
+     REQUIRE(directory.parent_path().filename() == "src");
+ }
+
+ TEST_CASE("If-None-Match compares entity tags weakly", "[StaticAssets]") {
+     REQUIRE(etagMatches("\"abc\"", "\"abc\""));
+     REQUIRE(etagMatches("W/\"abc\"", "\"abc\""));
+     REQUIRE(etagMatches("\"x\", \"abc\"", "\"abc\""));
+     REQUIRE(etagMatches("*", "\"abc\""));
+     REQUIRE_FALSE(etagMatches("\"abcd\"", "\"abc\""));
+     REQUIRE_FALSE(etagMatches("abc", "\"abc\""));
+     REQUIRE_FALSE(etagMatches("", "\"abc\""));
+ }
@@ -0,0 +1,106 @@
+/**
+ * @file test_TelemetryFrame.cpp
+ * @brief Unit tests for the binary telemetry wire format
+ * @date October 2026
+ */
+ #define CATCH_CONFIG_MAIN
+
+ #include <catch2/catch.hpp>
+ #include <string>
+ #include <string_view>
+ #include <vector>
+ #include "proto/TelemetryFrame.h"
+
+ static std::string_view view(const uint8_t* data, std::size_t size) {
+     return std::string_view(reinterpret_cast<const char*>(data), size);
+ }
+
+ TEST_CASE("TelemetryFrame round-trips a reading", "[TelemetryFrame]") {
+     TelemetryReading reading;
+     reading.ebikeId = 4242;
+     reading.sequence = 77;
+     reading.timestampMs = 1739359594123;
+     reading.latitudeE6 = 51459079;
+     reading.longitudeE6 = -2544360;
+
+     uint8_t frame[TelemetryFrame::ReadingSize];
+     REQUIRE(TelemetryFrame::encodeReading(reading, frame) == TelemetryFrame::ReadingSize);
+
+     // Fixed little-endian layout
+     REQUIRE(frame[0] == 0xEB);
+     REQUIRE(frame[1] == 0x1E);
+     REQUIRE(frame[2] == TelemetryFrame::Version);
+     REQUIRE(frame[4] == 0x92);
+     REQUIRE(frame[5] == 0x10);
+
+     TelemetryReading decoded;
+     REQUIRE(TelemetryFrame::decodeReading(view(frame, sizeof(frame)), decoded));
+     REQUIRE(decoded.ebikeId == 4242);
+     REQUIRE(decoded.sequence == 77);
+     REQUIRE(decoded.timestampMs == 1739359594123);
+     REQUIRE(decoded.latitudeE6 == 51459079);
+     REQUIRE(decoded.longitudeE6 == -2544360);
+ }
+
+ TEST_CASE("TelemetryFrame is distinguishable from JSON", "[TelemetryFrame]") {
+     REQUIRE_FALSE(TelemetryFrame::isFrame("{\"ebike_id\":1}"));
+     REQUIRE_FALSE(TelemetryFrame::isFrame(""));
+
+     TelemetryReading reading;
+     uint8_t frame[TelemetryFrame::ReadingSize];
+     TelemetryFrame::encodeReading(reading, frame);
+     REQUIRE(TelemetryFrame::isFrame(view(frame, sizeof(frame))));
+ }
+
+ TEST_CASE("TelemetryFrame rejects malformed frames", "[TelemetryFrame]") {
+     TelemetryReading reading;
+     uint8_t frame[TelemetryFrame::ReadingSize];
+     TelemetryFrame::encodeReading(reading, frame);
+
+     TelemetryReading decoded;
+     REQUIRE_FALSE(TelemetryFrame::decodeReading(view(frame, sizeof(frame) - 1), decoded));
+
+     frame[2] = TelemetryFrame::Version + 1;
+     REQUIRE_FALSE(TelemetryFrame::decodeReading(view(frame, sizeof(frame)), decoded));
+
+     frame[2] = TelemetryFrame::Version;
+     reading.latitudeE6 = 91000000;
+     TelemetryFrame::encodeReading(reading, frame);
+     REQUIRE_FALSE(TelemetryFrame::decodeReading(view(frame, sizeof(frame)), decoded));
+ }
+
+ TEST_CASE("TelemetryFrame round-trips a batch", "[TelemetryFrame]") {
+     TelemetryReading readings[3];
+     for (int i = 0; i < 3; ++i) {
+         readings[i].ebikeId = 9;
+         readings[i].sequence = static_cast<uint32_t>(10 + i);
+         readings[i].timestampMs = 1000 * i;
+         readings[i].latitudeE6 = 51000000 + i;
+         readings[i].longitudeE6 = -2000000 - i;
+     }
+
+     uint8_t frame[TelemetryFrame::BatchHeaderSize + 3 * TelemetryFrame::BatchEntrySize];
+     REQUIRE(TelemetryFrame::encodeBatch(9, readings, 3, frame) == sizeof(frame));
+     REQUIRE(TelemetryFrame::type(view(frame, sizeof(frame))) == TelemetryFrame::TypeBatch);
+
+     std::vector<TelemetryReading> decoded;
+     REQUIRE(TelemetryFrame::decodeBatch(view(frame, sizeof(frame)),
+                                         [&](const TelemetryReading& r) { decoded.push_back(r); }) == 3);
+     REQUIRE(decoded.size() == 3);
+     for (int i = 0; i < 3; ++i) {
+         REQUIRE(decoded[i].ebikeId == 9);
+         REQUIRE(decoded[i].sequence == readings[i].sequence);
+         REQUIRE(decoded[i].timestampMs == readings[i].timestampMs);
+         REQUIRE(decoded[i].latitudeE6 == readings[i].latitudeE6);
+         REQUIRE(decoded[i].longitudeE6 == readings[i].longitudeE6);
+     }
+
+     // A truncated batch is rejected without delivering any reading
+     decoded.clear();
+     REQUIRE(TelemetryFrame::decodeBatch(view(frame, sizeof(frame) - 1),
+                                         [&](const TelemetryReading& r) { decoded.push_back(r); }) == 0);
+     REQUIRE(decoded.empty());
+
+     REQUIRE(TelemetryFrame::batchCapacity(1400) == 69);
+     REQUIRE(TelemetryFrame::batchCapacity(10) == 1);
+ }
@@ -0,0 +1,64 @@
+/**
+ * @file test_TelemetryParser.cpp
+ * @brief Unit tests for the schema-specific telemetry parser
+ * @date October 2026
+ */
+ #define CATCH_CONFIG_MAIN
+
+ #include <catch2/catch.hpp>
+ #include <string>
+ #include "proto/TelemetryParser.h"
+
+ TEST_CASE("TelemetryParser decodes ebikeClient messages", "[TelemetryParser]") {
+     std::string message = "{\"ebike_id\":12,\"timestamp\":\"2025-02-12T11:26:34Z\","
+                           "\"gps\":{\"latitude\":51.459079,\"longitude\":-2.544360}}";
+     TelemetryReading reading;
+
+     REQUIRE(TelemetryParser::parse(message, reading));
+     REQUIRE(reading.ebikeId == 12);
+     REQUIRE(reading.timestampMs == 1739359594000);
+     REQUIRE(reading.latitudeE6 == 51459079);
+     REQUIRE(reading.longitudeE6 == -2544360);
+ }
+
+ TEST_CASE("TelemetryParser accepts whitespace and any key order", "[TelemetryParser]") {
+     std::string message = " { \"gps\" : { \"longitude\" : -2.5 , \"latitude\" : 51.25 } ,\n"
+                           "   \"timestamp\" : \"1970-01-02T00:00:01Z\" , \"ebike_id\" : 3 } ";
+     TelemetryReading reading;
+
+     REQUIRE(TelemetryParser::parse(message, reading));
+     REQUIRE(reading.ebikeId == 3);
+     REQUIRE(reading.timestampMs == 86401000);
+     REQUIRE(reading.latitudeE6 == 51250000);
+     REQUIRE(reading.longitudeE6 == -2500000);
+ }
+
+ TEST_CASE("TelemetryParser rejects anything outside the schema", "[TelemetryParser]") {
+     TelemetryReading reading;
+     const char* rejected[] = {
+         "",
+         "{}",
+         "{\"ebike_id\":1,\"timestamp\":\"2025-02-12T11:26:34Z\"}",
+         "{\"ebike_id\":1.5,\"timestamp\":\"2025-02-12T11:26:34Z\",\"gps\":{\"latitude\":1,\"longitude\":2}}",
+         "{\"ebike_id\":1,\"ebike_id\":2,\"timestamp\":\"2025-02-12T11:26:34Z\",\"gps\":{\"latitude\":1,\"longitude\":2}}",
+         "{\"ebike_id\":1,\"extra\":0,\"timestamp\":\"2025-02-12T11:26:34Z\",\"gps\":{\"latitude\":1,\"longitude\":2}}",
+         "{\"ebike_id\":1,\"timestamp\":\"2025-02-12 11:26:34\",\"gps\":{\"latitude\":1,\"longitude\":2}}",
+         "{\"ebike_id\":1,\"timestamp\":\"2025-02-12T11:26:34Z\",\"gps\":{\"latitude\":91,\"longitude\":2}}",
+         "{\"ebike_id\":1,\"timestamp\":\"2025-02-12T11:26:34Z\",\"gps\":{\"latitude\":nan,\"longitude\":2}}",
+         "{\"ebike_id\":1,\"timestamp\":\"2025-\\u0030\",\"gps\":{\"latitude\":1,\"longitude\":2}}",
+         "{\"ebike_id\":1,\"timestamp\":\"2025-02-12T11:26:34Z\",\"gps\":{\"latitude\":1,\"longitude\":2}} x",
+     };
+
+     for (const char* message : rejected) {
+         INFO(message);
+         REQUIRE_FALSE(TelemetryParser::parse(message, reading));
+     }
+ }
+
+ TEST_CASE("TelemetryParser finds the e-bike ID for routing", "[TelemetryParser]") {
+     int ebikeId = 0;
+     REQUIRE(TelemetryParser::peekEbikeId("{\"timestamp\":\"x\", \"ebike_id\" : 42}", ebikeId));
+     REQUIRE(ebikeId == 42);
+     REQUIRE_FALSE(TelemetryParser::peekEbikeId("{\"ebike\":42}", ebikeId));
+     REQUIRE_FALSE(TelemetryParser::peekEbikeId("{\"ebike_id\":\"42\"}", ebikeId));
+ }
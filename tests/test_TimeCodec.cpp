@@ -0,0 +1,71 @@
+/**
+ * @file test_TimeCodec.cpp
+ * @brief Unit tests for the ISO 8601 timestamp codec
+ * @date October 2026
+ */
+ #define CATCH_CONFIG_MAIN
+
+ #include <catch2/catch.hpp>
+ #include <string>
+ #include <string_view>
+ #include "util/TimeCodec.h"
+
+ TEST_CASE("TimeCodec parses whole and fractional seconds", "[TimeCodec]") {
+     int64_t timestampMs = 0;
+     REQUIRE(TimeCodec::parse("2025-02-12T11:26:34Z", timestampMs));
+     REQUIRE(timestampMs == 1739359594000);
+
+     REQUIRE(TimeCodec::parse("2025-02-12T11:26:34.123Z", timestampMs));
+     REQUIRE(timestampMs == 1739359594123);
+     REQUIRE(TimeCodec::parse("2025-02-12T11:26:34.5Z", timestampMs));
+     REQUIRE(timestampMs == 1739359594500);
+     REQUIRE(TimeCodec::parse("2025-02-12T11:26:34.123999Z", timestampMs));
+     REQUIRE(timestampMs == 1739359594123);
+
+     REQUIRE(TimeCodec::parse("1970-01-01T00:00:00Z", timestampMs));
+     REQUIRE(timestampMs == 0);
+     REQUIRE(TimeCodec::parse("1969-12-31T23:59:59.999Z", timestampMs));
+     REQUIRE(timestampMs == -1);
+ }
+
+ TEST_CASE("TimeCodec rejects malformed timestamps", "[TimeCodec]") {
+     int64_t timestampMs = 0;
+     const char* rejected[] = {
+         "",
+         "2025-02-12 11:26:34Z",
+         "2025-02-12T11:26:34",
+         "2025-13-12T11:26:34Z",
+         "2025-02-12T24:00:00Z",
+         "2025-02-12T11:26:34.Z",
+         "2025-02-12T11:26:34,123Z",
+         "2025-02-12T11:26:34.12aZ",
+     };
+     for (const char* text : rejected) {
+         INFO(text);
+         REQUIRE_FALSE(TimeCodec::parse(text, timestampMs));
+     }
+ }
+
+ TEST_CASE("TimeCodec formats and round-trips timestamps", "[TimeCodec]") {
+     char buffer[TimeCodec::MillisSize];
+     REQUIRE(std::string(buffer, TimeCodec::formatSeconds(1739359594123, buffer)) == "2025-02-12T11:26:34Z");
+     REQUIRE(std::string(buffer, TimeCodec::formatMillis(1739359594123, buffer)) == "2025-02-12T11:26:34.123Z");
+     REQUIRE(std::string(buffer, TimeCodec::formatMillis(-1, buffer)) == "1969-12-31T23:59:59.999Z");
+     REQUIRE(std::string(buffer, TimeCodec::formatMillis(951782400000, buffer)) == "2000-02-29T00:00:00.000Z");
+
+     // Every day over several leap cycles survives a round trip
+     for (int64_t timestampMs = -2208988800000; timestampMs < 4102444800000; timestampMs += 86399999) {
+         int64_t parsed = 0;
+         REQUIRE(TimeCodec::parse(std::string_view(buffer, TimeCodec::formatMillis(timestampMs, buffer)), parsed));
+         REQUIRE(parsed == timestampMs);
+     }
+ }
+
+ TEST_CASE("TimeCodec cached formatting matches the uncached formatter", "[TimeCodec]") {
+     char buffer[TimeCodec::MillisSize];
+     const int64_t timestamps[] = {1739359594123, 1739359594999, 1739359595000, 1739359594001, 0};
+     for (int64_t timestampMs : timestamps) {
+         std::string expected(buffer, TimeCodec::formatMillis(timestampMs, buffer));
+         REQUIRE(std::string(TimeCodec::formatCached(timestampMs)) == expected);
+     }
+ }